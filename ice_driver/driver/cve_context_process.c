@@ -130,6 +130,10 @@ int cve_context_process_destroy(
 			"Destroy context_pid %lld\n",
 			context_pid);
 
+	if (context_process->cring)
+		ice_os_free_user_shared(context_process->cring,
+				context_process->cring_size);
+
 	OS_FREE(context_process, sizeof(*context_process));
 
 	/* success */
@@ -163,3 +167,136 @@ int cve_context_process_get(
 out:
 	return retval;
 }
+
+int cve_context_process_config_cring(
+		cve_context_process_id_t context_pid,
+		struct ice_completion_ring_params *params)
+{
+	struct cve_context_process *context_process = NULL;
+	u32 num_entries = params->num_entries;
+	u32 sz;
+	int retval = cve_os_lock(&g_cve_driver_biglock, CVE_INTERRUPTIBLE);
+
+	if (retval != 0) {
+		retval = -ERESTARTSYS;
+		goto out;
+	}
+
+	context_process = context_process_get(context_pid);
+	if (!context_process) {
+		retval = -ICEDRV_KERROR_INVALID_DRV_HANDLE;
+		goto unlock;
+	}
+
+	if (num_entries == 0) {
+		/* Memory may still be mapped by user, released on close */
+		context_process->cring_enabled = 0;
+		params->size_bytes = 0;
+		params->ring_addr = 0;
+		goto unlock;
+	}
+
+	if ((num_entries & (num_entries - 1)) ||
+		num_entries > ICE_MAX_COMPLETION_RING_ENTRIES) {
+		retval = -EINVAL;
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"ERROR:%d Invalid completion ring size %u\n",
+				retval, num_entries);
+		goto unlock;
+	}
+
+	sz = sizeof(struct ice_completion_ring_header) +
+		num_entries * sizeof(struct cve_get_event);
+
+	if (context_process->cring) {
+		/* Ring cannot be resized once it may have been mapped */
+		if (context_process->cring_entries != num_entries) {
+			retval = -ICEDRV_KERROR_DUPLICATE_REQUEST;
+			cve_os_log(CVE_LOGLEVEL_ERROR,
+					"ERROR:%d Completion ring already configured with %u entries\n",
+					retval,
+					context_process->cring_entries);
+			goto unlock;
+		}
+	} else {
+		retval = ice_os_alloc_user_shared(sz,
+				(void **)&context_process->cring);
+		if (retval < 0) {
+			cve_os_log(CVE_LOGLEVEL_ERROR,
+					"ERROR:%d Completion ring allocation failed\n",
+					retval);
+			goto unlock;
+		}
+		context_process->cring_size = sz;
+		context_process->cring_entries = num_entries;
+		context_process->cring_mask = num_entries - 1;
+		context_process->cring_head = 0;
+		context_process->cring_fallback = 0;
+		context_process->cring->num_entries = num_entries;
+	}
+
+	context_process->cring_enabled = 1;
+	params->size_bytes = context_process->cring_size;
+	params->ring_addr = (u64)(uintptr_t)context_process->cring;
+
+	cve_os_log(CVE_LOGLEVEL_DEBUG,
+			"Completion ring enabled. Entries=%u Size=%u\n",
+			num_entries, context_process->cring_size);
+
+unlock:
+	cve_os_unlock(&g_cve_driver_biglock);
+out:
+	return retval;
+}
+
+bool cve_context_process_post_cring(
+		struct cve_context_process *context_process,
+		struct cve_get_event *entry)
+{
+	struct ice_completion_ring_header *hdr = context_process->cring;
+	struct cve_get_event *slots;
+	u32 head, tail;
+
+	if (!hdr || !context_process->cring_enabled)
+		return false;
+
+	/*
+	 * Only tail is read from the header. It is owned by user and never
+	 * trusted beyond a sanity check, slots are indexed with the private
+	 * head and mask.
+	 */
+	cve_os_memory_barrier();
+	head = context_process->cring_head;
+	tail = hdr->tail;
+	if ((u32)(head - tail) >= context_process->cring_entries) {
+		hdr->fallback_count = ++context_process->cring_fallback;
+		return false;
+	}
+
+	slots = (struct cve_get_event *)(hdr + 1);
+	slots[head & context_process->cring_mask] = *entry;
+
+	/* Entry must be visible before the new head */
+	cve_os_memory_barrier();
+	context_process->cring_head = head + 1;
+	hdr->head = head + 1;
+
+	return true;
+}
+
+bool cve_context_process_has_events(
+		struct cve_context_process *context_process)
+{
+	struct ice_completion_ring_header *hdr = context_process->cring;
+
+	if (context_process->alloc_events)
+		return true;
+
+	if (hdr && context_process->cring_enabled) {
+		cve_os_memory_barrier();
+		if (context_process->cring_head != hdr->tail)
+			return true;
+	}
+
+	return false;
+}
@@ -49,4 +49,32 @@ int cve_context_process_get(
 		cve_context_process_id_t context_pid,
 		struct cve_context_process **out_process_context);
 
+/*
+ * Enable, disable or query the mmap-able completion ring of the process.
+ * Ring memory lives until the process context is destroyed.
+ * inputs :
+ *	context_pid - process context id
+ *	params - see ice_completion_ring_params
+ * returns: 0 on success, negative error code otherwise
+ */
+int cve_context_process_config_cring(
+		cve_context_process_id_t context_pid,
+		struct ice_completion_ring_params *params);
+
+/*
+ * Post a completion to the ring. Must be called with biglock held.
+ * returns: false if ring is disabled or full, caller must fall back to
+ * the event list
+ */
+bool cve_context_process_post_cring(
+		struct cve_context_process *context_process,
+		struct cve_get_event *entry);
+
+/*
+ * returns: true if an event is available either in the ring or in the
+ * event list
+ */
+bool cve_context_process_has_events(
+		struct cve_context_process *context_process);
+
 #endif /* DRIVER_CVE_CONTEXT_PROCESS_H_ */
@@ -24,6 +24,8 @@
 #include "ice_sw_counters.h"
 #include "icedrv_internal_sw_counter_funcs.h"
 #include "ice_debug_event.h"
+#include "ice_dma_pool.h"
+#include "ice_pm_governor.h"
 
 
 int cve_device_init(struct cve_device *dev, int index, u64 pe_value)
@@ -48,7 +50,9 @@ int cve_device_init(struct cve_device *dev, int index, u64 pe_value)
 	}
 
 
-	dev->interrupts_status = 0;
+	atomic_set(&dev->isr_q_head, 0);
+	atomic_set(&dev->isr_q_tail, 0);
+	atomic_set(&dev->isr_q_overflow, 0);
 
 	dev->di_cve_needs_reset = 0;
 
@@ -85,6 +89,9 @@ int cve_device_init(struct cve_device *dev, int index, u64 pe_value)
 		goto out;
 	}
 
+	/* failing to prefill only costs allocations at network creation */
+	ice_dma_pool_init(dev);
+
 	/* Init platform specific data*/
 	retval = init_platform_data(dev);
 	if (retval != 0) {
@@ -131,6 +138,8 @@ int cve_device_init(struct cve_device *dev, int index, u64 pe_value)
 	ice_swc_counter_set(dev->hswc, ICEDRV_SWC_DEVICE_COUNTER_POWER_STATE,
 		ice_dev_get_power_state(dev));
 
+	ice_pm_gov_init(dev);
+
 	getnstimeofday(&dev->idle_start_time);
 	ice_swc_counter_set(dev->hswc,
 		ICEDRV_SWC_DEVICE_COUNTER_IDLE_START_TIME,
@@ -151,6 +160,7 @@ int cve_device_init(struct cve_device *dev, int index, u64 pe_value)
 	return 0;
 
 init_platform_data_failed:
+	ice_dma_pool_fini(dev);
 	/* cleanup fw binaries */
 	cve_fw_unload(dev, dev->fw_loaded_list);
 out:
@@ -187,6 +197,9 @@ void cve_device_clean(struct cve_device *dev)
 
 	project_hook_free_cve_dump_buffer(dev);
 
+	/* networks are gone, release the recycled DMA buffers */
+	ice_dma_pool_fini(dev);
+
 }
 
 enum ICE_POWER_STATE ice_dev_get_power_state(struct cve_device *dev)
@@ -23,6 +23,9 @@
 #include "doubly_linked_list.h"
 #include "cve_fw_structs.h"
 #include "project_settings.h"
+#include "ice_pm_governor.h"
+#include "ice_exec_stats.h"
+#include "ice_pmon_ring.h"
 
 #define INVALID_INDEX -1
 #define INVALID_ENTRY 255
@@ -33,6 +36,8 @@
 #define INVALID_NETWORK_ID 0
 #define ICE_MAX_PMON_CONFIG 32
 #define ICE_MAX_MMU_PMON 10
+/* ATU0-3 TLB miss counters lead the MMU PMON list */
+#define ICE_MMU_PMON_ATU_MISSES_NR 4
 #define ICE_MAX_DELPHI_PMON 10
 #define ICE_MAX_A_STEP_DELPHI_PMON 2
 #define EXE_ORDER_MAX 0xFFFFFFFFFFFFFFFF
@@ -203,7 +208,19 @@ struct ice_perf_counter_config {
 struct ice_pmon_config {
 	const char *pmon_name;
 	u32 pmon_value;
+	/* value at the previous dump, used to report deltas */
+	u32 pmon_prev_value;
 };
+/* size of the per ICE interrupt status queue */
+#define ICE_ISR_Q_SZ 8
+
+/* interrupt status of an ICE, queued by the ISR for the deferred handler */
+struct ice_isr_status {
+	u32 status;
+	/* To discard outdated interrupts and keep arrival order */
+	struct timespec cur_ts;
+};
+
 struct cve_device {
 	/* device index */
 	u32 dev_index;
@@ -215,13 +232,20 @@ struct cve_device {
 	struct cve_dle_t poweroff_list;
 	/* Timestamp of when Power Off request was raised */
 	struct timespec poweroff_ts;
+	/* Idle period history deciding the power off delay */
+	struct ice_pm_gov pm_gov;
 	/* Pointer to FIFO Descriptor of current Network */
 	struct fifo_descriptor *fifo_desc;
 	struct di_cve_dump_buffer cve_dump_buf;
 	/* ice dump buffer descriptor - for GET_ICE_DUMP_NOW debug control*/
 	struct di_cve_dump_buffer debug_control_buf;
 	u32 di_cve_needs_reset;
-	u32 interrupts_status;
+	/* interrupt statuses in arrival order, filled by the ISR */
+	struct ice_isr_status isr_q[ICE_ISR_Q_SZ];
+	atomic_t isr_q_head;
+	atomic_t isr_q_tail;
+	/* statuses ORed by the ISR while isr_q is full */
+	atomic_t isr_q_overflow;
 	struct cve_version_info version_info;
 	void *platform_data;
 	/* list of loaded fw sections */
@@ -238,6 +262,8 @@ struct cve_device {
 	enum ICE_POWER_STATE power_state;
 	/* last network id that ran on this device */
 	cve_network_id_t dev_ntw_id;
+	/* page directory currently programmed in the MMU, 0 if none */
+	u32 pd_base_addr;
 	/* are hw counters enabled */
 	u32 is_hw_counters_enabled;
 	/* ice freq value */
@@ -278,6 +304,8 @@ struct cve_device {
 	bool in_free_pool;
 	struct ice_pmon_config mmu_pmon[ICE_MAX_MMU_PMON];
 	struct ice_pmon_config delphi_pmon[ICE_MAX_DELPHI_PMON];
+	/* PMONs are sampled for the job running on this ICE */
+	bool pmon_sampling;
 };
 struct llc_pmon_config {
 	/*LLC PMON config reg 0 value */
@@ -407,8 +435,6 @@ struct cve_device_group {
 	struct cve_hw_cntr_descriptor *base_addr_hw_cntr;
 	/* number of counters in free pool */
 	u16 num_avl_cntr;
-	/* number of non-reserved counters */
-	u16 num_nonres_cntr;
 	/* Pool to Context ID mapping */
 	u64 pool_context_map[MAX_IDC_POOL_NR];
 	/* number of pool in free pool */
@@ -641,6 +667,8 @@ struct ice_pp_value {
 	u64 *pp_address;
 	/* This value will be stored at pp_address */
 	u64 pp_value;
+	/* Set if the value is written to a per Infer copy of the CB */
+	u8 in_cb_copy;
 };
 
 struct dev_alloc {
@@ -723,7 +751,7 @@ struct execution_node {
 	/* This flag is bypassed when resources are reserved */
 	bool ready_to_run;
 	/* INFERENCE nodes are also added to ntw->sch_queue */
-	/* Is this inference queued */
+	/* Is this inference queued, also kept for RESERVE/RELEASE */
 	bool is_queued;
 	/* ------------------- */
 
@@ -733,6 +761,10 @@ struct execution_node {
 	/* Ntw with which this node is associated */
 	struct ice_network *ntw;
 	bool is_success;
+	/* RESERVE nodes wait in a queue of their own */
+	struct cve_dle_t res_list;
+	/* when the RESERVE node was queued, bounds its wait */
+	struct timespec queued_ts;
 	/* ------------------------- */
 
 };
@@ -793,6 +825,8 @@ struct ice_network {
 	struct cve_dle_t resource_list;
 	/* Indicates if this Network needs to reserve the resources */
 	bool res_resource;
+	/* Returned resources are kept until reused or needed elsewhere */
+	bool sticky_resource;
 	struct cve_device *ice_list;
 	struct cve_hw_cntr_descriptor *cntr_list;
 	/****************************************/
@@ -855,6 +889,14 @@ struct ice_network {
 	enum ice_network_type network_type;
 	u8 max_shared_distance;
 	u8 shared_read;
+	/* WAIT_FOR_EVENT polls for completion before sleeping */
+	u8 hybrid_poll;
+	/* run time of an Infer, i.e. of its slowest ICE */
+	struct ice_exec_stats exec_stats;
+	/* run time of the jobs of an Infer per ICE, indexed by dev_index */
+	struct ice_exec_stats ice_exec_stats[MAX_CVE_DEVICES_NR];
+	/* PMON samples of the Infers, NULL while sampling is off */
+	struct ice_pmon_ring *pmon_ring;
 	/* Last Infer that was executed */
 	struct ice_infer *curr_exe;
 	/* List of all Infer created against this Ntw */
@@ -870,9 +912,16 @@ struct ice_network {
 	/* Infer buffer patch points */
 	struct ice_pp_copy *ntw_surf_pp_list;
 	u32 ntw_surf_pp_count;
+	/* Infer whose patch point values are currently written in CBs */
+	struct ice_infer *last_patched_inf;
 
 	u64 ntw_icemask;
 	u64 ntw_cntrmask;
+	/* power balancer weight per ICE, higher is better, 0 if not
+	 * recommended. Taken once when the ICEs are captured
+	 */
+	u8 ice_place_rank[MAX_CVE_DEVICES_NR];
+	bool ice_place_ranked;
 
 	/* ------------------------- */
 	/* Exclusively for scheduler */
@@ -906,6 +955,23 @@ struct ice_network {
 	u8 exIR_performed;
 };
 
+/* Per Infer copy of a network CB which holds Infer patch points */
+struct ice_inf_cb_copy {
+	/* link to the Infer's list of CB copies */
+	struct cve_dle_t list;
+	/* network CB from which this copy was created */
+	struct cve_ntw_buffer *ntw_buf;
+	/* ICEVA of the network CB */
+	ice_va_t orig_iova;
+	/* ICEVA of the copy */
+	ice_va_t copy_iova;
+	u32 size_bytes;
+	/* kernel VA of the copy */
+	void *vaddr;
+	struct cve_dma_handle dma_handle;
+	cve_mm_allocation_t alloc;
+};
+
 struct ice_infer {
 	/* Infer Id */
 	u64 infer_id;
@@ -940,6 +1006,8 @@ struct ice_infer {
 	void *inf_hdom[MAX_CVE_DEVICES_NR];
 	/* InferBuffer patch point array */
 	struct ice_pp_value *inf_pp_arr;
+	/* CB copies patched for this Infer, NULL if not enabled */
+	struct ice_inf_cb_copy *cb_copy_list;
 
 	/************************/
 	/* SW Counter handle */
@@ -966,6 +1034,8 @@ struct cve_ntw_buffer {
 	/* If positive, then this is InferBuffer. Index in Infer list. */
 	u64 index_in_inf;
 	u8 dump;
+	/* CB holds counter patch points, patched at every dispatch */
+	u8 has_cntr_pp;
 };
 
 struct cve_inf_buffer {
@@ -1042,6 +1112,20 @@ struct cve_context_process {
 	struct cve_completion_event *events;
 	/* list of allocated event nodes */
 	struct cve_completion_event *alloc_events;
+	/* mmap-able completion ring, NULL if never configured */
+	struct ice_completion_ring_header *cring;
+	/* size of cring allocation in bytes */
+	u32 cring_size;
+	/*
+	 * Private copies of the ring layout and of head. The header is
+	 * writable by user so slots are only indexed with these.
+	 */
+	u32 cring_entries;
+	u32 cring_mask;
+	u32 cring_head;
+	u32 cring_fallback;
+	/* events are posted to cring only when set */
+	u8 cring_enabled;
 };
 
 struct cve_completion_event {
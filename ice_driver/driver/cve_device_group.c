@@ -47,7 +47,12 @@ static struct ice_drv_config drv_config_param = {
 	.initial_iccp_config[0] = INITIAL_CDYN_VAL,
 	.initial_iccp_config[1] = RESET_CDYN_VAL,
 	.initial_iccp_config[2] = BLOCKED_CDYN_VAL,
-	.enable_mmu_pmon = 0
+	.enable_mmu_pmon = 0,
+	.enable_inf_cb_copy = 0,
+	.enable_large_page_promotion = 1,
+	.pin_cache_max_entries = 256,
+	.enable_adaptive_power_off = 1,
+	.enable_sticky_resource = 1
 };
 
 
@@ -84,7 +89,6 @@ static int cve_dg_add_hw_counter(struct cve_device_group *p)
 		(uintptr_t)p, (uintptr_t)&hw_cntr_list[i]);
 	}
 	p->num_avl_cntr = NUM_COUNTER_REG;
-	p->num_nonres_cntr = NUM_COUNTER_REG;
 	p->base_addr_hw_cntr = hw_cntr_list;
 	/* indicate success */
 	retval = 0;
@@ -110,7 +114,6 @@ static void cve_dg_remove_hw_counter(struct cve_device_group *p)
 
 	p->hw_cntr_list = NULL;
 	p->num_avl_cntr = 0;
-	p->num_nonres_cntr = 0;
 }
 
 static int __add_icebo_list(struct cve_device_group *dg)
@@ -288,12 +291,12 @@ static int ice_pm_monitor_task(void *data)
 #endif
 {
 	int ret = 0, wq_status;
-	u32 icemask;
-	u32 configured_timeout_ms = (u32)ice_get_power_off_delay_param();
+	u32 icemask, pending_nr;
+	u32 elapsed_msec, delay_msec;
 	u32 time_60sec = 60000;
 	u32 timeout_msec = time_60sec;
 	struct timespec curr_ts, out_ts;
-	struct cve_device *head;
+	struct cve_device *head, *dev, *next;
 	struct cve_device_group *device_group = (struct cve_device_group *)data;
 	const struct sphpb_callbacks *sphpb_cbs;
 #ifdef RING3_VALIDATION
@@ -338,32 +341,56 @@ static int ice_pm_monitor_task(void *data)
 			goto out_null_list;
 
 		icemask = 0;
-		timeout_msec = __timespec_diff(&curr_ts,
-					 &head->poweroff_ts, &out_ts);
+		timeout_msec = time_60sec;
 
-		while (timeout_msec >= configured_timeout_ms) {
+		/*
+		 * Each ICE is queued with its own power off delay, so the
+		 * whole list is scanned. Count first as entries are removed
+		 * while walking it.
+		 */
+		pending_nr = 0;
+		dev = head;
+		do {
+			pending_nr++;
+			dev = cve_dle_next(dev, poweroff_list);
+		} while (dev != head);
+
+		dev = head;
+		while (pending_nr--) {
+			next = cve_dle_next(dev, poweroff_list);
+
+			elapsed_msec = __timespec_diff(&curr_ts,
+						&dev->poweroff_ts, &out_ts);
+			delay_msec = dev->pm_gov.armed_delay_ms;
+			if (elapsed_msec < delay_msec) {
+				if (delay_msec - elapsed_msec < timeout_msec)
+					timeout_msec = delay_msec -
+							elapsed_msec;
+				dev = next;
+				continue;
+			}
 
 			/*
 			 * power_state must be ICE_POWER_OFF_INITIATED.
 			 * If someone turns it on then it is their
 			 * responsibility to remove it from this list.
 			 */
-			ASSERT(head->power_state == ICE_POWER_OFF_INITIATED);
+			ASSERT(dev->power_state == ICE_POWER_OFF_INITIATED);
 
-			icemask |= (1 << head->dev_index);
-			ice_dev_set_power_state(head, ICE_POWER_OFF);
-			ice_swc_counter_set(head->hswc,
+			icemask |= (1 << dev->dev_index);
+			ice_dev_set_power_state(dev, ICE_POWER_OFF);
+			ice_swc_counter_set(dev->hswc,
 				ICEDRV_SWC_DEVICE_COUNTER_POWER_STATE,
-				ice_dev_get_power_state(head));
+				ice_dev_get_power_state(dev));
 
 			sphpb_cbs = device_group->sphpb.sphpb_cbs;
 			if (sphpb_cbs && sphpb_cbs->set_power_state) {
 				ret = sphpb_cbs->set_power_state(
-						head->dev_index, false);
+						dev->dev_index, false);
 				if (ret) {
 					cve_os_dev_log(
 						CVE_LOGLEVEL_ERROR,
-						head->dev_index,
+						dev->dev_index,
 						"failed setting OFF power state OFF with power balancer (%d)\n",
 						ret);
 				}
@@ -372,15 +399,11 @@ static int ice_pm_monitor_task(void *data)
 			cve_dle_remove_from_list(
 				device_group->poweroff_dev_list,
 				poweroff_list,
-				head);
+				dev);
 
-			head = device_group->poweroff_dev_list;
-			if (!head)
-				break;
-
-			timeout_msec = __timespec_diff(&curr_ts,
-						&head->poweroff_ts, &out_ts);
+			dev = next;
 		}
+		head = device_group->poweroff_dev_list;
 
 		if (icemask)
 			unset_idc_registers_multi(icemask, false);
@@ -390,9 +413,7 @@ out_null_list:
 		device_group->start_poweroff_thread = 0;
 		cve_os_unlock(&device_group->poweroff_dev_list_lock);
 
-		if (head)
-			timeout_msec = (configured_timeout_ms - timeout_msec);
-		else {
+		if (!head) {
 			timeout_msec = time_60sec;
 
 			if (terminate_thread(device_group))
@@ -791,9 +812,17 @@ void ice_set_driver_config_param(struct ice_drv_config *param)
 	drv_config_param.initial_iccp_config[1] = param->initial_iccp_config[1];
 	drv_config_param.initial_iccp_config[2] = param->initial_iccp_config[2];
 	drv_config_param.enable_mmu_pmon = param->enable_mmu_pmon;
+	drv_config_param.enable_inf_cb_copy = param->enable_inf_cb_copy;
+	drv_config_param.enable_large_page_promotion =
+			param->enable_large_page_promotion;
+	drv_config_param.pin_cache_max_entries = param->pin_cache_max_entries;
+	drv_config_param.enable_adaptive_power_off =
+			param->enable_adaptive_power_off;
+	drv_config_param.enable_sticky_resource =
+			param->enable_sticky_resource;
 
 	cve_os_log(CVE_LOGLEVEL_INFO,
-			"DriverConfig: enable_llc_config_via_axi_reg:%d sph_soc:%d ice_power_off_delay_ms:%d, is_b_step_enabled: %d is_c_step_enabled: %d Preemption:%d is_iccp_throttling_enabled:%d initial_cdyn:0x%x reset_cdyn:0x%x blocked_cdyn:0x%x MmuPmon:%d\n",
+			"DriverConfig: enable_llc_config_via_axi_reg:%d sph_soc:%d ice_power_off_delay_ms:%d, is_b_step_enabled: %d is_c_step_enabled: %d Preemption:%d is_iccp_throttling_enabled:%d initial_cdyn:0x%x reset_cdyn:0x%x blocked_cdyn:0x%x MmuPmon:%d InfCbCopy:%d LargePagePromotion:%d PinCacheMaxEntries:%u AdaptivePowerOff:%d StickyResource:%d\n",
 			drv_config_param.enable_llc_config_via_axi_reg,
 			drv_config_param.sph_soc,
 			drv_config_param.ice_power_off_delay_ms,
@@ -804,7 +833,12 @@ void ice_set_driver_config_param(struct ice_drv_config *param)
 			drv_config_param.initial_iccp_config[0],
 			drv_config_param.initial_iccp_config[1],
 			drv_config_param.initial_iccp_config[2],
-			drv_config_param.enable_mmu_pmon);
+			drv_config_param.enable_mmu_pmon,
+			drv_config_param.enable_inf_cb_copy,
+			drv_config_param.enable_large_page_promotion,
+			drv_config_param.pin_cache_max_entries,
+			drv_config_param.enable_adaptive_power_off,
+			drv_config_param.enable_sticky_resource);
 }
 
 struct ice_drv_config *ice_get_driver_config_param(void)
@@ -901,6 +935,31 @@ u8 ice_dump_mmu_pmon(void)
 	return drv_config_param.enable_mmu_pmon;
 }
 
+u8 ice_enable_inf_cb_copy(void)
+{
+	return drv_config_param.enable_inf_cb_copy;
+}
+
+u8 ice_enable_large_page_promotion(void)
+{
+	return drv_config_param.enable_large_page_promotion;
+}
+
+u32 ice_get_pin_cache_max_entries(void)
+{
+	return drv_config_param.pin_cache_max_entries;
+}
+
+u8 ice_enable_adaptive_power_off(void)
+{
+	return drv_config_param.enable_adaptive_power_off;
+}
+
+u8 ice_enable_sticky_resource(void)
+{
+	return drv_config_param.enable_sticky_resource;
+}
+
 void ice_dg_adjust_ntw_ice_req(struct ice_network *ntw)
 {
 	struct cve_device_group *dg = cve_dg_get();
@@ -983,13 +1042,13 @@ enum resource_status ice_dg_check_resource_availability(struct ice_network *ntw)
 
 	}
 
+	/*
+	 * Counters are never reserved, only running Ntws and idle Ntws
+	 * keeping their resources hold them, so a shortfall is temporary
+	 */
 	__local_builtin_popcount(ntw->cntr_bitmap, count);
-	if (count <= dg->num_avl_cntr)
-		tmp_status = tmp_status;
-	else if (count <= dg->num_nonres_cntr)
+	if (count > dg->num_avl_cntr)
 		tmp_status = RESOURCE_BUSY;
-	else
-		goto out;
 
 	status = tmp_status;
 
@@ -1051,12 +1110,16 @@ void ice_dg_borrow_this_ice(struct ice_network *ntw,
 	dev->in_free_pool = false;
 
 	if (dev->power_state == ICE_POWER_OFF_INITIATED) {
+		struct timespec curr_ts;
 
 		ice_dev_set_power_state(dev, ICE_POWER_ON);
 
 		cve_dle_remove_from_list(dg->poweroff_dev_list,
 			poweroff_list, dev);
 
+		getnstimeofday(&curr_ts);
+		ice_pm_gov_idle_end(dev, &curr_ts, false);
+
 		ice_swc_counter_set(dev->hswc,
 			ICEDRV_SWC_DEVICE_COUNTER_POWER_STATE,
 			ice_dev_get_power_state(dev));
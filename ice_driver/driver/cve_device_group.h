@@ -45,6 +45,11 @@ struct ice_drv_config {
 	u8 iccp_throttling;
 	u32 initial_iccp_config[3];
 	u8 enable_mmu_pmon;
+	u8 enable_inf_cb_copy;
+	u8 enable_large_page_promotion;
+	u32 pin_cache_max_entries;
+	u8 enable_adaptive_power_off;
+	u8 enable_sticky_resource;
 };
 
 /*
@@ -169,6 +174,21 @@ int ice_check_b_or_c_step_enable_flag(void);
 /* check if user has requested to disable preemption*/
 u8 ice_sch_allow_preemption(void);
 
+/* check if CBs with Infer patch points are copied per Infer */
+u8 ice_enable_inf_cb_copy(void);
+
+/* check if contiguous buffers may be promoted to large page partitions */
+u8 ice_enable_large_page_promotion(void);
+
+/* max number of user buffers kept pinned after use, 0 if disabled */
+u32 ice_get_pin_cache_max_entries(void);
+
+/* check if power off delays are chosen from the ICE idle history */
+u8 ice_enable_adaptive_power_off(void);
+
+/* check if returned resources stay with the Ntw until needed elsewhere */
+u8 ice_enable_sticky_resource(void);
+
 /*check if user has requested to do non throttling for B step*/
 int ice_get_iccp_throttling_flag(void);
 
@@ -364,7 +364,10 @@ struct ice_network_descriptor {
 	struct cve_job_group *jg_desc_list;
 	/* Number of entries in above list */
 	__u32 num_jg_desc;
-	/* Completion event required*/
+	/* bits 0-23: completion event required if non zero
+	 * bits 24-30: reserved, must be zero
+	 * bit 31: ICE_NTW_FLAG_HYBRID_POLL
+	 */
 	__u32 produce_completion;
 	/* out, job group id */
 	__u64 network_id;
@@ -377,6 +380,16 @@ struct ice_network_descriptor {
 	__u64 infer_buf_page_config[ICEDRV_PAGE_ALIGNMENT_MAX];
 };
 
+/*
+ * Flags carried in the top byte of ice_network_descriptor.produce_completion
+ * ICE_NTW_FLAG_HYBRID_POLL - spin in WAIT_FOR_EVENT for the expected run
+ * time of an Infer before sleeping, for networks running well below 1 msec
+ * Any other bit of ICE_NTW_FLAGS_AREA fails network creation with -EINVAL
+ */
+#define ICE_NTW_FLAG_HYBRID_POLL (1U << 31)
+#define ICE_NTW_FLAGS_MASK ICE_NTW_FLAG_HYBRID_POLL
+#define ICE_NTW_FLAGS_AREA (0xFFU << 24)
+
 struct ice_infer_descriptor {
 	/** Object id from user for sw counters
 	 *  Can be negative if driver generated ID to be used
@@ -435,6 +448,21 @@ struct cve_execute_infer {
 	struct ice_execute_infer_data data;
 };
 
+/* Max entries accepted by batched ExecuteInfer and WaitForEvent */
+#define ICE_MAX_BATCH_ENTRIES 256
+
+/*
+ * parameter for IOCTL-execute-infer-batch
+ */
+struct ice_execute_infer_batch {
+	/*in, user pointer to array of cve_execute_infer */
+	__u64 infers;
+	/*in, number of entries in infers array */
+	__u32 num_infers;
+	/*out, number of leading entries that were queued */
+	__u32 num_queued;
+};
+
 /*
  * parameter for IOCTL-destroy_infer
  */
@@ -614,6 +642,64 @@ struct cve_get_event {
 	enum ice_error_severity err_severity;
 };
 
+/*
+ * parameter for IOCTL-wait-for-event-batch
+ */
+struct ice_wait_event_batch {
+	/* in, id of the context */
+	__u64 contextid;
+	/*in, timeout in milliseconds for the first event */
+	__u32 timeout_msec;
+	/*in, max entries in events array */
+	__u32 max_events;
+	/*in, user pointer to array of cve_get_event */
+	__u64 events;
+	/*out, number of entries written to events array */
+	__u32 num_events;
+	/* out, wait status*/
+	enum cve_wait_event_status wait_status;
+};
+
+/*
+ * Completion ring shared with user space through mmap on the driver fd.
+ * Layout: one ice_completion_ring_header followed by num_entries
+ * cve_get_event, filled as by CVE_IOCTL_WAIT_FOR_EVENT. Kernel is the
+ * only producer and advances head after the entry is written. User is
+ * the only consumer and advances tail after the entry is read. Both
+ * indices are free running, slot = index & (num_entries - 1).
+ * When the ring is full the event falls back to the regular
+ * CVE_IOCTL_WAIT_FOR_EVENT path and fallback_count is incremented.
+ * poll()/epoll() on the fd reports POLLIN when either path has events.
+ * While the ring is enabled, CVE_IOCTL_WAIT_FOR_EVENT (per Infer or per
+ * context) and ICE_IOCTL_WAIT_FOR_EVENT_BATCH fail with -EINVAL unless
+ * fallback events are pending. num_entries is informational, changing
+ * it has no effect on the kernel.
+ */
+#define ICE_MAX_COMPLETION_RING_ENTRIES 4096
+
+struct ice_completion_ring_header {
+	/* written by kernel */
+	__u32 head;
+	/* written by user */
+	__u32 tail;
+	/* power of 2 */
+	__u32 num_entries;
+	/* events delivered via WAIT_FOR_EVENT because ring was full */
+	__u32 fallback_count;
+};
+
+/*
+ * parameter for IOCTL-completion-ring
+ */
+struct ice_completion_ring_params {
+	/*in, ring size in entries (power of 2), 0 to disable */
+	__u32 num_entries;
+	/*out, bytes to be mapped with mmap at offset 0 */
+	__u32 size_bytes;
+	/*out, ring address. Valid only in simulation mode */
+	__u64 ring_addr;
+};
+
 /*
  * parameter for IOCTL-get-version
  */
@@ -816,6 +902,74 @@ struct ice_reset_network_params {
 	__u64 networkid;
 };
 
+#define ICE_PMON_SAMPLE_MMU_NR 10
+#define ICE_PMON_SAMPLE_DELPHI_NR 10
+
+/* PMON values of one ICE at the end of an Infer of a sampled network */
+struct ice_pmon_sample {
+	/* id of the Infer */
+	__u64 infer_id;
+	/* execution time of the ICE, in cycles */
+	__u64 exec_cycles;
+	__u32 ice_id;
+	/* raw values, MMU PMONs count from the last ICE reset */
+	__u32 mmu_pmon[ICE_PMON_SAMPLE_MMU_NR];
+	__u32 delphi_pmon[ICE_PMON_SAMPLE_DELPHI_NR];
+	/* keeps the size a multiple of 8, always 0 */
+	__u32 reserved;
+};
+
+enum ice_pmon_sampling {
+	/* leave the sampling state as is */
+	ICE_PMON_SAMPLING_KEEP,
+	ICE_PMON_SAMPLING_START,
+	ICE_PMON_SAMPLING_STOP
+};
+
+/*
+ * parameter for IOCTL-pmon-samples
+ * While sampling is on, a sample is taken from every ICE at the end of
+ * each Infer of the network into a ring, whose oldest samples are
+ * overwritten if it is not drained in time. Samples are read before the
+ * sampling state changes.
+ */
+struct ice_pmon_samples_params {
+	/* in, id of the context */
+	__u64 contextid;
+	/*in, id of the network */
+	__u64 networkid;
+	/*in, enum ice_pmon_sampling */
+	__u32 sampling;
+	/*in, capacity of samples, in entries */
+	__u32 max_samples;
+	/*in, array of struct ice_pmon_sample to move the samples to */
+	__u64 samples;
+	/*out, number of samples moved */
+	__u32 samples_nr;
+	/*out, samples overwritten since the previous read */
+	__u32 lost_nr;
+};
+
+/*
+ * parameter for IOCTL-predict-runtime
+ * Run time of an Infer of the network is the run time of its slowest ICE.
+ * All outputs are 0 until an Infer of the network completed.
+ */
+struct ice_predict_runtime_params {
+	/* in, id of the context */
+	__u64 contextid;
+	/*in, id of the network */
+	__u64 networkid;
+	/*out, predicted run time (moving average) in usec */
+	__u32 predicted_us;
+	/*out, median of recent run times in usec */
+	__u32 p50_us;
+	/*out, 99th percentile of recent run times in usec */
+	__u32 p99_us;
+	/*out, number of completed Infers the prediction is based on */
+	__u32 samples_nr;
+};
+
 /* a union of all the different parameters */
 struct cve_ioctl_param {
 	union {
@@ -836,6 +990,11 @@ struct cve_ioctl_param {
 		struct ice_debug_control_params debug_control;
 		struct ice_set_hw_config_params set_hw_config;
 		struct ice_reset_network_params reset_network;
+		struct ice_execute_infer_batch execute_infer_batch;
+		struct ice_wait_event_batch wait_event_batch;
+		struct ice_completion_ring_params completion_ring;
+		struct ice_predict_runtime_params predict_runtime;
+		struct ice_pmon_samples_params pmon_samples;
 	};
 };
 
@@ -882,4 +1041,14 @@ struct cve_ioctl_param {
 	_IOW(CVE_IOCTL_SEQ_NUM, 20, struct cve_ioctl_param)
 #define ICE_IOCTL_RESET_NETWORK \
 	_IOW(CVE_IOCTL_SEQ_NUM, 21, struct cve_ioctl_param)
+#define ICE_IOCTL_EXECUTE_INFER_BATCH \
+	_IOWR(CVE_IOCTL_SEQ_NUM, 22, struct cve_ioctl_param)
+#define ICE_IOCTL_WAIT_FOR_EVENT_BATCH \
+	_IOWR(CVE_IOCTL_SEQ_NUM, 23, struct cve_ioctl_param)
+#define ICE_IOCTL_COMPLETION_RING \
+	_IOWR(CVE_IOCTL_SEQ_NUM, 24, struct cve_ioctl_param)
+#define ICE_IOCTL_PREDICT_RUNTIME \
+	_IOWR(CVE_IOCTL_SEQ_NUM, 25, struct cve_ioctl_param)
+#define ICE_IOCTL_PMON_SAMPLES \
+	_IOWR(CVE_IOCTL_SEQ_NUM, 26, struct cve_ioctl_param)
 #endif /* _CVE_DRIVER_H_ */
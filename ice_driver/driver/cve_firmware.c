@@ -374,26 +374,20 @@ failed_to_vmap:
 
 static int cve_fw_load_firmware_from_user_mem(struct cve_device *cve_dev,
 		u64 fw_image,
-		u64 fw_binmap,
-		u32 fw_binmap_size_bytes,
+		struct ICVE_FIRMWARE_SECTION_DESCRIPTOR *sections,
+		u32 sections_nr,
 		u32 *out_sections_nr,
 		struct cve_fw_section_descriptor **out_sections,
 		struct cve_dma_handle **out_dma_handles,
 		Version **out_fw_version)
 {
 	int retval = CVE_DEFAULT_ERROR_CODE;
-	u32 sections_nr = 0;
-	/* hold a pointer to the map file interface sections */
-	struct ICVE_FIRMWARE_SECTION_DESCRIPTOR *sections = NULL;
 	/* hold a pointer to the map file impl sections */
 	struct cve_fw_section_descriptor *sections_impl = NULL;
 	struct cve_dma_handle *dma_handles = NULL;
 	Version *fw_version = NULL;
 	u32 i;
 
-	/* read the sections info from the map file */
-	sections_nr = fw_binmap_size_bytes /
-			sizeof(struct ICVE_FIRMWARE_SECTION_DESCRIPTOR);
 	retval = OS_ALLOC_ZERO(sizeof(*sections_impl) * sections_nr,
 				(void **)&sections_impl);
 	if (retval != 0) {
@@ -411,16 +405,6 @@ static int cve_fw_load_firmware_from_user_mem(struct cve_device *cve_dev,
 		goto out;
 	}
 
-	/* copy to kernel space */
-	retval = OS_ALLOC_ZERO(sizeof(*sections) * sections_nr,
-				(void **)&sections);
-	if (retval != 0) {
-		cve_os_log(CVE_LOGLEVEL_ERROR,
-				"OS_ALLOC_ZERO (sections) failed %d\n",
-				retval);
-		goto out;
-	}
-
 	/* fw_version allocation */
 	retval = OS_ALLOC_ZERO(sizeof(*fw_version),
 					(void **)&fw_version);
@@ -431,16 +415,6 @@ static int cve_fw_load_firmware_from_user_mem(struct cve_device *cve_dev,
 		goto out;
 	}
 
-	retval = cve_os_read_user_memory((void *)(uintptr_t)fw_binmap,
-			sizeof(*sections) * sections_nr,
-			sections);
-	if (retval != 0) {
-		cve_os_log(CVE_LOGLEVEL_ERROR,
-				"cve_os_read_user_memory failed: %d\n",
-				retval);
-		goto out;
-	}
-
 	/* read the sections */
 	retval = -ENOMEM;
 	for (i = 0; i < sections_nr; i++) {
@@ -525,8 +499,6 @@ static int cve_fw_load_firmware_from_user_mem(struct cve_device *cve_dev,
 	retval = 0;
 
 out:
-	OS_FREE(sections, sizeof(*sections) * sections_nr);
-
 	if (retval != 0) {
 		cve_fw_sections_cleanup(cve_dev,
 			sections_impl,
@@ -775,6 +747,131 @@ out:
 	return retval;
 }
 
+/*
+ * Parsed firmware images are kept in a global cache so that the base
+ * package is read and copied into DMA memory once for all ICEs, and a
+ * custom firmware is not reloaded for every network that uses it.
+ * Read-only sections of a cached image are shared by every mapping,
+ * writable sections are still duplicated per mapping by
+ * cve_fw_map_sections(). Callers are serialized either by device probing
+ * or by the driver big lock.
+ * The key of a custom image comes from user space and its bytes are not
+ * compared, so it is only reused by the context that loaded it.
+ */
+struct ice_fw_image {
+	struct cve_dle_t list;
+	enum fw_binary_type fw_type;
+	/* base package image, looked up by fw_type only */
+	u8 is_base;
+	/* custom images are looked up by owner and by their map */
+	u64 owner_id;
+	struct ICVE_FIRMWARE_SECTION_DESCRIPTOR *binmap;
+	u32 binmap_size_bytes;
+	u32 sections_nr;
+	struct cve_fw_section_descriptor *sections;
+	struct cve_dma_handle *dma_handles;
+	Version *fw_version;
+	u32 refcount;
+};
+
+static struct ice_fw_image *fw_image_cache;
+
+static struct ice_fw_image *__fw_image_lookup(enum fw_binary_type fw_type,
+		u64 owner_id,
+		struct ICVE_FIRMWARE_SECTION_DESCRIPTOR *binmap,
+		u32 binmap_size_bytes)
+{
+	struct ice_fw_image *image = fw_image_cache;
+
+	if (!image)
+		return NULL;
+
+	do {
+		if (binmap) {
+			if (!image->is_base &&
+				image->owner_id == owner_id &&
+				image->binmap_size_bytes == binmap_size_bytes &&
+				!memcmp(image->binmap, binmap,
+					binmap_size_bytes))
+				return image;
+		} else if (image->is_base && image->fw_type == fw_type) {
+			return image;
+		}
+		image = cve_dle_next(image, list);
+	} while (image != fw_image_cache);
+
+	return NULL;
+}
+
+static void __fw_image_get(struct ice_fw_image *image,
+		struct cve_fw_loaded_sections *fw_sec)
+{
+	image->refcount++;
+
+	fw_sec->sections_nr = image->sections_nr;
+	fw_sec->sections = image->sections;
+	fw_sec->dma_handles = image->dma_handles;
+	fw_sec->fw_type = image->fw_type;
+	fw_sec->fw_version = image->fw_version;
+	fw_sec->image = image;
+}
+
+/*
+ * move the sections of a freshly loaded firmware into a new cached image.
+ * On success the image also takes ownership of binmap (if any).
+ */
+static int __fw_image_add(struct cve_fw_loaded_sections *fw_sec,
+		u8 is_base,
+		u64 owner_id,
+		struct ICVE_FIRMWARE_SECTION_DESCRIPTOR *binmap,
+		u32 binmap_size_bytes)
+{
+	struct ice_fw_image *image = NULL;
+	int retval;
+
+	retval = OS_ALLOC_ZERO(sizeof(*image), (void **)&image);
+	if (retval != 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"OS_ALLOC_ZERO (fw image) failed %d\n",
+				retval);
+		return retval;
+	}
+
+	image->fw_type = fw_sec->fw_type;
+	image->is_base = is_base;
+	image->owner_id = owner_id;
+	image->binmap = binmap;
+	image->binmap_size_bytes = binmap_size_bytes;
+	image->sections_nr = fw_sec->sections_nr;
+	image->sections = fw_sec->sections;
+	image->dma_handles = fw_sec->dma_handles;
+	image->fw_version = fw_sec->fw_version;
+	image->refcount = 1;
+	fw_sec->image = image;
+
+	cve_dle_add_to_list_before(fw_image_cache, list, image);
+
+	return 0;
+}
+
+static void __fw_image_put(struct cve_device *cve_dev,
+		struct ice_fw_image *image)
+{
+	if (--image->refcount)
+		return;
+
+	cve_dle_remove_from_list(fw_image_cache, list, image);
+
+	cve_fw_sections_cleanup(cve_dev,
+			image->sections,
+			image->dma_handles,
+			image->sections_nr);
+	OS_FREE(image->fw_version, sizeof(*image->fw_version));
+	if (image->binmap)
+		OS_FREE(image->binmap, image->binmap_size_bytes);
+	OS_FREE(image, sizeof(*image));
+}
+
 int cve_fw_map_sections(
 		struct cve_device *cve_dev,
 		const os_domain_handle hdom,
@@ -952,22 +1049,69 @@ out:
 }
 
 int cve_fw_load_binary(struct cve_device *cve_dev,
+		const u64 owner_id,
 		const u64 fw_image,
 		const u64 fw_binmap,
 		const u32 fw_binmap_size_bytes,
 		struct cve_fw_loaded_sections *out_fw_sec)
 {
-	u32 sections_nr = 0;
+	u32 sections_nr = fw_binmap_size_bytes /
+			sizeof(struct ICVE_FIRMWARE_SECTION_DESCRIPTOR);
+	u32 binmap_size_bytes = sections_nr *
+			sizeof(struct ICVE_FIRMWARE_SECTION_DESCRIPTOR);
+	struct ICVE_FIRMWARE_SECTION_DESCRIPTOR *binmap = NULL;
 	struct cve_fw_section_descriptor *sections = NULL;
 	struct cve_dma_handle *dma_handles = NULL;
 	Version *fw_version = NULL;
+	struct ice_fw_image *image;
 	enum fw_binary_type fw_type = CVE_FW_TYPE_INVALID;
+	int retval;
+
+	if (!sections_nr) {
+		retval = -ICEDRV_KERROR_FW_INVAL_TYPE;
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"ERROR:%d empty FW map, size bytes = 0x%x\n",
+				retval, fw_binmap_size_bytes);
+		return retval;
+	}
+
+	/* copy the map to kernel space, it is also the cache key */
+	retval = OS_ALLOC_ZERO(binmap_size_bytes, (void **)&binmap);
+	if (retval != 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"OS_ALLOC_ZERO (binmap) failed %d\n",
+				retval);
+		return retval;
+	}
+
+	retval = cve_os_read_user_memory((void *)(uintptr_t)fw_binmap,
+			binmap_size_bytes,
+			binmap);
+	if (retval != 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"cve_os_read_user_memory failed: %d\n",
+				retval);
+		goto out;
+	}
+
+	image = __fw_image_lookup(CVE_FW_TYPE_INVALID, owner_id, binmap,
+			binmap_size_bytes);
+	if (image) {
+		__fw_image_get(image, out_fw_sec);
+		cve_os_dev_log(CVE_LOGLEVEL_DEBUG,
+				cve_dev->dev_index,
+				"Reusing cached FW image. FW_Type=%s, RefCount=%u\n",
+				get_fw_binary_type_str(image->fw_type),
+				image->refcount);
+		retval = 0;
+		goto out;
+	}
 
 	/* read input sections from memory */
-	int retval = cve_fw_load_firmware_from_user_mem(cve_dev,
+	retval = cve_fw_load_firmware_from_user_mem(cve_dev,
 			fw_image,
-			fw_binmap,
-			fw_binmap_size_bytes,
+			binmap,
+			sections_nr,
 			&sections_nr,
 			&sections,
 			&dma_handles,
@@ -996,6 +1140,15 @@ int cve_fw_load_binary(struct cve_device *cve_dev,
 	out_fw_sec->fw_type = fw_type;
 	out_fw_sec->fw_version = fw_version;
 
+	/*
+	 * Only images that carry a checksum can be told apart, others are
+	 * loaded again on every request. Failing to cache is not an error.
+	 */
+	if (fw_version->component.checksum &&
+		!__fw_image_add(out_fw_sec, 0, owner_id, binmap,
+			binmap_size_bytes))
+		binmap = NULL;
+
 	retval = 0;
 out:
 	if (retval != 0) {
@@ -1006,6 +1159,8 @@ out:
 		if (fw_version)
 			OS_FREE(fw_version, sizeof(*fw_version));
 	}
+	if (binmap)
+		OS_FREE(binmap, binmap_size_bytes);
 
 	return retval;
 }
@@ -1182,6 +1337,7 @@ int cve_fw_load(struct cve_device *cve_dev)
 #ifndef NULL_DEVICE_RING0
 	u32 i;
 	struct cve_fw_loaded_sections *loaded_fw_list = NULL;
+	struct ice_fw_image *image;
 
 	cve_os_dev_log(CVE_LOGLEVEL_DEBUG,
 			cve_dev->dev_index,
@@ -1210,14 +1366,24 @@ int cve_fw_load(struct cve_device *cve_dev)
 		/* detect fw type */
 		loaded_fw->fw_type = fw_binaries_files[i].fw_type;
 
-		retval = cve_fw_load_binary_files(cve_dev,
-				&fw_binaries_files[i],
-				loaded_fw);
-		if (retval < 0) {
-			cve_os_log(CVE_LOGLEVEL_ERROR,
-					"load_fw_binary failed %d\n", retval);
-			OS_FREE(loaded_fw, sizeof(*loaded_fw));
-			goto out;
+		/* base package is read once and shared by all devices */
+		image = __fw_image_lookup(loaded_fw->fw_type, 0, NULL, 0);
+		if (image) {
+			__fw_image_get(image, loaded_fw);
+		} else {
+			retval = cve_fw_load_binary_files(cve_dev,
+					&fw_binaries_files[i],
+					loaded_fw);
+			if (retval < 0) {
+				cve_os_log(CVE_LOGLEVEL_ERROR,
+						"load_fw_binary failed %d\n",
+						retval);
+				OS_FREE(loaded_fw, sizeof(*loaded_fw));
+				goto out;
+			}
+
+			/* keep the device private copy if caching fails */
+			__fw_image_add(loaded_fw, 1, 0, NULL, 0);
 		}
 
 		/* check the FW type and fill the proper global FW version */
@@ -1360,11 +1526,7 @@ void cve_fw_unload(struct cve_device *cve_dev,
 		cve_dle_remove_from_list(fw_loaded_list,
 				list,
 				fw_loaded);
-		cve_fw_sections_cleanup(cve_dev,
-			fw_loaded->sections,
-			fw_loaded->dma_handles,
-			fw_loaded->sections_nr);
-		OS_FREE(fw_loaded->fw_version, sizeof(*fw_loaded->fw_version));
+		cve_fw_loaded_sections_cleanup(cve_dev, fw_loaded);
 		OS_FREE(fw_loaded, sizeof(*fw_loaded));
 	}
 #endif
@@ -1638,6 +1800,27 @@ void cve_fw_sections_cleanup(struct cve_device *cve_dev,
 	}
 }
 
+void cve_fw_loaded_sections_cleanup(struct cve_device *cve_dev,
+		struct cve_fw_loaded_sections *fw_sec)
+{
+	if (fw_sec->image) {
+		__fw_image_put(cve_dev, fw_sec->image);
+	} else {
+		cve_fw_sections_cleanup(cve_dev,
+			fw_sec->sections,
+			fw_sec->dma_handles,
+			fw_sec->sections_nr);
+		if (fw_sec->fw_version)
+			OS_FREE(fw_sec->fw_version,
+					sizeof(*fw_sec->fw_version));
+	}
+
+	fw_sec->image = NULL;
+	fw_sec->sections = NULL;
+	fw_sec->dma_handles = NULL;
+	fw_sec->fw_version = NULL;
+}
+
 int cve_fw_load_firmware_via_files(struct cve_device *cve_dev,
 		const char *fw_file_name,
 		const char *map_file_name,
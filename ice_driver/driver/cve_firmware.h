@@ -68,13 +68,16 @@ int cve_fw_map_sections(
 
 /*
  * load dynamic firmware binary to context memory
- * inputs : u64 fw_image - fw image address
+ * inputs : u64 owner_id - id of the context loading the firmware, a cached
+ *            image is only reused by the context that loaded it
+ * u64 fw_image - fw image address
  * u64 fw_binmap - fw map file addr
  * u32 fw_binmap_size_bytes - map size
  * outputs: cve_fw_loaded_sections *fw_sec - the firmware binary sections
  * returns: 0 on success, a negative error code on failure
  */
 int cve_fw_load_binary(struct cve_device *cve_dev,
+		const u64 owner_id,
 		const u64 fw_image,
 		const u64 fw_binmap,
 		const u32 fw_binmap_size_bytes,
@@ -168,6 +171,17 @@ void cve_fw_sections_cleanup(struct cve_device *cve_dev,
 	struct cve_dma_handle *dma_handles_lst,
 	u32 list_items_nr);
 
+/*
+ * release the sections of a loaded firmware, dropping its reference on
+ * the cached image if it has one. fw_sec itself is not freed.
+ * inputs : cve_device *cve_dev - cve device handle
+ *          cve_fw_loaded_sections *fw_sec - the loaded firmware
+ * outputs:
+ * returns:
+ */
+void cve_fw_loaded_sections_cleanup(struct cve_device *cve_dev,
+		struct cve_fw_loaded_sections *fw_sec);
+
 
 int cve_fw_load_firmware_via_files(struct cve_device *cve_dev,
 		const char *fw_file_name,
@@ -62,6 +62,9 @@ struct cve_fw_section_descriptor {
 	u32 permissions;
 };
 
+/* cached firmware image, private to cve_firmware.c */
+struct ice_fw_image;
+
 /*
  * Describes firmware sections that were loaded to memory
  * Each "cve_fw_loaded_sections" describes one fw type
@@ -77,6 +80,8 @@ struct cve_fw_loaded_sections {
 	/* firmware type*/
 	enum fw_binary_type fw_type;
 	Version *fw_version;
+	/* image owning sections/dma_handles/fw_version, NULL if uncached */
+	struct ice_fw_image *image;
 };
 
 /*
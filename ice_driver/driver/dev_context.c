@@ -22,6 +22,7 @@
 #include "device_interface.h"
 #include "cve_firmware.h"
 #include "ice_debug.h"
+#include "ice_dma_pool.h"
 
 /* hold per device per context data */
 struct dev_context {
@@ -243,6 +244,7 @@ static void cve_dev_release_per_cve_ctx(struct dev_context *dev_ctx)
 }
 
 static int cve_dev_fw_load_and_map_per_cve(cve_dev_context_handle_t hcontext,
+		const u64 owner_id,
 		const u64 fw_image,
 		const u64 fw_binmap,
 		const u32 fw_binmap_size_bytes)
@@ -267,7 +269,7 @@ static int cve_dev_fw_load_and_map_per_cve(cve_dev_context_handle_t hcontext,
 
 	/* load dynamic fw to memory */
 	retval = cve_fw_load_binary(context->cve_dev,
-			fw_image, fw_binmap,
+			owner_id, fw_image, fw_binmap,
 			fw_binmap_size_bytes,
 			fw_sec);
 	if (retval != 0) {
@@ -342,10 +344,8 @@ static int cve_dev_fw_load_and_map_per_cve(cve_dev_context_handle_t hcontext,
 out:
 	if (retval != 0) {
 		if (fw_sec) {
-			cve_fw_sections_cleanup(context->cve_dev,
-				fw_sec->sections,
-				fw_sec->dma_handles,
-				fw_sec->sections_nr);
+			cve_fw_loaded_sections_cleanup(context->cve_dev,
+				fw_sec);
 
 			OS_FREE(fw_sec, sizeof(*fw_sec));
 		}
@@ -378,6 +378,7 @@ void cve_dev_close_all_contexts(cve_dev_context_handle_t hcontext_list)
 }
 
 int cve_dev_fw_load_and_map(cve_dev_context_handle_t hcontext_list,
+		const u64 owner_id,
 		const u64 fw_image,
 		const u64 fw_binmap,
 		const u32 fw_binmap_size_bytes)
@@ -392,6 +393,7 @@ int cve_dev_fw_load_and_map(cve_dev_context_handle_t hcontext_list,
 
 	do {
 		retval = cve_dev_fw_load_and_map_per_cve(dev_ctx_item,
+			owner_id,
 			fw_image,
 			fw_binmap,
 			fw_binmap_size_bytes);
@@ -612,19 +614,18 @@ int cve_dev_alloc_and_map_cbdt(cve_dev_context_handle_t dev_ctx,
 	nc = (struct dev_context *)dev_ctx;
 	dev = nc->cve_dev;
 
-	retval = OS_ALLOC_DMA_CONTIG(dev,
-			sizeof(union CVE_SHARED_CB_DESCRIPTOR),
-			max_cbdt_entries,
+	size_bytes = max_cbdt_entries * sizeof(union CVE_SHARED_CB_DESCRIPTOR);
+	retval = ice_dma_pool_alloc(dev,
+			size_bytes,
 			&vaddr,
-			&fifo_desc->fifo.cb_desc_dma_handle, 1);
+			&fifo_desc->fifo.cb_desc_dma_handle);
 	if (retval != 0) {
 		cve_os_dev_log(CVE_LOGLEVEL_ERROR,
 			dev->dev_index,
-			"os_alloc_dma failed %d\n", retval);
+			"ice_dma_pool_alloc failed %d\n", retval);
 		goto out;
 	}
 
-	size_bytes = max_cbdt_entries * sizeof(union CVE_SHARED_CB_DESCRIPTOR);
 	memset(vaddr, 0, size_bytes);
 	fifo_desc->fifo.cb_desc_vaddr = vaddr;
 	fifo_desc->fifo.size_bytes = size_bytes;
@@ -669,10 +670,10 @@ int cve_dev_alloc_and_map_cbdt(cve_dev_context_handle_t dev_ctx,
 
 failed_map_fifo:
 	/* free descriptors list */
-	OS_FREE_DMA_CONTIG(dev,
+	ice_dma_pool_free(dev,
 			fifo_desc->fifo.size_bytes,
 			fifo_desc->fifo.cb_desc_vaddr,
-			&fifo_desc->fifo.cb_desc_dma_handle, 1);
+			&fifo_desc->fifo.cb_desc_dma_handle);
 out:
 	return retval;
 }
@@ -689,10 +690,10 @@ int cve_dev_dealloc_and_unmap_cbdt(cve_dev_context_handle_t dev_ctx,
 	cve_mm_reclaim_allocation(fifo_desc->fifo_alloc.alloc_handle);
 
 	/* free descriptors list */
-	OS_FREE_DMA_CONTIG(dev,
+	ice_dma_pool_free(dev,
 		fifo_desc->fifo.size_bytes,
 		fifo_desc->fifo.cb_desc_vaddr,
-		&fifo_desc->fifo.cb_desc_dma_handle, 1);
+		&fifo_desc->fifo.cb_desc_dma_handle);
 
 	return 0;
 }
@@ -84,6 +84,7 @@ void cve_dev_restore_fws(struct cve_device *cve_dev,
 /*
  * loads & map dynamic fw
  * inputs : hcontext - memory context
+ *	owner_id - id of the context that loads the FW
  *	fw_image - FW addr
  *	fw_binmap - FW map file for FW sections
  *	fw_binmap_size_bytes FW size
@@ -91,6 +92,7 @@ void cve_dev_restore_fws(struct cve_device *cve_dev,
  * returns: the address of the table
  */
 int cve_dev_fw_load_and_map(cve_dev_context_handle_t hcontext,
+		const u64 owner_id,
 		const u64 fw_image,
 		const u64 fw_binmap,
 		const u32 fw_binmap_size_bytes);
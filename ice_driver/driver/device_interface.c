@@ -122,6 +122,8 @@ struct di_job {
 	u8 cold_run;
 	/* Does this Job has SCB */
 	u8 has_scb;
+	/* Do CBDT entries point to per Infer CB copies */
+	u8 cbdt_has_cb_copy;
 	/* ddr BW in mbps*/
 	__u32 ddr_bw;
 	/* Ring to ICE clock frequency ratio*/
@@ -447,6 +449,48 @@ static void __prepare_cbdt(struct di_job *job,
 
 	job->remaining_subjobs_nr = 0;
 	job->last_cb_desc = last_cb_desc;
+	job->cbdt_has_cb_copy = 0;
+}
+
+/* Point CBDT entries to the CB copies of given Infer. Entries of CBs
+ * without a copy are restored to the network CB.
+ */
+static void __apply_inf_cb_copies(struct di_job *job,
+		struct cve_device *dev,
+		struct ice_infer *inf)
+{
+	u32 i;
+	cve_virtual_address_t address;
+	struct ice_inf_cb_copy *cb_copy;
+
+	if (!inf->cb_copy_list && !job->cbdt_has_cb_copy)
+		return;
+
+	for (i = 0; i <= job->last_cb_desc; i++) {
+		address = job->sub_jobs[i].cb.address;
+
+		cb_copy = inf->cb_copy_list;
+		while (cb_copy) {
+			if (address >= cb_copy->orig_iova &&
+				address < (cb_copy->orig_iova +
+					cb_copy->size_bytes)) {
+				address = (cve_virtual_address_t)
+					(cb_copy->copy_iova +
+					(address - cb_copy->orig_iova));
+				break;
+			}
+			cb_copy = cve_dle_next(cb_copy, list);
+			if (cb_copy == inf->cb_copy_list)
+				break;
+		}
+
+		dev->fifo_desc->fifo.cb_desc_vaddr[i].address = address;
+	}
+
+	job->cbdt_has_cb_copy = (inf->cb_copy_list != NULL);
+
+	cve_os_dev_log(CVE_LOGLEVEL_DEBUG, dev->dev_index,
+		"CBDT updated for InfID=0x%llx\n", inf->infer_id);
 }
 
 /*
@@ -469,6 +513,8 @@ static void dispatch_next_subjobs(struct di_job *job,
 	if (job->cold_run)
 		__prepare_cbdt(job, dev);
 
+	__apply_inf_cb_copies(job, dev, inf);
+
 	job->first_cb_desc = 0;
 	iceva = dev->fifo_desc->fifo_alloc.ice_vaddr;
 	db = job->last_cb_desc;
@@ -630,6 +676,9 @@ void ice_di_tlb_invalidate_full(struct cve_device *cve_dev)
 		ASSERT(((offset_bytes >> 2) << 2) == offset_bytes);
 		cve_os_write_mmio_32(cve_dev, offset_bytes, reg.val);
 	}
+
+	ice_swc_counter_inc(cve_dev->hswc,
+			ICEDRV_SWC_DEVICE_COUNTER_TLB_INV_FULL);
 }
 
 /* write to page table base address MMIO register of all ATU's*/
@@ -737,6 +786,10 @@ int set_idc_registers(struct ice_network *ntw, uint8_t lock)
 	struct cve_device *dev;
 	bool all_on = true;
 	uint64_t mask = 0;
+	struct timespec curr_ts, pe_ts, ready_ts;
+	u32 penalty_us;
+
+	getnstimeofday(&curr_ts);
 
 	if (lock) {
 		ret = cve_os_lock(&dg->poweroff_dev_list_lock,
@@ -772,6 +825,8 @@ int set_idc_registers(struct ice_network *ntw, uint8_t lock)
 			cve_dle_remove_from_list(dg->poweroff_dev_list,
 				poweroff_list, dev);
 
+			ice_pm_gov_idle_end(dev, &curr_ts, false);
+
 		} else {
 			mask |= (1ULL << (dev->dev_index + 4));
 			all_on = false;
@@ -818,6 +873,7 @@ int set_idc_registers(struct ice_network *ntw, uint8_t lock)
 
 	value |= mask;
 
+	getnstimeofday(&pe_ts);
 	cve_os_write_idc_mmio(dev,
 		cfg_default.bar0_mem_icepe_offset, value);
 
@@ -825,6 +881,8 @@ int set_idc_registers(struct ice_network *ntw, uint8_t lock)
 	/* Driver is not yet sure how long to wait for ICERDY */
 	__wait_for_ice_rdy(dev, value, mask,
 					cfg_default.bar0_mem_icerdy_offset);
+	getnstimeofday(&ready_ts);
+	penalty_us = ice_get_usec_timediff(&ready_ts, &pe_ts);
 	if ((value & mask) != mask) {
 		uint64_t val64 = (value & ~mask);
 
@@ -860,6 +918,9 @@ int set_idc_registers(struct ice_network *ntw, uint8_t lock)
 					ICEDRV_SWC_DEVICE_COUNTER_POWER_STATE,
 					ICE_POWER_ON);
 
+			ice_pm_gov_idle_end(dev, &curr_ts, true);
+			ice_pm_gov_wakeup(dev, penalty_us);
+
 			if (sphpb_cbs && sphpb_cbs->set_power_state) {
 				ret = sphpb_cbs->set_power_state(dev->dev_index,
 						true);
@@ -1409,6 +1470,35 @@ static struct ice_network *__get_ntw_of_overflowed_cntr(int cntr_id,
 	return ntw;
 }
 
+/* queue an interrupt status of the ICE for the deferred handler */
+static void __push_ice_isr_status(struct cve_device *ice, u32 status,
+		struct timespec *ts)
+{
+	u32 head = atomic_read(&ice->isr_q_head);
+	u32 tail = atomic_read(&ice->isr_q_tail);
+	struct ice_isr_status *qnode;
+
+	if (((head + 1) % ICE_ISR_Q_SZ) == tail) {
+		/*
+		 * Q FULL. Published nodes belong to the BH, which may be
+		 * reading them, so the status is ORed into a separate word
+		 * that the BH takes atomically after emptying the Q.
+		 */
+		cve_os_dev_log_default(CVE_LOGLEVEL_ERROR, ice->dev_index,
+				"BH ISR Q FULL\n");
+		atomic_or((int)status, &ice->isr_q_overflow);
+		return;
+	}
+
+	qnode = &ice->isr_q[head];
+	qnode->status = status;
+	qnode->cur_ts = *ts;
+
+	/* publish the node before moving the head */
+	smp_wmb();
+	atomic_set(&ice->isr_q_head, (head + 1) % ICE_ISR_Q_SZ);
+}
+
 int cve_di_interrupt_handler(struct idc_device *idc_dev)
 {
 	int index;
@@ -1514,7 +1604,8 @@ int cve_di_interrupt_handler(struct idc_device *idc_dev)
 		status_32 = cve_os_read_mmio_32(cve_dev,
 				cfg_default.mmio_intr_status_offset);
 		status_32 |= ice_os_get_user_intst(cve_dev->dev_index);
-		isr_status_node->ice_isr_status[index] = status_32;
+		__push_ice_isr_status(cve_dev, status_32,
+				&isr_status_node->cur_ts);
 		cve_os_dev_log(CVE_LOGLEVEL_INFO,
 			index,
 			"Received interrupt from IDC. Status=0x%x\n",
@@ -1548,64 +1639,108 @@ static inline void __read_isr_q(struct idc_device *dev,
 	u32 head = atomic_read(&dev->status_q_head);
 	u32 tail = atomic_read(&dev->status_q_tail);
 	struct dev_isr_status *qnode;
-	struct cve_device *ice = NULL;
-	u32 status_lo = 0, status_hi = 0, status_hl = 0, index = 0;
 
 	while (tail != head) {
-		index = 0;
 		qnode = &dev->isr_status[tail];
 		if (qnode->valid) {
 			qnode->valid = 0;
 			*idc_status |= qnode->idc_status;
 			*ice_status |= qnode->ice_status;
-			status_lo = (qnode->ice_status & 0xFFFF);
-			status_hi = ((qnode->ice_status >> 32) & 0xFFFF);
-			status_hl = status_hi | status_lo;
 			cve_os_log(CVE_LOGLEVEL_DEBUG,
 					"IsrQNode[%d] idc_status:0x%llx ice_status:0x%llx\n",
 					tail, *idc_status, *ice_status);
-
-			status_hl >>= 4;
-			while (status_hl && index < NUM_ICE_UNIT) {
-				if (status_hl & 0x1) {
-					ice = &dev->cve_dev[index];
-
-					if (ice_get_usec_timediff(
-						&qnode->cur_ts,
-						&ice->db_time)) {
-
-						ice->interrupts_status |=
-						qnode->ice_isr_status[index];
-
-						cve_os_log(CVE_LOGLEVEL_DEBUG,
-						"IsrQNode[%d] ice%d status:0x%x\n",
-						tail, index,
-						ice->interrupts_status);
-					} else {
-					 cve_os_log_default(CVE_LOGLEVEL_INFO,
-						"Discarding outdated interrupt of ICE%d status:0x%x DB_time=%lu.%lu Int_time=%lu.%lu\n",
-						index,
-						qnode->ice_isr_status[index],
-						ice->db_time.tv_sec,
-						ice->db_time.tv_nsec,
-						qnode->cur_ts.tv_sec,
-						qnode->cur_ts.tv_nsec);
-					}
-				}
-				status_hl = (status_hl >> 1);
-				index++;
-			}
 			tail = (tail + 1) % IDC_ISR_BH_QUEUE_SZ;
 		}
 	}
 	*q_tail = tail;
 }
 
+static inline bool __ts_before(struct timespec *a, struct timespec *b)
+{
+	return (a->tv_sec < b->tv_sec) ||
+		((a->tv_sec == b->tv_sec) && (a->tv_nsec < b->tv_nsec));
+}
+
+/*
+ * Pick the ICE whose oldest queued interrupt arrived first and empty its
+ * queue, so that jobs are completed in the order their statuses arrived
+ * rather than in ICE index order.
+ * Returns the ICE index with the ORed statuses, -1 if all Qs are empty.
+ */
+static int __pop_first_ice_isr_q(struct idc_device *dev, u32 *status)
+{
+	int i, first = -1;
+	u32 head, tail;
+	struct cve_device *ice;
+	struct ice_isr_status *qnode, *first_node = NULL;
+
+	for (i = 0; i < NUM_ICE_UNIT; i++) {
+		ice = &dev->cve_dev[i];
+		tail = atomic_read(&ice->isr_q_tail);
+		if (tail == (u32)atomic_read(&ice->isr_q_head)) {
+			/* overflow raced with the BH emptying the Q */
+			if (first < 0 && atomic_read(&ice->isr_q_overflow))
+				first = i;
+			continue;
+		}
+
+		smp_rmb();
+		qnode = &ice->isr_q[tail];
+		if (!first_node || __ts_before(&qnode->cur_ts,
+					&first_node->cur_ts)) {
+			first = i;
+			first_node = qnode;
+		}
+	}
+
+	if (first < 0)
+		return first;
+
+	ice = &dev->cve_dev[first];
+	head = atomic_read(&ice->isr_q_head);
+	tail = atomic_read(&ice->isr_q_tail);
+	smp_rmb();
+
+	*status = 0;
+	while (tail != head) {
+		qnode = &ice->isr_q[tail];
+
+		if (ice_get_usec_timediff(&qnode->cur_ts, &ice->db_time)) {
+
+			*status |= qnode->status;
+
+			cve_os_log(CVE_LOGLEVEL_DEBUG,
+				"IsrQNode[%d] ice%d status:0x%x\n",
+				tail, first, *status);
+		} else {
+			cve_os_log_default(CVE_LOGLEVEL_INFO,
+				"Discarding outdated interrupt of ICE%d status:0x%x DB_time=%lu.%lu Int_time=%lu.%lu\n",
+				first,
+				qnode->status,
+				ice->db_time.tv_sec,
+				ice->db_time.tv_nsec,
+				qnode->cur_ts.tv_sec,
+				qnode->cur_ts.tv_nsec);
+		}
+		tail = (tail + 1) % ICE_ISR_Q_SZ;
+	}
+	atomic_set(&ice->isr_q_tail, tail);
+
+	/*
+	 * Taken after moving the tail, a status ORed later is either seen
+	 * here or found by the next call. It arrived while the Q was full,
+	 * after the doorbell, so it is never outdated.
+	 */
+	*status |= (u32)atomic_xchg(&ice->isr_q_overflow, 0);
+
+	return first;
+}
+
 void cve_di_interrupt_handler_deferred_proc(struct idc_device *dev)
 {
 	int index, i;
 	u32 status;
-	u32 status_lo = 0, status_hi = 0, status_hl = 0, ice_err = 0;
+	u32 ice_err = 0;
 	union icedc_intr_status_t idc_err_status;
 	u64 exec_time = 0, ice_status = 0, idc_status = 0;
 	struct di_job *job;
@@ -1619,6 +1754,10 @@ void cve_di_interrupt_handler_deferred_proc(struct idc_device *dev)
 	u32 head, tail;
 	struct dev_isr_status *isr_status_node;
 
+	/* only traced and logged */
+	declare_u32_var(status_lo);
+	declare_u32_var(status_hi);
+
 	DO_TRACE(trace__icedrvBottomHalf(
 				SPH_TRACE_OP_STATE_QUEUED,
 				0, 0, 0,
@@ -1693,48 +1832,55 @@ void cve_di_interrupt_handler_deferred_proc(struct idc_device *dev)
 			/* Affects all Networks that are using counter */
 			for (i = 0; i < MAX_HW_COUNTER_NR; i++) {
 				ntw = __get_ntw_of_overflowed_cntr(i, dev);
-				if (ntw) {
-					ntw->icedc_err_status =
-							idc_err_status.val;
-					ntw->reset_ntw = true;
+				if (!ntw)
+					continue;
+
+				/* Idle Ntw only keeps the counter, no reset */
+				if (ntw->sticky_resource) {
+					ice_ds_ntw_drop_sticky_resource(ntw);
+					continue;
 				}
+
+				ntw->icedc_err_status = idc_err_status.val;
+				ntw->reset_ntw = true;
 			}
 		} else if (idc_err_status.field.attn_err) {
 
 			struct ice_network *ntw, *ntw_head;
 
-			/* Affects all networks */
-			ntw_head = dg->ntw_with_resources;
-			ntw = ntw_head;
-
 			cve_os_log(CVE_LOGLEVEL_ERROR,
 				"Received error interrupt from IceDC\n");
 
-			do {
-				ntw->icedc_err_status = idc_err_status.val;
-				/* TODO: Segregate IDC error */
-				ntw->reset_ntw = true;
+			/* Idle Ntws only keep resources, no reset for them */
+			ice_ds_drop_sticky_resources();
+
+			/* Affects all other networks */
+			ntw_head = dg->ntw_with_resources;
+			ntw = ntw_head;
+
+			if (ntw_head) {
+				do {
+					ntw->icedc_err_status =
+						idc_err_status.val;
+					/* TODO: Segregate IDC error */
+					ntw->reset_ntw = true;
 
-				ntw = cve_dle_next(ntw, resource_list);
-			} while (ntw != ntw_head);
+					ntw = cve_dle_next(ntw, resource_list);
+				} while (ntw != ntw_head);
+			}
 		}
 	}
 
-	status_hl = status_lo | status_hi;
 	cve_os_log(CVE_LOGLEVEL_INFO,
-			"Status_hl=0x%x status_lo:0x%x status_hi:0x%x ice_status:0x%llx\n",
-			status_hl, status_lo, status_hi, ice_status);
-
-	if (!status_hl)
-		goto end;
+			"status_lo:0x%x status_hi:0x%x ice_status:0x%llx\n",
+			status_lo, status_hi, ice_status);
 
 	while (1) {
 
-		index = identify_ice_and_clear(&status_hl);
+		index = __pop_first_ice_isr_q(dev, &status);
 		if (index < 0) {
 			cve_os_log(CVE_LOGLEVEL_INFO,
-					"Exit status_hl:0x%x Index:%d\n",
-					status_hl, index);
+					"Exit Index:%d\n", index);
 			break;
 		}
 
@@ -1749,8 +1895,6 @@ void cve_di_interrupt_handler_deferred_proc(struct idc_device *dev)
 		 *ice_di_read_llc_pmon(cve_dev);
 		 */
 
-		status = cve_dev->interrupts_status;
-		cve_dev->interrupts_status = 0;
 		cve_os_dev_log(CVE_LOGLEVEL_INFO,
 			index,
 			"Received interrupt[BH] from IDC. Status=0x%x\n",
@@ -1902,13 +2046,16 @@ void cve_di_interrupt_handler_deferred_proc(struct idc_device *dev)
 			job_status = CVE_JOBSTATUS_COMPLETED;
 
 		}
-		if (ice_dump_mmu_pmon() || dg->dump_ice_pmon) {
+		if (ice_dump_mmu_pmon() || dg->dump_ice_pmon ||
+			cve_dev->pmon_sampling) {
 			get_ice_mmu_pmon_regs(cve_dev);
-			__dump_mmu_pmon(cve_dev);
+			if (ice_dump_mmu_pmon() || dg->dump_ice_pmon)
+				__dump_mmu_pmon(cve_dev);
 		}
-		if (dg->dump_ice_pmon) {
+		if (dg->dump_ice_pmon || cve_dev->pmon_sampling) {
 			get_ice_delphi_pmon_regs(cve_dev);
-			__dump_delphi_pmon(cve_dev);
+			if (dg->dump_ice_pmon)
+				__dump_delphi_pmon(cve_dev);
 		}
 
 handle_interrupt_check_completion:
@@ -1999,6 +2146,7 @@ void cve_di_set_page_directory_base_addr(struct cve_device *cve_dev,
 		"PD base addr = 0x%x\n",
 		base_addr);
 	write_to_page_table_base_address(cve_dev, reg);
+	cve_dev->pd_base_addr = base_addr;
 }
 
 void cve_di_invalidate_page_table_base_address(struct cve_device *cve_dev)
@@ -2007,6 +2155,7 @@ void cve_di_invalidate_page_table_base_address(struct cve_device *cve_dev)
 
 	reg.val = 0;
 	write_to_page_table_base_address(cve_dev, reg);
+	cve_dev->pd_base_addr = 0;
 }
 
 int cve_di_handle_submit_job(
@@ -2199,7 +2348,8 @@ void cve_di_set_hw_counters(struct cve_device *cve_dev)
 	reg.val = cve_os_read_mmio_32(cve_dev, offset_bytes);
 
 	/* Enable/Disable HW counters */
-	if (ice_dump_mmu_pmon() || dg->dump_ice_pmon)
+	if (ice_dump_mmu_pmon() || dg->dump_ice_pmon ||
+		cve_dev->pmon_sampling)
 		reg.field. ACTIVATE_PERFORMANCE_COUNTERS = 1;
 	else
 		reg.field.ACTIVATE_PERFORMANCE_COUNTERS =
@@ -2301,6 +2451,16 @@ void ice_di_set_cold_run(cve_di_job_handle_t hjob)
 	job->cold_run = 1;
 }
 
+void ice_di_get_job_dvfs_req(cve_di_job_handle_t hjob, u32 *ddr_bw,
+		u16 *ring_to_ice_ratio, u16 *ice_to_ice_ratio)
+{
+	struct di_job *job = (struct di_job *)hjob;
+
+	*ddr_bw = job->ddr_bw;
+	*ring_to_ice_ratio = job->ring_to_ice_ratio;
+	*ice_to_ice_ratio = job->ice_to_ice_ratio;
+}
+
 static int ice_trigger_cnc_control_msg(struct cve_device *dev, u32 destCbbid,
 				u32 opcode, u32 isPosted, u32 controlPayload)
 {
@@ -2405,15 +2565,31 @@ uint16_t cve_di_get_cdyn_val(cve_di_job_handle_t hjob)
 
 static void __dump_mmu_pmon(struct cve_device *ice)
 {
+	u32 delta, tlb_miss_delta = 0;
 	int i = 0;
 
 	for (i = 0; i < ICE_MAX_MMU_PMON; i++) {
+		/* counters start over when the ICE is reset */
+		delta = ice->mmu_pmon[i].pmon_value;
+		if (delta >= ice->mmu_pmon[i].pmon_prev_value)
+			delta -= ice->mmu_pmon[i].pmon_prev_value;
+		ice->mmu_pmon[i].pmon_prev_value = ice->mmu_pmon[i].pmon_value;
+
+		if (i < ICE_MMU_PMON_ATU_MISSES_NR)
+			tlb_miss_delta += delta;
+
 		cve_os_dev_log_default(CVE_LOGLEVEL_INFO,
 		ice->dev_index,
-		"%s\t:%u\n",
+		"%s\t:%u\tDelta:%u\n",
 		ice->mmu_pmon[i].pmon_name,
-		ice->mmu_pmon[i].pmon_value);
+		ice->mmu_pmon[i].pmon_value,
+		delta);
 	}
+
+	cve_os_dev_log_default(CVE_LOGLEVEL_INFO,
+		ice->dev_index,
+		"TLB_Misses_Delta\t:%u\n",
+		tlb_miss_delta);
 }
 static void __dump_delphi_pmon(struct cve_device *ice)
 {
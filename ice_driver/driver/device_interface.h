@@ -328,6 +328,10 @@ u8 ice_di_is_cold_run(cve_di_job_handle_t hjob);
 
 void ice_di_set_cold_run(cve_di_job_handle_t hjob);
 
+/* DDR bandwidth and ICE ratios requested by the job, for the power balancer */
+void ice_di_get_job_dvfs_req(cve_di_job_handle_t hjob, u32 *ddr_bw,
+		u16 *ring_to_ice_ratio, u16 *ice_to_ice_ratio);
+
 void ice_di_tlb_invalidate_full(struct cve_device *cve_dev);
 
 uint16_t cve_di_get_cdyn_val(cve_di_job_handle_t hjob);
@@ -45,12 +45,31 @@
 #include "ice_debug.h"
 #include "ice_trace.h"
 #include "icedrv_internal_sw_counter_funcs.h"
+#ifndef RING3_VALIDATION
+#include "intel_sphpb.h"
+#else
+#include "dummy_intel_sphpb.h"
+#endif
 
 
 /* max number of Shared_Read requests from the leader, that */
 /* were not yet matched by the follower. */
 #define MAX_SHARED_DISTANCE 0x40
 
+/* ICE placement score weights. Each weight is a distinct bit so that the
+ * reason of a placement can be read back from the score. The low bits
+ * order the ICEs recommended by the power balancer, best first.
+ */
+#define ICE_PLACE_SCORE_WARM 0x80
+#define ICE_PLACE_SCORE_POWERED 0x40
+#define ICE_PLACE_SCORE_EFFICIENT 0x20
+#define ICE_PLACE_SCORE_BO_ACTIVE 0x10
+
+/* networks expected to run longer than this are never polled for */
+#define ICE_HYBRID_POLL_MAX_US 1000
+/* jobs on an ICE needed before a slow one is counted */
+#define ICE_EXEC_STATS_SLOW_MIN_SAMPLES 16
+
 /*Calculate average ice cycles */
 #define __calc_ice_max_cycle(max_ice_cycle, total_time) \
 do { \
@@ -101,6 +120,9 @@ static int __ntw_reserve_ice(struct ice_network *ntw);
 static void __ntw_release_ice(struct ice_network *ntw);
 static int __ntw_reserve_cntr(struct ice_network *ntw);
 static void __ntw_release_cntr(struct ice_network *ntw);
+static void __ntw_drop_resource(struct ice_network *ntw);
+static void __ntw_drop_sticky_resource(struct ice_network *ntw);
+static int __is_pool_required(struct ice_network *ntw);
 static void __ntw_reset_cntr(struct ice_network *ntw);
 static int __ntw_reserve_clos(struct ice_network *ntw);
 static void __flush_ntw_buffers(struct ice_network *ntw);
@@ -226,14 +248,10 @@ static inline cve_bufferid_t get_new_buffer_id(void)
 	return (cve_bufferid_t)n;
 }
 
-static void copy_event_data_and_remove(cve_context_process_id_t context_pid,
-		struct cve_context_process *process,
-		cve_context_id_t contextid,
-		struct ice_infer *inf,
-		struct cve_get_event *data) {
-	struct ice_network *ntw;
-	struct ds_context __maybe_unused *ctx;
-	struct cve_completion_event *event;
+/* Translate the internal completion event to user visible format */
+static void __copy_event_data(struct cve_completion_event *event,
+		struct cve_get_event *data)
+{
 	u64 *total_time = (uint64_t *)data->total_time;
 	u64 *icedc_err_status = (uint64_t *)&data->icedc_err_status;
 	u64 *ice_err_status = (uint64_t *)&data->ice_err_status;
@@ -243,11 +261,6 @@ static void copy_event_data_and_remove(cve_context_process_id_t context_pid,
 	union icedc_intr_status_t reg;
 	u64 ice_err;
 
-	if (!data->infer_id)
-		event = process->alloc_events;
-	else
-		event = inf->infer_events;
-
 	data->infer_id = event->infer_id;
 	data->jobs_group_status = event->jobs_group_status;
 	data->user_data = event->user_data;
@@ -349,6 +362,23 @@ static void copy_event_data_and_remove(cve_context_process_id_t context_pid,
 		*ice_err_status |= DSRAM_UNMAPPED_ADDR;
 	if (ice_err & ICE_READY_BIT_ERR)
 		*ice_err_status |= ICE_READY_BIT_ERR;
+}
+
+static void copy_event_data_and_remove(cve_context_process_id_t context_pid,
+		struct cve_context_process *process,
+		cve_context_id_t contextid,
+		struct ice_infer *inf,
+		struct cve_get_event *data) {
+	struct ice_network *ntw;
+	struct ds_context __maybe_unused *ctx;
+	struct cve_completion_event *event;
+
+	if (!data->infer_id)
+		event = process->alloc_events;
+	else
+		event = inf->infer_events;
+
+	__copy_event_data(event, data);
 
 	ntw = (struct ice_network *)event->ntw_id;
 	ctx = ntw->wq->context;
@@ -562,7 +592,8 @@ static void do_reset(struct cve_device *cve_dev,
 	 * through PMON configuration. Enabled if requested explictly via knob
 	 */
 	/* Enable/Disable HW counters */
-	if (ice_dump_mmu_pmon() || cve_dev->dg->dump_ice_pmon)
+	if (ice_dump_mmu_pmon() || cve_dev->dg->dump_ice_pmon ||
+		cve_dev->pmon_sampling)
 		cve_di_set_hw_counters(cve_dev);
 
 	/* reset dump register */
@@ -820,6 +851,117 @@ static int dealloc_and_unmap_network_fifo(struct ice_network *network)
 	return 0;
 }
 
+/*
+ * Ask the power balancer which of the ICEs just captured by the network are
+ * the most power efficient to turn on, for its most DDR hungry job. ICEs
+ * that are already on are not ranked. Called once per capture, placement
+ * of every job then reuses the ranking.
+ */
+static void __ice_placement_rank(struct ice_network *ntw)
+{
+	struct cve_device_group *dg = cve_dg_get();
+	const struct sphpb_callbacks *sphpb_cbs = dg->sphpb.sphpb_cbs;
+	struct jobgroup_descriptor *jg = ntw->jg_list;
+	u8 ice_array[NUM_ICE_UNIT] = {0};
+	u16 ring_to_ice_ratio = 0, ice_to_ice_ratio = 0, r2i, i2i;
+	u32 ddr_bw = 0, bw;
+	int ret;
+	u32 i;
+
+	memset(ntw->ice_place_rank, 0, sizeof(ntw->ice_place_rank));
+	ntw->ice_place_ranked = false;
+
+	if (!sphpb_cbs || !sphpb_cbs->get_efficient_ice_list)
+		return;
+
+	for (i = 0; i < jg->total_jobs; i++) {
+		ice_di_get_job_dvfs_req(jg->job_list[i].di_hjob, &bw,
+				&r2i, &i2i);
+		if (i && bw <= ddr_bw)
+			continue;
+
+		ddr_bw = bw;
+		ring_to_ice_ratio = r2i;
+		ice_to_ice_ratio = i2i;
+	}
+
+	ret = sphpb_cbs->get_efficient_ice_list(ntw->ntw_icemask, ddr_bw,
+			ring_to_ice_ratio, ice_to_ice_ratio,
+			ice_array, NUM_ICE_UNIT);
+	if (ret) {
+		cve_os_log(CVE_LOGLEVEL_DEBUG,
+			"get_efficient_ice_list failed (%d)\n", ret);
+		return;
+	}
+
+	/* entries not filled by the callback are 0, which is ICE0, so stop
+	 * at the first index that is repeated or out of range
+	 */
+	for (i = 0; i < NUM_ICE_UNIT; i++) {
+		if (ice_array[i] >= NUM_ICE_UNIT ||
+			ntw->ice_place_rank[ice_array[i]])
+			break;
+		ntw->ice_place_rank[ice_array[i]] = NUM_ICE_UNIT - i;
+	}
+
+	ntw->ice_place_ranked = true;
+}
+
+/* Score an idle ICE of the network as placement candidate */
+static u32 __ice_placement_score(struct ice_network *ntw,
+		struct cve_device *dev)
+{
+	u32 score = 0;
+	struct cve_device *sibling;
+
+	/* Network state is intact, no reset or page table reload needed */
+	if ((dev->fifo_desc == &ntw->fifo_desc[dev->dev_index]) &&
+		!cve_di_get_device_reset_flag(dev))
+		score |= ICE_PLACE_SCORE_WARM;
+
+	/* No power up latency */
+	if ((dev->power_state == ICE_POWER_ON) ||
+		(dev->power_state == ICE_POWER_OFF_INITIATED))
+		score |= ICE_PLACE_SCORE_POWERED;
+
+	/* Power balancer knows the ICEBO frequencies, prefer its choice */
+	if (ntw->ice_place_rank[dev->dev_index]) {
+		score |= ICE_PLACE_SCORE_EFFICIENT;
+		score |= ntw->ice_place_rank[dev->dev_index];
+	}
+
+	if (ntw->ice_place_ranked)
+		return score;
+
+	/* Packing into an active ICEBO lets other ICEBOs stay powered off */
+	sibling = cve_dle_next(dev, bo_list);
+	if ((sibling != dev) &&
+		((sibling->state == CVE_DEVICE_BUSY) ||
+		(sibling->power_state == ICE_POWER_ON)))
+		score |= ICE_PLACE_SCORE_BO_ACTIVE;
+
+	return score;
+}
+
+static void __ice_placement_update_swc(struct ice_network *ntw, u32 score)
+{
+	ice_swc_counter_inc(ntw->hswc,
+		ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED);
+
+	if (score & ICE_PLACE_SCORE_WARM)
+		ice_swc_counter_inc(ntw->hswc,
+			ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_WARM);
+	if (score & ICE_PLACE_SCORE_POWERED)
+		ice_swc_counter_inc(ntw->hswc,
+			ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_POWERED);
+	if (score & ICE_PLACE_SCORE_BO_ACTIVE)
+		ice_swc_counter_inc(ntw->hswc,
+			ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_BO_ACTIVE);
+	if (score & ICE_PLACE_SCORE_EFFICIENT)
+		ice_swc_counter_inc(ntw->hswc,
+			ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_EFFICIENT);
+}
+
 static struct cve_device *
 find_idle_device_for_next_job(
 		struct cve_device_group *dg,
@@ -831,6 +973,8 @@ find_idle_device_for_next_job(
 	struct cve_device *head, *next;
 	int is_complete_bo_required = 0, bo_id = 0;
 	int  temp, ice_id = NUM_ICE_UNIT;
+	u32 score, best_score = 0;
+	u64 ice_mask = 0;
 
 	ntw = jobgroup->network;
 	job = jobgroup->next_dispatch;
@@ -903,22 +1047,28 @@ find_idle_device_for_next_job(
 	}
 
 
+	/* Pick the best scored among the eligible idle ICEs */
 	head = ntw->ice_list;
 	next = head;
 	do {
-		if (next->state == CVE_DEVICE_IDLE) {
+		if ((next->state == CVE_DEVICE_IDLE) &&
+			((ntw->icebo_req != ICEBO_MANDATORY) ||
+			((is_complete_bo_required == 1) &&
+		(ntw->pjob_info.picebo[next->dev_index / 2] == 1))))
+			ice_mask |= (1ULL << next->dev_index);
 
-			if ((ntw->icebo_req == ICEBO_MANDATORY) &&
-			(is_complete_bo_required == 1) &&
-		(ntw->pjob_info.picebo[next->dev_index / 2] == 1)) {
+		next = cve_dle_next(next, owner_list);
 
-				cve_dev = next;
-				goto out;
+	} while (head != next);
 
-			} else if (ntw->icebo_req != ICEBO_MANDATORY) {
+	next = head;
+	do {
+		if (ice_mask & (1ULL << next->dev_index)) {
 
+			score = __ice_placement_score(ntw, next);
+			if (!cve_dev || (score > best_score)) {
 				cve_dev = next;
-				goto out;
+				best_score = score;
 			}
 		}
 
@@ -926,6 +1076,13 @@ find_idle_device_for_next_job(
 
 	} while (head != next);
 
+	if (cve_dev) {
+		cve_os_log(CVE_LOGLEVEL_DEBUG,
+			"Placed Job on ICE_HwID:%u Score:0x%x. NtwID:0x%llx\n",
+			cve_dev->dev_index, best_score, ntw->network_id);
+		__ice_placement_update_swc(ntw, best_score);
+	}
+
 out:
 
 	ASSERT(cve_dev);
@@ -975,6 +1132,8 @@ static int __dispatch_single_job(
 	/* Mark the device as busy */
 	cve_dev->state = CVE_DEVICE_BUSY;
 
+	cve_dev->pmon_sampling = (ntw->pmon_ring != NULL);
+
 	/* do reset if needed */
 	if (cve_di_get_device_reset_flag(cve_dev)) {
 		cve_os_dev_log(CVE_LOGLEVEL_DEBUG,
@@ -1008,6 +1167,10 @@ static int __dispatch_single_job(
 
 		/* invalidate the page table if needed */
 		cve_mm_invalidate_tlb(hdom, cve_dev);
+
+		/* sampling may have started after the last reset */
+		if (cve_dev->pmon_sampling)
+			cve_di_set_hw_counters(cve_dev);
 	}
 
 	/* Device FIFO pointer will now point to Network's ICE specific FIFO */
@@ -1273,6 +1436,69 @@ static void __reset_network_state(struct ice_network *ntw)
 	ntw->jg_list->aborted_jobs_nr = 0;
 }
 
+/* track the run time of the network, as the slowest ICE of an Infer */
+static void __update_ntw_exec_stats(struct ice_network *ntw,
+	u64 max_ice_cycle)
+{
+	u32 freq_mhz = 0;
+
+	if (ntw->ice_list)
+		freq_mhz = ntw->ice_list->frequency;
+
+	ice_exec_stats_add(&ntw->exec_stats,
+		ice_exec_stats_cycles_to_us(max_ice_cycle, freq_mhz));
+}
+
+/* track the run time of the jobs of an Infer on one ICE */
+static void __update_ice_exec_stats(struct ice_network *ntw,
+	struct cve_device *dev, u64 exec_time)
+{
+	struct ice_exec_stats *stats = &ntw->ice_exec_stats[dev->dev_index];
+	u32 exec_us = ice_exec_stats_cycles_to_us(exec_time, dev->frequency);
+
+	/* a slow ICE shows up as jobs far above their own history */
+	if (stats->samples_nr >= ICE_EXEC_STATS_SLOW_MIN_SAMPLES &&
+		exec_us > 2 * stats->ewma_us)
+		ice_swc_counter_inc(dev->hswc_infer,
+			ICEDRV_SWC_INFER_DEVICE_COUNTER_SLOW_EXEC_COUNT);
+
+	ice_exec_stats_add(stats, exec_us);
+
+	ice_swc_counter_set(dev->hswc_infer,
+		ICEDRV_SWC_INFER_DEVICE_COUNTER_EXEC_TIME_EWMA,
+		stats->ewma_us);
+	ice_swc_counter_set(dev->hswc_infer,
+		ICEDRV_SWC_INFER_DEVICE_COUNTER_EXEC_TIME_P50,
+		ice_exec_stats_pct(stats, 50));
+	ice_swc_counter_set(dev->hswc_infer,
+		ICEDRV_SWC_INFER_DEVICE_COUNTER_EXEC_TIME_P99,
+		ice_exec_stats_pct(stats, 99));
+}
+
+static void __sample_pmon(struct ice_network *ntw,
+	struct cve_device *dev, u64 exec_time)
+{
+	struct ice_pmon_sample *sample = ice_pmon_ring_next(ntw->pmon_ring);
+	u32 i;
+
+	sample->infer_id = ntw->curr_exe->infer_id;
+	sample->exec_cycles = exec_time;
+	sample->ice_id = dev->dev_index;
+
+	for (i = 0; i < ICE_PMON_SAMPLE_MMU_NR; i++)
+		sample->mmu_pmon[i] = dev->mmu_pmon[i].pmon_value;
+
+	for (i = 0; i < ICE_PMON_SAMPLE_DELPHI_NR; i++)
+		sample->delphi_pmon[i] = dev->delphi_pmon[i].pmon_value;
+
+	sample->reserved = 0;
+}
+
+u32 ice_ds_ntw_predict_runtime_us(struct ice_network *ntw)
+{
+	return ntw->exec_stats.ewma_us;
+}
+
 int ice_ds_raise_event(struct ice_network *ntw,
 	enum cve_jobs_group_status status,
 	bool reschedule)
@@ -1300,6 +1526,8 @@ int ice_ds_raise_event(struct ice_network *ntw,
 	} else {
 		abort = CVE_JOBSGROUPSTATUS_COMPLETED;
 		trace_status = SPH_TRACE_OP_STATUS_MAX;
+
+		__update_ntw_exec_stats(ntw, max_ice_cycle);
 	}
 
 	DO_TRACE(trace_icedrvExecuteNetwork(
@@ -1354,7 +1582,30 @@ int ice_ds_raise_event(struct ice_network *ntw,
 		ice_sch_engine(ntw);
 
 	if (ntw->produce_completion) {
+		struct cve_get_event ring_event;
 
+		/* Ring consumers do not go through WAIT_FOR_EVENT, so the
+		 * event is not queued when it could be posted to the ring.
+		 * Per Infer waits are rejected while the ring is enabled.
+		 */
+		if (context->process->cring_enabled) {
+			memset(&ring_event, 0, sizeof(ring_event));
+			__copy_event_data(&event, &ring_event);
+			ring_event.contextid = context->context_id;
+			ring_event.networkid = ntw->network_id;
+			ring_event.wait_status = CVE_WAIT_EVENT_COMPLETE;
+
+			if (cve_context_process_post_cring(context->process,
+						&ring_event)) {
+				cve_os_log(CVE_LOGLEVEL_INFO,
+					"Posted completion to ring for NtwID:0x%llx InferID:%llx. Status:%s\n",
+					ntw->network_id, inf->infer_id,
+					get_cve_jobs_group_status_str(abort));
+				cve_os_wakeup(
+					&context->process->events_wait_queue);
+				goto trace_event;
+			}
+		}
 
 		if (context->process->events) {
 			event_ptr = context->process->events;
@@ -1383,6 +1634,7 @@ int ice_ds_raise_event(struct ice_network *ntw,
 		cve_os_wakeup(&wq->context->process->events_wait_queue);
 		cve_os_wakeup(&inf->events_wait_queue);
 
+trace_event:
 		DO_TRACE(trace_icedrvEventGeneration(SPH_TRACE_OP_STATE_ADD,
 					ntw->wq->context->swc_node.sw_id,
 					ntw->swc_node.parent_sw_id,
@@ -2341,11 +2593,16 @@ static int __destroy_network(struct ice_network *ntw)
 	__block_ice_if_on(ntw);
 	__destroy_pending_inference(ntw);
 
+	/* Withdraw Reserve/Release requests not served yet */
+	ice_sch_del_rr_from_queue(&ntw->ntw_res_node);
+	ice_sch_del_rr_from_queue(&ntw->ntw_rel_node);
+
 	/* All resource must be released */
 	if (ntw->res_resource)
 		ice_ds_ntw_release_resource(ntw);
 	else
 		ice_ds_ntw_return_resource(ntw);
+	__ntw_drop_sticky_resource(ntw);
 
 	dealloc_and_unmap_network_fifo(ntw);
 
@@ -2365,6 +2622,9 @@ static int __destroy_network(struct ice_network *ntw)
 	cve_dev_close_all_contexts(ntw->dev_hctx_list);
 	ice_swc_destroy_ntw_node(ntw);
 
+	if (ntw->pmon_ring)
+		OS_FREE(ntw->pmon_ring, sizeof(*ntw->pmon_ring));
+
 out:
 	return ret;
 }
@@ -2387,14 +2647,72 @@ static void __update_ntw_sw_id(
 }
 
 
+/*
+ * Unlocked part of network creation: copy the descriptor lists from user
+ * space and pin the user buffers into the registration cache, so that the
+ * locked part only finds them there.
+ */
+static int __prepare_network_desc(
+		struct ice_network_descriptor *network_desc,
+		struct cve_surface_descriptor **out_buf_desc_list,
+		struct cve_job_group **out_jg_desc_list)
+{
+	struct cve_surface_descriptor *k_buf_desc_list;
+	struct cve_job_group *jg_desc_list;
+	u32 sz, i;
+	int retval;
+
+	sz = (sizeof(*k_buf_desc_list) * network_desc->num_buf_desc);
+	retval = __alloc_and_copy(network_desc->buf_desc_list,
+		sz, (void **)&k_buf_desc_list);
+	if (retval < 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+			"__alloc_and_copy() %d\n",
+			retval);
+		goto out;
+	}
+
+	sz = (sizeof(*jg_desc_list) * network_desc->num_jg_desc);
+	retval = __alloc_and_copy(network_desc->jg_desc_list,
+		sz, (void **)&jg_desc_list);
+	if (retval < 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+			"__alloc_and_copy() %d\n",
+			retval);
+		sz = (sizeof(*k_buf_desc_list) * network_desc->num_buf_desc);
+		OS_FREE(k_buf_desc_list, sz);
+		goto out;
+	}
+
+	/* failures are reported again when the buffer is mapped */
+	for (i = 0; i < network_desc->num_buf_desc; i++)
+		cve_mm_prefetch_buffer(&k_buf_desc_list[i]);
+
+	*out_buf_desc_list = k_buf_desc_list;
+	*out_jg_desc_list = jg_desc_list;
+out:
+	return retval;
+}
+
+static void __release_network_desc(
+		struct ice_network_descriptor *network_desc,
+		struct cve_surface_descriptor *k_buf_desc_list,
+		struct cve_job_group *jg_desc_list)
+{
+	OS_FREE(jg_desc_list,
+		sizeof(*jg_desc_list) * network_desc->num_jg_desc);
+	OS_FREE(k_buf_desc_list,
+		sizeof(*k_buf_desc_list) * network_desc->num_buf_desc);
+}
+
 static int __process_network_desc(
 		struct ice_network_descriptor *network_desc,
+		struct cve_surface_descriptor *k_buf_desc_list,
+		struct cve_job_group *jg_desc_list,
 		struct ice_network *network)
 {
 	struct ice_network *ntw = network;
-	struct cve_job_group *jg_desc_list;
-	struct cve_surface_descriptor *k_buf_desc_list;
-	u32 sz, i;
+	u32 i;
 	int retval = 0;
 	struct cve_device_group *dg = cve_dg_get();
 
@@ -2416,9 +2734,21 @@ static int __process_network_desc(
 		goto out;
 	}
 
-	ntw->produce_completion = network_desc->produce_completion;
+	if (network_desc->produce_completion &
+		(ICE_NTW_FLAGS_AREA & ~ICE_NTW_FLAGS_MASK)) {
+		retval = -EINVAL;
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+			"Error(%d) Unknown network flags:0x%x\n",
+			retval, network_desc->produce_completion &
+			ICE_NTW_FLAGS_AREA);
+		goto out;
+	}
+
+	ntw->produce_completion =
+		network_desc->produce_completion & ~ICE_NTW_FLAGS_AREA;
 	ntw->num_ice = network_desc->num_ice;
 	ntw->has_resource = 0;
+	ntw->sticky_resource = false;
 	ntw->cntr_bitmap = 0;
 	ntw->ice_list = NULL;
 	ntw->cntr_list = NULL;
@@ -2428,6 +2758,10 @@ static int __process_network_desc(
 	ntw->num_dicebo_req = 0;
 	ntw->network_type = network_desc->network_type;
 	ntw->shared_read = network_desc->shared_read;
+	ntw->hybrid_poll = !!(network_desc->produce_completion &
+			ICE_NTW_FLAG_HYBRID_POLL);
+	memset(&ntw->exec_stats, 0, sizeof(ntw->exec_stats));
+	memset(ntw->ice_exec_stats, 0, sizeof(ntw->ice_exec_stats));
 	ntw->infer_buf_count = network_desc->infer_buf_count;
 	ntw->ntw_surf_pp_count = 0;
 	for (i = 0; i < MAX_CVE_DEVICES_NR; i++) {
@@ -2456,19 +2790,6 @@ static int __process_network_desc(
 		"Creating new Network. CtxID:%llu, NtwID:0x%llx\n",
 		ntw->wq->context->context_id, ntw->network_id);
 
-	/* Allocate memory and copy buffer descriptor list
-	* from user space
-	*/
-	sz = (sizeof(*k_buf_desc_list) * network_desc->num_buf_desc);
-	retval = __alloc_and_copy(network_desc->buf_desc_list,
-		sz, (void **)&k_buf_desc_list);
-	if (retval < 0) {
-		cve_os_log(CVE_LOGLEVEL_ERROR,
-			"__alloc_and_copy() %d\n",
-			retval);
-		goto out;
-	}
-
 	ntw->num_buf = network_desc->num_buf_desc;
 	ntw->buf_desc_list = k_buf_desc_list;
 	retval = __process_buf_desc_list(ntw, k_buf_desc_list);
@@ -2476,7 +2797,7 @@ static int __process_network_desc(
 		cve_os_log_default(CVE_LOGLEVEL_ERROR,
 			"__process_buf_desc_list() %d\n",
 			retval);
-		goto error_buf_desc_process;
+		goto out;
 	}
 
 	if (network_desc->is_ice_dump_enabled) {
@@ -2493,19 +2814,6 @@ static int __process_network_desc(
 	} else
 		ntw->ice_dump = NULL;
 
-	/* Allocate memory and copy job group descriptor list
-	 * from user space
-	*/
-	sz = (sizeof(*jg_desc_list) * network_desc->num_jg_desc);
-	retval = __alloc_and_copy(network_desc->jg_desc_list,
-		sz, (void **)&jg_desc_list);
-	if (retval < 0) {
-		cve_os_log(CVE_LOGLEVEL_ERROR,
-			"__alloc_and_copy() %d\n",
-			retval);
-		goto error_jg_desc_copy;
-	}
-
 	ntw->num_jg = network_desc->num_jg_desc;
 
 	for (i = 0; i < NUM_ICE_UNIT; i++) {
@@ -2550,12 +2858,6 @@ static int __process_network_desc(
 		goto err_fifo_alloc;
 	}
 
-	sz = (sizeof(*jg_desc_list) * network_desc->num_jg_desc);
-	OS_FREE(jg_desc_list, sz);
-
-	sz = (sizeof(*k_buf_desc_list) * network_desc->num_buf_desc);
-	OS_FREE(k_buf_desc_list, sz);
-
 	__update_ntw_sw_id(network_desc, ntw);
 	cve_os_log(CVE_LOGLEVEL_DEBUG,
 			"Network processing completed. NtwID:0x%llx, BufferCount:%d, JG_Count:%d\n",
@@ -2569,16 +2871,10 @@ error_jg_desc_process:
 
 	__destroy_pp_mirror_image(&ntw->ntw_surf_pp_list);
 
-	sz = (sizeof(*jg_desc_list) * network_desc->num_jg_desc);
-	OS_FREE(jg_desc_list, network_desc->num_jg_desc);
-error_jg_desc_copy:
 	if (ntw->ice_dump != NULL)
 		__destroy_ice_dump_buffer(ntw);
 error_ice_dump_buf_process:
 	__destroy_buf_list(ntw, ntw->buf_list, ntw->num_buf);
-error_buf_desc_process:
-	sz = (sizeof(*k_buf_desc_list) * network_desc->num_buf_desc);
-	OS_FREE(k_buf_desc_list, sz);
 out:
 	return retval;
 }
@@ -2588,6 +2884,8 @@ static void __destroy_infer_desc(struct ice_infer *inf)
 	u32 idx;
 	 struct ice_pp_value *pp_arr = inf->inf_pp_arr;
 
+	ice_mm_destroy_inf_cb_copies(inf);
+
 	for (idx = 0; idx < inf->num_buf; idx++) {
 		cve_mm_destroy_infer_buffer(inf->infer_id,
 			&inf->buf_list[idx]);
@@ -2600,6 +2898,9 @@ static void __destroy_infer_desc(struct ice_infer *inf)
 	if (pp_arr)
 		OS_FREE(pp_arr,
 			sizeof(*pp_arr) * inf->ntw->ntw_surf_pp_count);
+
+	if (inf->ntw->last_patched_inf == inf)
+		inf->ntw->last_patched_inf = NULL;
 }
 
 static int __process_infer_desc(
@@ -2663,6 +2964,16 @@ static int __process_infer_desc(
 			goto destroy_infer;
 		}
 
+		if (ice_enable_inf_cb_copy()) {
+			retval = ice_mm_create_inf_cb_copies(inf);
+			if (retval < 0) {
+				cve_os_log_default(CVE_LOGLEVEL_ERROR,
+					"ice_mm_create_inf_cb_copies failed %d\n",
+					retval);
+				goto destroy_infer;
+			}
+		}
+
 		/* Flush the inference surfaces */
 		__flush_inf_buffers(inf);
 	}
@@ -2699,6 +3010,9 @@ int cve_ds_handle_create_network(
 	struct cve_workqueue *workqueue = NULL;
 	struct cve_device_group *dg = cve_dg_get();
 	struct cve_device *dev = ice_get_first_dev();
+	struct cve_surface_descriptor *k_buf_desc_list = NULL;
+	struct cve_job_group *jg_desc_list = NULL;
+	struct timespec start_ts, prepared_ts, done_ts;
 	u32 ntw_resources[6];
 
 	ntw_resources[0] = network_desc->llc_size[ICE_CLOS_0];
@@ -2708,10 +3022,22 @@ int cve_ds_handle_create_network(
 	ntw_resources[4] = network_desc->num_ice;
 	ntw_resources[5] = 0;
 
+	getnstimeofday(&start_ts);
+
+	retval = __prepare_network_desc(network_desc, &k_buf_desc_list,
+			&jg_desc_list);
+	if (retval < 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"__prepare_network_desc() failed:%d\n", retval);
+		goto out_unlocked;
+	}
+
+	getnstimeofday(&prepared_ts);
+
 	retval = cve_os_lock(&g_cve_driver_biglock, CVE_INTERRUPTIBLE);
 	if (retval != 0) {
 		retval = -ERESTARTSYS;
-		goto out;
+		goto release_desc;
 	}
 
 	retval = __get_wq_from_contex_pid(context_pid, context_id, &workqueue);
@@ -2760,8 +3086,11 @@ int cve_ds_handle_create_network(
 	network->ntw_res_node.ntype = NODE_TYPE_RESERVE;
 	network->ntw_rel_node.ntw = network;
 	network->ntw_rel_node.ntype = NODE_TYPE_RELEASE;
+	network->ntw_res_node.is_queued = false;
+	network->ntw_rel_node.is_queued = false;
 	network->rr_node = NULL;
 	network->res_resource = false;
+	network->pmon_ring = NULL;
 	network->exIR_performed = 0;
 	network->reset_ntw = false;
 
@@ -2775,7 +3104,8 @@ int cve_ds_handle_create_network(
 		goto error_domain_creation;
 	}
 
-	retval = __process_network_desc(network_desc, network);
+	retval = __process_network_desc(network_desc, k_buf_desc_list,
+			jg_desc_list, network);
 	if (retval < 0) {
 		cve_os_log(CVE_LOGLEVEL_ERROR,
 				"__process_network_desc() failed:%d\n", retval);
@@ -2807,6 +3137,14 @@ int cve_ds_handle_create_network(
 			ICEDRV_SWC_SUB_NETWORK_TOTAL_JOBS,
 			network->jg_list->total_jobs);
 
+	getnstimeofday(&done_ts);
+	ice_swc_counter_set(network->hswc,
+			ICEDRV_SWC_SUB_NETWORK_COUNTER_CREATE_PREPARE_TIME,
+			ice_get_usec_timediff(&prepared_ts, &start_ts));
+	ice_swc_counter_set(network->hswc,
+			ICEDRV_SWC_SUB_NETWORK_COUNTER_CREATE_COMMIT_TIME,
+			ice_get_usec_timediff(&done_ts, &prepared_ts));
+
 
 	ntw_resources[0] = network->clos[ICE_CLOS_0];
 	ntw_resources[1] = network->clos[ICE_CLOS_1];
@@ -2824,6 +3162,8 @@ int cve_ds_handle_create_network(
 
 	cve_os_unlock(&g_cve_driver_biglock);
 
+	__release_network_desc(network_desc, k_buf_desc_list, jg_desc_list);
+
 	return retval;
 
 error_resources:
@@ -2834,8 +3174,9 @@ error_domain_creation:
 	OS_FREE(network, sizeof(*network));
 out:
 	cve_os_unlock(&g_cve_driver_biglock);
-
-
+release_desc:
+	__release_network_desc(network_desc, k_buf_desc_list, jg_desc_list);
+out_unlocked:
 	ntw_resources[0] = network_desc->llc_size[ICE_CLOS_0];
 	ntw_resources[1] = network_desc->llc_size[ICE_CLOS_1];
 	ntw_resources[2] = network_desc->llc_size[ICE_CLOS_2];
@@ -3149,6 +3490,9 @@ int cve_ds_handle_manage_resource(
 
 			/* TODO: Add Ntw resource info [ICE-18719] */
 
+			/* Timed out while pending, withdraw the request */
+			ice_sch_del_rr_from_queue(&ntw->ntw_res_node);
+
 			ntw->last_request_type = NODE_TYPE_RELEASE;
 
 			retval = -ICEDRV_KERROR_RESERVATION_FAIL;
@@ -3179,34 +3523,21 @@ out:
 	return retval;
 }
 
-int cve_ds_handle_execute_infer(cve_context_process_id_t context_pid,
+/* Validates the ExecuteInfer request and adds the inference to the
+ * scheduler queue. Scheduler is not triggered here. Must be called with
+ * g_cve_driver_biglock held.
+ */
+static int __queue_infer(cve_context_process_id_t context_pid,
 		cve_context_id_t context_id,
 		cve_network_id_t ntw_id,
 		cve_infer_id_t inf_id,
-		struct ice_execute_infer_data *data) {
-
-	int retval = CVE_DEFAULT_ERROR_CODE;
+		struct ice_execute_infer_data *data)
+{
+	int retval = 0;
 	struct ice_infer *inf;
 	struct ice_network *ntw;
 	struct cve_device_group *dg = cve_dg_get();
 
-	DO_TRACE(trace_icedrvExecuteNetwork(
-				SPH_TRACE_OP_STATE_REQ,
-				context_id, 0, 0, ntw_id, inf_id,
-				SPH_TRACE_OP_STATUS_LOCATION, __LINE__));
-
-	retval = cve_os_lock(&g_cve_driver_biglock, CVE_INTERRUPTIBLE);
-	if (retval != 0) {
-		retval = -ERESTARTSYS;
-		DO_TRACE(trace_icedrvExecuteNetwork(
-				SPH_TRACE_OP_STATE_START,
-				context_id, 0, 0, ntw_id, inf_id,
-				SPH_TRACE_OP_STATUS_FAIL, retval));
-
-		goto err_lock;
-	}
-
-
 	if (dg->icedc_state == ICEDC_STATE_CARD_RESET_REQUIRED) {
 		retval = -ICEDRV_KERROR_CARD_RESET_NEEDED;
 		cve_os_log(CVE_LOGLEVEL_ERROR,
@@ -3260,13 +3591,7 @@ int cve_ds_handle_execute_infer(cve_context_process_id_t context_pid,
 	cve_os_log(CVE_LOGLEVEL_DEBUG,
 		"Processing ExecuteInfer. NtwID:0x%lx, InfID=0x%lx\n",
 		(uintptr_t)ntw, (uintptr_t)inf);
-	ice_sch_add_inf_to_queue(inf);
-
-	cve_os_log(CVE_LOGLEVEL_DEBUG,
-		"Completed ExecuteInfer. NtwID:0x%lx, InfID=0x%lx\n",
-		(uintptr_t)ntw, (uintptr_t)inf);
-
-	cve_os_unlock(&g_cve_driver_biglock);
+	ice_sch_enqueue_inf(inf);
 
 	return retval;
 
@@ -3275,23 +3600,141 @@ err_sanity:
 				SPH_TRACE_OP_STATE_START,
 				context_id, 0, 0, ntw_id, inf_id,
 				SPH_TRACE_OP_STATUS_FAIL, retval));
-
 out:
-	cve_os_unlock(&g_cve_driver_biglock);
-
-
-err_lock:
-	DO_TRACE(trace_icedrvExecuteNetwork(
-		SPH_TRACE_OP_STATE_ABORT, context_id, 0, 0,
-		ntw_id, inf_id,
-		SPH_TRACE_OP_STATUS_FAIL,
-		retval));
-
 	return retval;
-
 }
 
-int cve_ds_handle_destroy_network(cve_context_process_id_t context_pid,
+int cve_ds_handle_execute_infer(cve_context_process_id_t context_pid,
+		cve_context_id_t context_id,
+		cve_network_id_t ntw_id,
+		cve_infer_id_t inf_id,
+		struct ice_execute_infer_data *data) {
+
+	int retval = CVE_DEFAULT_ERROR_CODE;
+
+	DO_TRACE(trace_icedrvExecuteNetwork(
+				SPH_TRACE_OP_STATE_REQ,
+				context_id, 0, 0, ntw_id, inf_id,
+				SPH_TRACE_OP_STATUS_LOCATION, __LINE__));
+
+	retval = cve_os_lock(&g_cve_driver_biglock, CVE_INTERRUPTIBLE);
+	if (retval != 0) {
+		retval = -ERESTARTSYS;
+		DO_TRACE(trace_icedrvExecuteNetwork(
+				SPH_TRACE_OP_STATE_START,
+				context_id, 0, 0, ntw_id, inf_id,
+				SPH_TRACE_OP_STATUS_FAIL, retval));
+
+		goto err_lock;
+	}
+
+	retval = __queue_infer(context_pid, context_id, ntw_id, inf_id, data);
+	if (retval < 0)
+		goto out;
+
+	ice_sch_trigger();
+
+	cve_os_log(CVE_LOGLEVEL_DEBUG,
+		"Completed ExecuteInfer. NtwID:0x%llx, InfID=0x%llx\n",
+		ntw_id, inf_id);
+
+	cve_os_unlock(&g_cve_driver_biglock);
+
+	return retval;
+
+out:
+	cve_os_unlock(&g_cve_driver_biglock);
+
+
+err_lock:
+	DO_TRACE(trace_icedrvExecuteNetwork(
+		SPH_TRACE_OP_STATE_ABORT, context_id, 0, 0,
+		ntw_id, inf_id,
+		SPH_TRACE_OP_STATUS_FAIL,
+		retval));
+
+	return retval;
+
+}
+
+int cve_ds_handle_execute_infer_batch(cve_context_process_id_t context_pid,
+		struct ice_execute_infer_batch *batch)
+{
+	int retval = 0;
+	u32 i, sz;
+	struct cve_execute_infer *k_infers = NULL;
+
+	batch->num_queued = 0;
+
+	if (batch->num_infers == 0 ||
+		batch->num_infers > ICE_MAX_BATCH_ENTRIES) {
+		retval = -EINVAL;
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"ERROR:%d Invalid batch size %u\n",
+				retval, batch->num_infers);
+		goto out;
+	}
+
+	/* Single copy of the whole request array, outside the lock */
+	sz = batch->num_infers * sizeof(*k_infers);
+	retval = __alloc_and_copy((void *)(uintptr_t)batch->infers,
+			sz, (void **)&k_infers);
+	if (retval < 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"ERROR:%d __alloc_and_copy() failed for ExecuteInfer batch\n",
+				retval);
+		goto out;
+	}
+
+	retval = cve_os_lock(&g_cve_driver_biglock, CVE_INTERRUPTIBLE);
+	if (retval != 0) {
+		retval = -ERESTARTSYS;
+		goto free_mem;
+	}
+
+	/* Entries are queued in order. On first failure stop, and let the
+	 * already queued ones run. User learns the failing index from
+	 * num_queued.
+	 */
+	for (i = 0; i < batch->num_infers; i++) {
+		struct cve_execute_infer *p = &k_infers[i];
+
+		DO_TRACE(trace_icedrvExecuteNetwork(
+				SPH_TRACE_OP_STATE_REQ,
+				p->contextid, 0, 0, p->networkid, p->inferid,
+				SPH_TRACE_OP_STATUS_LOCATION, __LINE__));
+
+		retval = __queue_infer(context_pid, p->contextid,
+				p->networkid, p->inferid, &p->data);
+		if (retval < 0) {
+			DO_TRACE(trace_icedrvExecuteNetwork(
+				SPH_TRACE_OP_STATE_ABORT, p->contextid, 0, 0,
+				p->networkid, p->inferid,
+				SPH_TRACE_OP_STATUS_FAIL,
+				retval));
+			break;
+		}
+
+		batch->num_queued++;
+	}
+
+	/* One scheduler pass for the whole batch */
+	if (batch->num_queued)
+		ice_sch_trigger();
+
+	cve_os_log(CVE_LOGLEVEL_DEBUG,
+		"Completed ExecuteInfer batch. Queued=%u/%u\n",
+		batch->num_queued, batch->num_infers);
+
+	cve_os_unlock(&g_cve_driver_biglock);
+
+free_mem:
+	OS_FREE(k_infers, sz);
+out:
+	return retval;
+}
+
+int cve_ds_handle_destroy_network(cve_context_process_id_t context_pid,
 		cve_context_id_t context_id,
 		cve_context_id_t ntw_id) {
 	int retval = CVE_DEFAULT_ERROR_CODE;
@@ -3425,6 +3868,12 @@ void cve_ds_handle_job_completion(struct cve_device *dev,
 	inf = ntw->curr_exe;
 
 	ntw->ntw_exec_time[dev->dev_index] = exec_time;
+	if (job_status != CVE_JOBSTATUS_ABORTED)
+		__update_ice_exec_stats(ntw, dev, exec_time);
+
+	/* PMONs were read by the ISR-BH if the job was sampled */
+	if (ntw->pmon_ring && dev->pmon_sampling)
+		__sample_pmon(ntw, dev, exec_time);
 
 	/* Mark the device as idle */
 	dev->state = CVE_DEVICE_IDLE;
@@ -3556,6 +4005,7 @@ int cve_ds_handle_fw_loading(
 	 * according to number of CVEs in the system
 	 */
 	retval = cve_dev_fw_load_and_map(network->dev_hctx_list,
+			context_id,
 			fw_image,
 			fw_binmap,
 			fw_binmap_size_bytes);
@@ -3863,6 +4313,50 @@ out:
 	return retval;
 }
 
+#ifndef RING3_VALIDATION
+/*
+ * Spin until the Infer has an event or its expected run time (plus a
+ * quarter for jitter) has passed, saving the sleep and wake up for
+ * short networks. Returns true if the event arrived while polling.
+ */
+static bool __hybrid_poll_infer(struct ice_network *ntw,
+		struct ice_infer *inf)
+{
+	struct timespec start_ts, curr_ts;
+	u32 exp_us = ice_ds_ntw_predict_runtime_us(ntw);
+	u32 budget_us = exp_us + (exp_us >> 2);
+	u64 elapsed_us;
+
+	if (!exp_us || budget_us > ICE_HYBRID_POLL_MAX_US)
+		return false;
+
+	getnstimeofday(&start_ts);
+	do {
+		if (READ_ONCE(inf->infer_events)) {
+			ice_swc_counter_atomic_inc(ntw->hswc,
+				ICEDRV_SWC_SUB_NETWORK_COUNTER_HYBRID_POLL_HIT);
+			return true;
+		}
+
+		cpu_relax();
+		getnstimeofday(&curr_ts);
+		elapsed_us = (curr_ts.tv_sec - start_ts.tv_sec) * USEC_PER_SEC +
+			(curr_ts.tv_nsec - start_ts.tv_nsec) / NSEC_PER_USEC;
+	} while (elapsed_us < budget_us);
+
+	ice_swc_counter_atomic_inc(ntw->hswc,
+			ICEDRV_SWC_SUB_NETWORK_COUNTER_HYBRID_POLL_MISS);
+	return false;
+}
+#else
+/* ICE execution is simulated in the waiting thread, nothing to poll */
+static inline bool __hybrid_poll_infer(struct ice_network *ntw,
+		struct ice_infer *inf)
+{
+	return false;
+}
+#endif
+
 static int __handle_infer_completion_via_infer(
 		cve_context_process_id_t context_pid,
 		struct cve_context_process *context_process,
@@ -3873,6 +4367,10 @@ static int __handle_infer_completion_via_infer(
 	u32 timeout_msec = event->timeout_msec;
 	int retval = 0;
 
+	/* on a hit the wait below returns without sleeping */
+	if (inf->ntw->hybrid_poll)
+		__hybrid_poll_infer(inf->ntw, inf);
+
 	retval = cve_os_block_interruptible_timeout(
 			&inf->events_wait_queue,
 			inf->infer_events, timeout_msec);
@@ -3946,6 +4444,19 @@ int cve_ds_wait_for_event(cve_context_process_id_t context_pid,
 		timeout_msec = 0xFFFFFFFF;
 
 	if (!event->infer_id) {
+		/*
+		 * Same as for a per Infer wait, only events which fell back
+		 * from a full ring can be waited on while the ring is enabled.
+		 */
+		if (context_process->cring_enabled &&
+			!context_process->alloc_events) {
+			retval = -EINVAL;
+			cve_os_log_default(CVE_LOGLEVEL_ERROR,
+			"ERROR:%d Context wait not supported with completion ring. CtxID=0x%llx\n",
+			retval, event->contextid);
+			goto unlock;
+		}
+
 		DO_TRACE(trace_icedrvEventGeneration(SPH_TRACE_OP_STATE_START,
 					ctx_sw_id, 0, 0, event->networkid, 0,
 					SPH_TRACE_OP_STATUS_LOCATION,
@@ -3980,6 +4491,19 @@ int cve_ds_wait_for_event(cve_context_process_id_t context_pid,
 			goto unlock;
 		}
 
+		/*
+		 * Completions are posted to the ring without being queued on
+		 * the Infer, a per Infer wait would never be woken up. Only
+		 * events queued before the ring was enabled can be waited on.
+		 */
+		if (context_process->cring_enabled && !inf->infer_events) {
+			retval = -EINVAL;
+			cve_os_log_default(CVE_LOGLEVEL_ERROR,
+			"ERROR:%d Per Infer wait not supported with completion ring. InfID=0x%llx\n",
+			retval, event->infer_id);
+			goto unlock;
+		}
+
 		DO_TRACE(trace_icedrvEventGeneration(SPH_TRACE_OP_STATE_START,
 					ntw->wq->context->swc_node.sw_id,
 					ntw->swc_node.parent_sw_id,
@@ -4009,6 +4533,131 @@ out:
 
 }
 
+int cve_ds_wait_for_event_batch(cve_context_process_id_t context_pid,
+		struct ice_wait_event_batch *batch)
+{
+	struct cve_context_process *context_process = NULL;
+	struct cve_get_event *k_events = NULL;
+	u32 timeout_msec = batch->timeout_msec;
+	u32 sz = 0;
+	int retval = 0, lock_ret = 0;
+
+	batch->num_events = 0;
+	batch->wait_status = CVE_WAIT_EVENT_ERROR;
+
+	if (batch->max_events == 0 ||
+		batch->max_events > ICE_MAX_BATCH_ENTRIES) {
+		retval = -EINVAL;
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"ERROR:%d Invalid batch size %u\n",
+				retval, batch->max_events);
+		goto out;
+	}
+
+	sz = batch->max_events * sizeof(*k_events);
+	retval = OS_ALLOC_ZERO(sz, (void **)&k_events);
+	if (retval < 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"Allocation failed:%d SZ:%d\n", retval, sz);
+		goto out;
+	}
+
+	retval = cve_os_lock(&g_cve_driver_biglock, CVE_INTERRUPTIBLE);
+	if (retval != 0) {
+		retval = -ERESTARTSYS;
+		goto free_mem;
+	}
+
+	retval = cve_context_process_get(context_pid, &context_process);
+	if (retval != 0)
+		goto unlock;
+
+	if (!get_context_from_process(context_process, batch->contextid)) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+			"ERROR: CTXPID:0x%llx CTXID:0x%llx get_context_from_process failed\n",
+			context_pid, batch->contextid);
+		retval = -ICEDRV_KERROR_CTX_INVAL_ID;
+		goto unlock;
+	}
+
+	if (context_process->cring_enabled &&
+		!context_process->alloc_events) {
+		retval = -EINVAL;
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"ERROR:%d Batch wait not supported with completion ring\n",
+				retval);
+		goto unlock;
+	}
+	cve_os_unlock(&g_cve_driver_biglock);
+
+	/*in case debug enabled don't timeout (~1000hours)*/
+	if (unlikely(cve_debug_get(DEBUG_TENS_EN)))
+		timeout_msec = 0xFFFFFFFF;
+
+	/* Block only for the first event, then reap whatever else is
+	 * already available without sleeping again.
+	 */
+	do {
+		retval = cve_os_block_interruptible_timeout(
+				&context_process->events_wait_queue,
+				context_process->alloc_events, timeout_msec);
+		if (retval <= 0)
+			break;
+
+		lock_ret = cve_os_lock(&g_cve_driver_biglock,
+				CVE_INTERRUPTIBLE);
+		if (lock_ret != 0) {
+			retval = -ERESTARTSYS;
+			break;
+		}
+
+		while (context_process->alloc_events &&
+			batch->num_events < batch->max_events) {
+			struct cve_get_event *event =
+				&k_events[batch->num_events];
+
+			event->contextid = batch->contextid;
+			event->timeout_msec = batch->timeout_msec;
+			event->infer_id = 0;
+			copy_event_data_and_remove(context_pid,
+					context_process,
+					batch->contextid, NULL,
+					event);
+			event->wait_status = CVE_WAIT_EVENT_COMPLETE;
+			batch->num_events++;
+		}
+
+		cve_os_unlock(&g_cve_driver_biglock);
+	} while (!batch->num_events);
+
+	if (retval == 0) {
+		cve_os_log_default(CVE_LOGLEVEL_ERROR, "Timeout\n");
+		batch->wait_status = CVE_WAIT_EVENT_TIMEOUT;
+		goto free_mem;
+	} else if (retval < 0) {
+		goto free_mem;
+	}
+
+	batch->wait_status = CVE_WAIT_EVENT_COMPLETE;
+	retval = cve_os_write_user_memory(
+			(void *)(uintptr_t)batch->events,
+			batch->num_events * sizeof(*k_events),
+			k_events);
+	if (retval != 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"os_write_user_memory failed %d\n", retval);
+		retval = -EFAULT;
+	}
+	goto free_mem;
+
+unlock:
+	cve_os_unlock(&g_cve_driver_biglock);
+free_mem:
+	OS_FREE(k_events, sz);
+out:
+	return retval;
+}
+
 int cve_ds_get_version(cve_context_process_id_t context_pid,
 		cve_context_id_t context_id,
 		cve_network_id_t ntw_id,
@@ -4479,6 +5128,8 @@ static void __ntw_release_cntr(struct ice_network *ntw)
 		cve_dle_move(dg->hw_cntr_list, ntw->cntr_list, list, head);
 
 		head->in_free_pool = true;
+		/* overflow of a free counter is nobody's error */
+		head->cntr_ntw_id = INVALID_NETWORK_ID;
 		dg->num_avl_cntr++;
 
 		cve_os_log(CVE_LOGLEVEL_DEBUG,
@@ -4504,57 +5155,364 @@ static void __ntw_reset_cntr(struct ice_network *ntw)
 	}
 }
 
-static int __ntw_reserve_clos(struct ice_network *ntw)
+static u64 __ntw_cntr_mask(struct ice_network *ntw)
 {
-	int ret = 0;
+	u64 mask = 0;
+	struct cve_hw_cntr_descriptor *head = ntw->cntr_list;
+	struct cve_hw_cntr_descriptor *next = head;
+
+	if (!head)
+		return 0;
+
+	do {
+		mask |= (1ULL << next->hw_cntr_id);
+		next = cve_dle_next(next, list);
+	} while (head != next);
+
+	return mask;
+}
+
+static bool __ntw_ices_powered(struct ice_network *ntw)
+{
+	bool powered = true;
 	struct cve_device_group *dg = cve_dg_get();
-	struct clos_manager *mclos = &dg->dg_clos_manager;
+	struct cve_device *dev = ntw->ice_list;
 
-	cve_os_log(CVE_LOGLEVEL_DEBUG,
-			"Reserving LLC for NtwID=0x%llx: Required(%u, %u, %u, %u)\n",
-			ntw->network_id,
-			ntw->clos[0], ntw->clos[1], ntw->clos[2], ntw->clos[3]);
+	if (cve_os_lock(&dg->poweroff_dev_list_lock, CVE_INTERRUPTIBLE)) {
+		cve_os_log(CVE_LOGLEVEL_ERROR, "cve_os_lock error\n");
+		return false;
+	}
 
-	mclos->clos_size[ICE_CLOS_1] = ntw->clos[ICE_CLOS_1];
-	mclos->clos_size[ICE_CLOS_2] = ntw->clos[ICE_CLOS_2];
-	mclos->clos_size[ICE_CLOS_0] = (MAX_CLOS_SIZE_MB -
-					(ntw->clos[ICE_CLOS_1] +
-					ntw->clos[ICE_CLOS_2]));
+	do {
+		if (dev->power_state == ICE_POWER_OFF) {
+			powered = false;
+			break;
+		}
 
-	ASSERT(mclos->clos_size[ICE_CLOS_0] >= 3);
+		dev = cve_dle_next(dev, owner_list);
+	} while (dev != ntw->ice_list);
 
-	return ret;
+	cve_os_unlock(&dg->poweroff_dev_list_lock);
+
+	return powered;
 }
 
-static int __is_pool_required(struct ice_network *ntw)
+/* Kinds of resource a Ntw is short of */
+#define NTW_SHORT_ICE (1 << 0)
+#define NTW_SHORT_CNTR (1 << 1)
+#define NTW_SHORT_POOL (1 << 2)
+#define NTW_SHORT_ALL (NTW_SHORT_ICE | NTW_SHORT_CNTR | NTW_SHORT_POOL)
+
+/* Check the ICE requirement of the Ntw as ice_dg_adjust_ntw_ice_req() and
+ * ice_dg_check_resource_availability() would with the given free BOs
+ */
+static bool __ntw_ices_fit(struct ice_network *ntw, u32 pbo, u32 dice)
 {
-	return ntw->cntr_bitmap ? 1 : 0;
+	u32 num_ice_req = (2 * ntw->cached_num_picebo_req) +
+				ntw->cached_num_dicebo_req;
+
+	if (ntw->cached_icebo_req == ICEBO_MANDATORY ||
+		(ntw->cached_icebo_req != ICEBO_DEFAULT &&
+		ntw->cached_num_picebo_req <= pbo))
+		return (ntw->cached_num_picebo_req <= pbo &&
+			ntw->cached_num_dicebo_req <= dice);
+
+	return (num_ice_req <= (2 * pbo) + dice);
 }
 
-enum resource_status ice_ds_ntw_reserve_resource(struct ice_network *ntw)
+static u32 __ntw_shortfall(struct ice_network *ntw)
 {
-	enum resource_status status = RESOURCE_OK;
 	struct cve_device_group *dg = cve_dg_get();
-	struct cve_device *dev;
+	u32 count = 0, shortfall = 0;
 
-	if (ntw->res_resource) {
+	if (!ntw->has_resource &&
+		!__ntw_ices_fit(ntw, dg->in_pool_pbo, dg->in_pool_dice))
+		shortfall |= NTW_SHORT_ICE;
 
-		cve_os_log(CVE_LOGLEVEL_DEBUG,
-			"Resources already reserved. NtwID=0x%lx\n",
-			(uintptr_t)ntw);
-		status = RESOURCE_OK;
-		goto out;
-	}
+	__local_builtin_popcount(ntw->cntr_bitmap, count);
+	if (count > dg->num_avl_cntr)
+		shortfall |= NTW_SHORT_CNTR;
 
-	/* If !has_resource => Borrow */
-	if (!ntw->has_resource) {
+	if (__is_pool_required(ntw) &&
+		ntw->wq->context->pool_id == INVALID_POOL_ID &&
+		!dg->num_avl_pool)
+		shortfall |= NTW_SHORT_POOL;
 
-		status = ice_ds_ntw_borrow_resource(ntw);
-		if (status != RESOURCE_OK)
-			goto out;
-	}
+	return shortfall;
+}
 
-	cve_os_log(CVE_LOGLEVEL_DEBUG,
+/* Number of idle Ntws of the WQ that keep the Pool of its Context */
+static u32 __wq_sticky_pool_users(struct cve_workqueue *wq)
+{
+	struct cve_device_group *dg = cve_dg_get();
+	struct ice_network *head = dg->ntw_with_resources;
+	struct ice_network *ntw = head;
+	u32 count = 0;
+
+	if (!head)
+		return 0;
+
+	do {
+		if (ntw->sticky_resource && ntw->wq == wq &&
+			__is_pool_required(ntw))
+			count++;
+
+		ntw = cve_dle_next(ntw, resource_list);
+	} while (ntw != head);
+
+	return count;
+}
+
+/*
+ * Check if the idle Ntw keeps a resource of a kind in the shortfall. Its
+ * Pool only counts if the idle Ntws of its WQ are the only Pool users.
+ */
+static bool __sticky_ntw_covers(struct ice_network *ntw, u32 shortfall)
+{
+	if (!ntw->sticky_resource)
+		return false;
+
+	if (shortfall & NTW_SHORT_ICE)
+		return true;
+
+	if ((shortfall & NTW_SHORT_CNTR) && ntw->cntr_list)
+		return true;
+
+	if ((shortfall & NTW_SHORT_POOL) && __is_pool_required(ntw) &&
+		__wq_sticky_pool_users(ntw->wq) == ntw->wq->num_ntw_using_pool)
+		return true;
+
+	return false;
+}
+
+/* Check if the Ntw would fit once every idle Ntw covering the shortfall
+ * gave its resources back
+ */
+static bool __sticky_ntws_can_fit(struct ice_network *ntw, u32 shortfall)
+{
+	struct cve_device_group *dg = cve_dg_get();
+	struct ice_network *head = dg->ntw_with_resources;
+	struct ice_network *victim = head;
+	struct cve_device *dev;
+	u8 bo_ice[MAX_NUM_ICEBO];
+	u32 i, count = 0, pbo = 0, dice = 0;
+	u32 num_cntr = dg->num_avl_cntr;
+	bool pool = false;
+
+	if (!head)
+		return false;
+
+	for (i = 0; i < MAX_NUM_ICEBO; i++)
+		bo_ice[i] = dg->dev_info.icebo_list[i].in_pool_ice;
+
+	do {
+		if (!__sticky_ntw_covers(victim, shortfall))
+			goto next;
+
+		dev = victim->ice_list;
+		do {
+			bo_ice[dev->dev_index / 2]++;
+			dev = cve_dle_next(dev, owner_list);
+		} while (dev != victim->ice_list);
+
+		if (victim->cntr_list) {
+			__local_builtin_popcount(victim->cntr_bitmap, count);
+			num_cntr += count;
+		}
+
+		if (__is_pool_required(victim) &&
+			__wq_sticky_pool_users(victim->wq) ==
+			victim->wq->num_ntw_using_pool)
+			pool = true;
+next:
+		victim = cve_dle_next(victim, resource_list);
+	} while (victim != head);
+
+	for (i = 0; i < MAX_NUM_ICEBO; i++) {
+		if (bo_ice[i] == TWO_ICE)
+			pbo++;
+		else if (bo_ice[i] == ONE_ICE)
+			dice++;
+	}
+
+	if ((shortfall & NTW_SHORT_ICE) && !__ntw_ices_fit(ntw, pbo, dice))
+		return false;
+
+	__local_builtin_popcount(ntw->cntr_bitmap, count);
+	if ((shortfall & NTW_SHORT_CNTR) && count > num_cntr)
+		return false;
+
+	if ((shortfall & NTW_SHORT_POOL) && !pool)
+		return false;
+
+	return true;
+}
+
+static void __evict_sticky_ntw(struct ice_network *ntw)
+{
+	cve_os_log(CVE_LOGLEVEL_DEBUG,
+		"Evicting kept resources. NtwID=0x%lx\n",
+		(uintptr_t)ntw);
+
+	ice_swc_counter_inc(ntw->hswc,
+		ICEDRV_SWC_SUB_NETWORK_COUNTER_STICKY_MISS);
+	__ntw_drop_sticky_resource(ntw);
+}
+
+/*
+ * Give the resources kept by idle Ntws back to the DG until the given kinds
+ * of resource the Ntw needs are available. Only idle Ntws keeping a kind
+ * the Ntw is short of are evicted, oldest first, and none is if the Ntw
+ * would not fit even with all of them evicted, as when the shortfall is
+ * held by running or reserved Ntws.
+ */
+static void __evict_sticky_for_ntw(struct ice_network *ntw, u32 kinds)
+{
+	struct cve_device_group *dg = cve_dg_get();
+	struct ice_network *head, *victim;
+	u32 shortfall = __ntw_shortfall(ntw) & kinds;
+
+	if (!shortfall || !__sticky_ntws_can_fit(ntw, shortfall))
+		return;
+
+	while (shortfall && dg->ntw_with_resources) {
+		head = dg->ntw_with_resources;
+		victim = head;
+
+		/* list changes on every eviction, restart from its head */
+		do {
+			if (__sticky_ntw_covers(victim, shortfall))
+				break;
+			victim = cve_dle_next(victim, resource_list);
+		} while (victim != head);
+
+		if (!__sticky_ntw_covers(victim, shortfall))
+			break;
+
+		__evict_sticky_ntw(victim);
+		shortfall = __ntw_shortfall(ntw) & kinds;
+	}
+}
+
+void ice_ds_ntw_drop_sticky_resource(struct ice_network *ntw)
+{
+	if (ntw->sticky_resource)
+		__evict_sticky_ntw(ntw);
+}
+
+void ice_ds_drop_sticky_resources(void)
+{
+	struct cve_device_group *dg = cve_dg_get();
+	struct ice_network *head, *ntw;
+
+	while (dg->ntw_with_resources) {
+		head = dg->ntw_with_resources;
+		ntw = head;
+
+		do {
+			if (ntw->sticky_resource)
+				break;
+			ntw = cve_dle_next(ntw, resource_list);
+		} while (ntw != head);
+
+		if (!ntw->sticky_resource)
+			break;
+
+		__evict_sticky_ntw(ntw);
+	}
+}
+
+/*
+ * Counters of a reserved Ntw are bound to it only while it has work on the
+ * ICEs, so that other Ntws can use them between its Inferences. When the
+ * previous Counters are still free they are captured again without
+ * patching.
+ */
+static enum resource_status __ntw_bind_cntr(struct ice_network *ntw)
+{
+	struct cve_device_group *dg = cve_dg_get();
+	u32 count = 0;
+
+	if (!ntw->cntr_bitmap || ntw->cntr_list)
+		return RESOURCE_OK;
+
+	__evict_sticky_for_ntw(ntw, NTW_SHORT_CNTR);
+
+	__local_builtin_popcount(ntw->cntr_bitmap, count);
+	if (count > dg->num_avl_cntr) {
+		cve_os_log(CVE_LOGLEVEL_DEBUG,
+			"Counters not available. NtwID=0x%lx\n",
+			(uintptr_t)ntw);
+		return RESOURCE_BUSY;
+	}
+
+	ASSERT(__ntw_reserve_cntr(ntw) == 0);
+	__link_counters_and_pool(ntw);
+	ntw->ntw_cntrmask = __ntw_cntr_mask(ntw);
+
+	return RESOURCE_OK;
+}
+
+static void __ntw_unbind_cntr(struct ice_network *ntw)
+{
+	if (!ntw->cntr_list)
+		return;
+
+	__ntw_release_cntr(ntw);
+	ntw->ntw_cntrmask = 0;
+}
+
+static int __ntw_reserve_clos(struct ice_network *ntw)
+{
+	int ret = 0;
+	struct cve_device_group *dg = cve_dg_get();
+	struct clos_manager *mclos = &dg->dg_clos_manager;
+
+	cve_os_log(CVE_LOGLEVEL_DEBUG,
+			"Reserving LLC for NtwID=0x%llx: Required(%u, %u, %u, %u)\n",
+			ntw->network_id,
+			ntw->clos[0], ntw->clos[1], ntw->clos[2], ntw->clos[3]);
+
+	mclos->clos_size[ICE_CLOS_1] = ntw->clos[ICE_CLOS_1];
+	mclos->clos_size[ICE_CLOS_2] = ntw->clos[ICE_CLOS_2];
+	mclos->clos_size[ICE_CLOS_0] = (MAX_CLOS_SIZE_MB -
+					(ntw->clos[ICE_CLOS_1] +
+					ntw->clos[ICE_CLOS_2]));
+
+	ASSERT(mclos->clos_size[ICE_CLOS_0] >= 3);
+
+	return ret;
+}
+
+static int __is_pool_required(struct ice_network *ntw)
+{
+	return ntw->cntr_bitmap ? 1 : 0;
+}
+
+enum resource_status ice_ds_ntw_reserve_resource(struct ice_network *ntw)
+{
+	enum resource_status status = RESOURCE_OK;
+	struct cve_device_group *dg = cve_dg_get();
+	struct cve_device *dev;
+
+	if (ntw->res_resource) {
+
+		cve_os_log(CVE_LOGLEVEL_DEBUG,
+			"Resources already reserved. NtwID=0x%lx\n",
+			(uintptr_t)ntw);
+		status = RESOURCE_OK;
+		goto out;
+	}
+
+	/* If !has_resource => Borrow, kept resources are reused there */
+	if (!ntw->has_resource || ntw->sticky_resource) {
+
+		status = ice_ds_ntw_borrow_resource(ntw);
+		if (status != RESOURCE_OK)
+			goto out;
+	}
+
+	cve_os_log(CVE_LOGLEVEL_DEBUG,
 		"Reserving resources. NtwID=0x%lx\n",
 		(uintptr_t)ntw);
 
@@ -4569,8 +5527,11 @@ enum resource_status ice_ds_ntw_reserve_resource(struct ice_network *ntw)
 		dev = cve_dle_next(dev, owner_list);
 	} while (dev != ntw->ice_list);
 
-	/* Counter */
-	dg->num_nonres_cntr -= __builtin_popcount(ntw->cntr_bitmap);
+	/* Counters are not reserved, they are bound at dispatch */
+	if (!ntw->ntw_running) {
+		__delink_counters_and_pool(ntw);
+		__ntw_unbind_cntr(ntw);
+	}
 
 	/* Pool */
 	if (__is_pool_required(ntw)) {
@@ -4589,20 +5550,56 @@ out:
 	return status;
 }
 
+static enum resource_status __check_ntw_resource(struct ice_network *ntw)
+{
+	/* WARNING: This value may change in Lazy Capture */
+	ntw->num_picebo_req = ntw->cached_num_picebo_req;
+	ntw->num_dicebo_req = ntw->cached_num_dicebo_req;
+	ntw->icebo_req = ntw->cached_icebo_req;
+
+	/* Update ICE requirement before checking for ICE availability*/
+	if (ntw->icebo_req != ICEBO_MANDATORY)
+		ice_dg_adjust_ntw_ice_req(ntw);
+
+	return ice_dg_check_resource_availability(ntw);
+}
+
 enum resource_status ice_ds_ntw_borrow_resource(struct ice_network *ntw)
 {
 	enum resource_status status = RESOURCE_OK;
 	enum pool_status pstatus = POOL_EXIST;
 	struct cve_device *head, *next;
-	struct cve_hw_cntr_descriptor *head_cntr, *next_cntr;
 	struct cve_device_group *dg = cve_dg_get();
 	u64 ntwIceMask = 0;
 	u64 ntwCntrMask = 0;
 
+	if (ntw->sticky_resource) {
+
+		ntw->sticky_resource = false;
+
+		/* ICEs, Counters and Pool are still linked to this Ntw */
+		if (__ntw_ices_powered(ntw)) {
+			ice_swc_counter_inc(ntw->hswc,
+				ICEDRV_SWC_SUB_NETWORK_COUNTER_STICKY_HIT);
+			cve_os_log(CVE_LOGLEVEL_DEBUG,
+				"Reusing kept resources. NtwID=0x%lx\n",
+				(uintptr_t)ntw);
+			goto end;
+		}
+
+		/* ICEs lost their state, capture them again for a cold run */
+		ice_swc_counter_inc(ntw->hswc,
+			ICEDRV_SWC_SUB_NETWORK_COUNTER_STICKY_MISS);
+		__ntw_drop_resource(ntw);
+	}
+
 	if (ntw->has_resource) {
 		cve_os_log(CVE_LOGLEVEL_DEBUG,
 			"Resources already borrowed. NtwID=0x%lx\n",
 			(uintptr_t)ntw);
+
+		/* Reserved Ntw gives its Counters back while idle */
+		status = __ntw_bind_cntr(ntw);
 		goto end;
 	}
 
@@ -4613,9 +5610,16 @@ enum resource_status ice_ds_ntw_borrow_resource(struct ice_network *ntw)
 				ntw->swc_node.sw_id, ntw->network_id,
 				ntw->num_ice, ntw->cntr_bitmap, ntw->clos));
 
+	/*
+	 * Make room before mapping the Pool, as evicting a Ntw of this
+	 * context may unmap it.
+	 */
+	__evict_sticky_for_ntw(ntw, NTW_SHORT_ALL);
+
 	if (__is_pool_required(ntw)) {
 
 		pstatus = cve_ds_map_pool_context(ntw->wq->context);
+
 		if (pstatus == POOL_EXHAUSTED) {
 
 			if (dg->num_nonres_pool == 0)
@@ -4635,16 +5639,7 @@ enum resource_status ice_ds_ntw_borrow_resource(struct ice_network *ntw)
 			(uintptr_t)ntw);
 	}
 
-	/* WARNING: This value may change in Lazy Capture */
-	ntw->num_picebo_req = ntw->cached_num_picebo_req;
-	ntw->num_dicebo_req = ntw->cached_num_dicebo_req;
-	ntw->icebo_req = ntw->cached_icebo_req;
-
-	/* Update ICE requirement before checking for ICE availability*/
-	if (ntw->icebo_req != ICEBO_MANDATORY)
-		ice_dg_adjust_ntw_ice_req(ntw);
-
-	status = ice_dg_check_resource_availability(ntw);
+	status = __check_ntw_resource(ntw);
 	if (status != RESOURCE_OK) {
 
 		cve_os_log(CVE_LOGLEVEL_DEBUG,
@@ -4682,18 +5677,13 @@ enum resource_status ice_ds_ntw_borrow_resource(struct ice_network *ntw)
 		next = cve_dle_next(next, owner_list);
 	} while (head != next);
 
-	head_cntr = ntw->cntr_list;
-	if (head_cntr != NULL) {
-		next_cntr = head_cntr;
-		do {
-			ntwCntrMask |= (1ULL << next_cntr->hw_cntr_id);
-			next_cntr = cve_dle_next(next_cntr, list);
-		} while (head_cntr != next_cntr);
-	}
+	ntwCntrMask = __ntw_cntr_mask(ntw);
 
 	ntw->ntw_icemask = ntwIceMask;
 	ntw->ntw_cntrmask = ntwCntrMask;
 
+	__ice_placement_rank(ntw);
+
 	DO_TRACE(trace_icedrvNetworkResource(
 				SPH_TRACE_OP_STATE_COMPLETE,
 				ntw->wq->context->swc_node.sw_id,
@@ -4734,16 +5724,17 @@ static void __power_off_ntw_devices(struct ice_network *ntw)
 	/*
 	 * When PowerOff thread has nothing to do, it wakes up every 60 sec.
 	 * This is the only function that assigns work to PO thread.
-	 * Wake up this thread if currently its queue is empty, else, anyways
-	 * it will wake-up in sometime to turn off the already queued ices.
+	 * Every ICE is queued with its own power off delay which may expire
+	 * before the ones already queued, so wake up the thread whenever an
+	 * ICE is added to let it recompute its timeout.
 	 */
-	wakeup_po_thread = (dg->poweroff_dev_list == NULL);
-
 	do {
 		if (next->power_state == ICE_POWER_ON) {
 
 			/* Write current timestamp to Device */
 			next->poweroff_ts = curr_ts;
+			ice_pm_gov_idle_start(next);
+			wakeup_po_thread = true;
 
 			ice_dev_set_power_state(next, ICE_POWER_OFF_INITIATED);
 			ice_swc_counter_set(next->hswc,
@@ -4797,9 +5788,6 @@ void ice_ds_ntw_release_resource(struct ice_network *ntw)
 		dev = cve_dle_next(dev, owner_list);
 	} while (dev != ntw->ice_list);
 
-	/* Counter */
-	dg->num_nonres_cntr += __builtin_popcount(ntw->cntr_bitmap);
-
 	/* Pool */
 	if (__is_pool_required(ntw)) {
 
@@ -4823,11 +5811,73 @@ out:
 	return;
 }
 
-void ice_ds_ntw_return_resource(struct ice_network *ntw)
+/* Give all resources of a non reserved Ntw back to the DG */
+static void __ntw_drop_resource(struct ice_network *ntw)
 {
 	struct cve_device_group *dg = cve_dg_get();
 
-	if (!ntw->has_resource) {
+	if (__is_pool_required(ntw))
+		__delink_resource_and_pool(ntw);
+
+	DO_TRACE(trace__icedrvResourceRelease(
+			SPH_TRACE_OP_STATE_START,
+			ntw->wq->context->swc_node.sw_id,
+			ntw->swc_node.parent_sw_id,
+			ntw->swc_node.sw_id, ntw->network_id,
+			ntw->res_resource, ntw->ntw_icemask,
+			ntw->ntw_cntrmask, ntw->clos));
+
+	cve_os_log(CVE_LOGLEVEL_DEBUG,
+		"Releasing resources. NtwID=0x%lx\n",
+		(uintptr_t)ntw);
+
+	__ntw_release_ice(ntw);
+	ntw->ntw_icemask = 0;
+
+	__ntw_unbind_cntr(ntw);
+
+	if (__is_pool_required(ntw)) {
+		ntw->wq->num_ntw_using_pool--;
+
+		if (!ntw->wq->num_ntw_using_pool) {
+
+			cve_di_unset_pool_registers(
+				ntw->wq->context->pool_id);
+			cve_ds_unmap_pool_context(
+				ntw->wq->context);
+		}
+	}
+
+	cve_dle_remove_from_list(dg->ntw_with_resources,
+		resource_list, ntw);
+
+	ntw->has_resource = 0;
+
+	cve_os_log(CVE_LOGLEVEL_INFO,
+		"Resources released. NtwID:0x%lx\n",
+		(uintptr_t)ntw);
+
+	DO_TRACE(trace__icedrvResourceRelease(
+			SPH_TRACE_OP_STATE_COMPLETE,
+			ntw->wq->context->swc_node.sw_id,
+			ntw->swc_node.parent_sw_id,
+			ntw->swc_node.sw_id, ntw->network_id,
+			ntw->res_resource, ntw->ntw_icemask,
+			ntw->ntw_cntrmask, ntw->clos));
+}
+
+static void __ntw_drop_sticky_resource(struct ice_network *ntw)
+{
+	if (!ntw->sticky_resource)
+		return;
+
+	ntw->sticky_resource = false;
+	__ntw_drop_resource(ntw);
+}
+
+void ice_ds_ntw_return_resource(struct ice_network *ntw)
+{
+	if (!ntw->has_resource || ntw->sticky_resource) {
 		cve_os_log(CVE_LOGLEVEL_DEBUG,
 			"No resource to return. NtwID=0x%lx\n",
 			(uintptr_t)ntw);
@@ -4844,59 +5894,30 @@ void ice_ds_ntw_return_resource(struct ice_network *ntw)
 	/* Once workload is over, placing ICEs in Power-off queue */
 	__power_off_ntw_devices(ntw);
 
-	/* If reservation not required then release all resources*/
-	if (!ntw->res_resource && __is_pool_required(ntw))
-		__delink_resource_and_pool(ntw);
-
 	if (!ntw->res_resource) {
-		DO_TRACE(trace__icedrvResourceRelease(
-				SPH_TRACE_OP_STATE_START,
-				ntw->wq->context->swc_node.sw_id,
-				ntw->swc_node.parent_sw_id,
-				ntw->swc_node.sw_id, ntw->network_id,
-				ntw->res_resource, ntw->ntw_icemask,
-				ntw->ntw_cntrmask, ntw->clos));
-
-		cve_os_log(CVE_LOGLEVEL_DEBUG,
-			"Releasing resources. NtwID=0x%lx\n",
-			(uintptr_t)ntw);
-
-		__ntw_release_ice(ntw);
-		ntw->ntw_icemask = 0;
 
-		__ntw_release_cntr(ntw);
-		ntw->ntw_cntrmask = 0;
-
-		if (__is_pool_required(ntw)) {
-			ntw->wq->num_ntw_using_pool--;
-
-			if (!ntw->wq->num_ntw_using_pool) {
+		/*
+		 * Keep the resources linked so that the next Inference does
+		 * not capture them again. They are given back when another
+		 * Ntw needs them.
+		 */
+		if (ice_enable_sticky_resource()) {
+			ntw->sticky_resource = true;
 
-				cve_di_unset_pool_registers(
-					ntw->wq->context->pool_id);
-				cve_ds_unmap_pool_context(
-					ntw->wq->context);
-			}
+			cve_os_log(CVE_LOGLEVEL_DEBUG,
+				"Keeping resources. NtwID=0x%lx\n",
+				(uintptr_t)ntw);
+			goto end;
 		}
 
-		cve_dle_remove_from_list(dg->ntw_with_resources,
-			resource_list, ntw);
-
-		ntw->has_resource = 0;
-
-		cve_os_log(CVE_LOGLEVEL_INFO,
-			"Resources released. NtwID:0x%lx\n",
-			(uintptr_t)ntw);
-
-		DO_TRACE(trace__icedrvResourceRelease(
-				SPH_TRACE_OP_STATE_COMPLETE,
-				ntw->wq->context->swc_node.sw_id,
-				ntw->swc_node.parent_sw_id,
-				ntw->swc_node.sw_id, ntw->network_id,
-				ntw->res_resource, ntw->ntw_icemask,
-				ntw->ntw_cntrmask, ntw->clos));
+		/* If reservation not required then release all resources*/
+		__ntw_drop_resource(ntw);
 		return;
 	}
+	/* Reserved Ntw keeps ICEs and Pool, Counters are shared */
+	__delink_counters_and_pool(ntw);
+	__ntw_unbind_cntr(ntw);
+
 	cve_os_log(CVE_LOGLEVEL_INFO,
 		"Not releasing resources. NtwID:0x%lx\n",
 		(uintptr_t)ntw);
@@ -5254,6 +6275,9 @@ int ice_ds_reset_network(cve_context_process_id_t context_pid,
 
 		if (ntw->reserved_on_error)
 			ice_ds_ntw_release_resource(ntw);
+
+		/* ICEs kept from before the error are not reused as is */
+		__ntw_drop_sticky_resource(ntw);
 	} else {
 		/* Network Reset not required */
 		retval = -ICEDRV_KERROR_NTW_RESET_NA;
@@ -5265,6 +6289,145 @@ out:
 	return retval;
 }
 
+int ice_ds_predict_runtime(cve_context_process_id_t context_pid,
+		struct ice_predict_runtime_params *params)
+{
+	int retval = CVE_DEFAULT_ERROR_CODE;
+	struct ice_network *ntw;
+
+	retval = cve_os_lock(&g_cve_driver_biglock, CVE_INTERRUPTIBLE);
+	if (retval != 0) {
+		retval = -ERESTARTSYS;
+		goto out;
+	}
+
+	ntw = __get_network_from_id(context_pid, params->contextid,
+			params->networkid);
+	if (ntw == NULL) {
+		retval = -ICEDRV_KERROR_NTW_INVAL_ID;
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"ERROR:%d Given NtwID:0x%llx is not present in this context\n",
+				retval, params->networkid);
+		goto unlock_out;
+	}
+
+	params->predicted_us = ice_ds_ntw_predict_runtime_us(ntw);
+	params->p50_us = ice_exec_stats_pct(&ntw->exec_stats, 50);
+	params->p99_us = ice_exec_stats_pct(&ntw->exec_stats, 99);
+	params->samples_nr = ntw->exec_stats.samples_nr;
+
+unlock_out:
+	cve_os_unlock(&g_cve_driver_biglock);
+out:
+	return retval;
+}
+
+/* move the oldest samples of the ring to the user buffer */
+static int __read_pmon_samples(struct ice_network *ntw,
+		struct ice_pmon_samples_params *params)
+{
+	struct ice_pmon_ring *ring = ntw->pmon_ring;
+	struct ice_pmon_sample *sample;
+	struct ice_pmon_sample *dst =
+		(struct ice_pmon_sample *)(uintptr_t)params->samples;
+	u32 nr;
+	int ret;
+
+	params->lost_nr = ring->lost_nr;
+	ring->lost_nr = 0;
+
+	while (params->samples_nr < params->max_samples) {
+
+		sample = ice_pmon_ring_peek(ring, &nr);
+		if (!nr)
+			break;
+
+		if (nr > params->max_samples - params->samples_nr)
+			nr = params->max_samples - params->samples_nr;
+
+		ret = cve_os_write_user_memory(&dst[params->samples_nr],
+				nr * sizeof(*sample), sample);
+		if (ret < 0) {
+			cve_os_log(CVE_LOGLEVEL_ERROR,
+				"cve_os_write_user_memory failed %d\n", ret);
+			return ret;
+		}
+
+		ice_pmon_ring_consume(ring, nr);
+		params->samples_nr += nr;
+	}
+
+	return 0;
+}
+
+int ice_ds_pmon_samples(cve_context_process_id_t context_pid,
+		struct ice_pmon_samples_params *params)
+{
+	int retval = CVE_DEFAULT_ERROR_CODE;
+	struct ice_network *ntw;
+
+	if (params->sampling > ICE_PMON_SAMPLING_STOP ||
+		(params->max_samples && !params->samples)) {
+		retval = -EINVAL;
+		goto out;
+	}
+
+	retval = cve_os_lock(&g_cve_driver_biglock, CVE_INTERRUPTIBLE);
+	if (retval != 0) {
+		retval = -ERESTARTSYS;
+		goto out;
+	}
+
+	ntw = __get_network_from_id(context_pid, params->contextid,
+			params->networkid);
+	if (ntw == NULL) {
+		retval = -ICEDRV_KERROR_NTW_INVAL_ID;
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"ERROR:%d Given NtwID:0x%llx is not present in this context\n",
+				retval, params->networkid);
+		goto unlock_out;
+	}
+
+	params->samples_nr = 0;
+	params->lost_nr = 0;
+
+	if (ntw->pmon_ring) {
+		retval = __read_pmon_samples(ntw, params);
+		if (retval < 0)
+			goto unlock_out;
+	}
+
+	if (params->sampling == ICE_PMON_SAMPLING_START && !ntw->pmon_ring) {
+
+		retval = OS_ALLOC_ZERO(sizeof(*ntw->pmon_ring),
+				(void **)&ntw->pmon_ring);
+		if (retval < 0) {
+			cve_os_log(CVE_LOGLEVEL_ERROR,
+				"ERROR:%d OS_ALLOC_ZERO failed\n", retval);
+			goto unlock_out;
+		}
+
+		cve_os_log(CVE_LOGLEVEL_INFO,
+			"PMON sampling started. NtwID:0x%llx\n",
+			ntw->network_id);
+
+	} else if (params->sampling == ICE_PMON_SAMPLING_STOP &&
+		ntw->pmon_ring) {
+
+		OS_FREE(ntw->pmon_ring, sizeof(*ntw->pmon_ring));
+		ntw->pmon_ring = NULL;
+
+		cve_os_log(CVE_LOGLEVEL_INFO,
+			"PMON sampling stopped. NtwID:0x%llx\n",
+			ntw->network_id);
+	}
+
+unlock_out:
+	cve_os_unlock(&g_cve_driver_biglock);
+out:
+	return retval;
+}
+
 void ice_ds_block_network(cve_ds_job_handle_t ds_jobh,
 	struct cve_device *dev, u32 status)
 {
@@ -95,6 +95,17 @@ int cve_ds_handle_execute_infer(
 		cve_infer_id_t inf_id,
 		struct ice_execute_infer_data *data);
 
+/*
+ * handle the IOCTL ExecuteInfer batch request. Copies the request array
+ * once, queues every entry under a single lock hold and runs the
+ * scheduler once at the end.
+ * outputs: batch->num_queued - number of leading entries queued
+ * returns: 0 on success, error of the first failing entry otherwise
+ */
+int cve_ds_handle_execute_infer_batch(
+		cve_context_process_id_t context_pid,
+		struct ice_execute_infer_batch *batch);
+
 int cve_ds_handle_destroy_infer(
 		cve_context_process_id_t context_pid,
 		cve_context_id_t context_id,
@@ -169,6 +180,16 @@ void cve_destroy_context(
 int cve_ds_wait_for_event(cve_context_process_id_t context_pid,
 		struct cve_get_event *event);
 
+/**
+ * Retrieve multiple events of the process in one call
+ * Blocks until at least one event is available or timeout, then
+ * returns up to max_events events without blocking further.
+ * inputs:
+ *	batch - [in/out] see ice_wait_event_batch
+ */
+int cve_ds_wait_for_event_batch(cve_context_process_id_t context_pid,
+		struct ice_wait_event_batch *batch);
+
 /**
  * Get version
  * This function retrieve the version of CVE components such as KMD, TLC,
@@ -198,6 +219,35 @@ int ice_ds_reset_network(
 		cve_context_id_t context_id,
 		cve_network_id_t ntw_id);
 
+/**
+ * Predicted run time of an Infer of a network, i.e. of its slowest ICE,
+ * from the run times of its completed Infers. Caller holds the big lock.
+ * inputs:
+ *  ntw - the network
+ * returns: the run time in usec, 0 if no Infer completed yet
+ */
+u32 ice_ds_ntw_predict_runtime_us(struct ice_network *ntw);
+
+/**
+ * Get the run time statistics of a network
+ * inputs:
+ *  context_pid - process id of the calling context
+ *  params - see ice_predict_runtime_params
+ * returns: 0 on success, a negative error code on failure
+ */
+int ice_ds_predict_runtime(cve_context_process_id_t context_pid,
+		struct ice_predict_runtime_params *params);
+
+/**
+ * Read the PMON samples of a network and start or stop sampling
+ * inputs:
+ *  context_pid - process id of the calling context
+ *  params - see ice_pmon_samples_params
+ * returns: 0 on success, a negative error code on failure
+ */
+int ice_ds_pmon_samples(cve_context_process_id_t context_pid,
+		struct ice_pmon_samples_params *params);
+
 #define _no_op_return_zero 0
 #ifdef RING3_VALIDATION
 void *cve_ds_get_di_context(cve_context_id_t context_id);
@@ -223,6 +273,11 @@ void ice_ds_ntw_release_resource(struct ice_network *ntw);
 enum resource_status ice_ds_ntw_borrow_resource(struct ice_network *ntw);
 void ice_ds_ntw_return_resource(struct ice_network *ntw);
 
+/* give the resources kept by the idle Ntw back to the DG, if it keeps any */
+void ice_ds_ntw_drop_sticky_resource(struct ice_network *ntw);
+/* give the resources kept by all idle Ntws back to the DG */
+void ice_ds_drop_sticky_resources(void);
+
 int ice_ds_debug_control(struct ice_debug_control_params *dc);
 
 int ice_di_get_core_blob_sz(void);
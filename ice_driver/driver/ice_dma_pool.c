@@ -0,0 +1,176 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2017-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifdef RING3_VALIDATION
+#include <stdint.h>
+#include <stdint_ext.h>
+#include "linux_kernel_mock.h"
+#else
+#include <linux/types.h>
+#endif
+
+#include "ice_dma_pool.h"
+#include "os_interface.h"
+#include "doubly_linked_list.h"
+#include "ice_sw_counters.h"
+
+/* classes are powers of two from 4KB to 1MB */
+#define ICE_DMA_POOL_MIN_SHIFT 12
+#define ICE_DMA_POOL_MAX_SHIFT 20
+#define ICE_DMA_POOL_CLASS_NR \
+	(ICE_DMA_POOL_MAX_SHIFT - ICE_DMA_POOL_MIN_SHIFT + 1)
+/* free buffers kept per class, the rest go back to the system */
+#define ICE_DMA_POOL_MAX_FREE 32
+/* enough 4KB buffers for the CBDTs of one network on every ICE */
+#define ICE_DMA_POOL_PREFILL_NR 16
+
+/* a free buffer */
+struct ice_dma_pool_buf {
+	struct cve_dle_t list;
+	void *vaddr;
+	struct cve_dma_handle dma_handle;
+};
+
+struct ice_dma_pool_class {
+	struct ice_dma_pool_buf *free_list;
+	u32 free_nr;
+};
+
+static struct ice_dma_pool_class dma_pool[ICE_DMA_POOL_CLASS_NR];
+
+static int __size_to_class(u32 size_bytes)
+{
+	u32 shift = ICE_DMA_POOL_MIN_SHIFT;
+
+	while ((1U << shift) < size_bytes) {
+		if (++shift > ICE_DMA_POOL_MAX_SHIFT)
+			return -1;
+	}
+
+	return shift - ICE_DMA_POOL_MIN_SHIFT;
+}
+
+static inline u32 __class_size(int cls)
+{
+	return 1U << (cls + ICE_DMA_POOL_MIN_SHIFT);
+}
+
+static void __pool_put(struct cve_device *dev, int cls,
+		void *vaddr, struct cve_dma_handle *dma_handle)
+{
+	struct ice_dma_pool_class *c = &dma_pool[cls];
+	struct ice_dma_pool_buf *buf = NULL;
+
+	if (c->free_nr >= ICE_DMA_POOL_MAX_FREE ||
+		OS_ALLOC_ZERO(sizeof(*buf), (void **)&buf) != 0) {
+		OS_FREE_DMA_CONTIG(dev, __class_size(cls), vaddr,
+				dma_handle, 1);
+		return;
+	}
+
+	buf->vaddr = vaddr;
+	buf->dma_handle = *dma_handle;
+	cve_dle_add_to_list_before(c->free_list, list, buf);
+	c->free_nr++;
+}
+
+int ice_dma_pool_init(struct cve_device *dev)
+{
+	struct cve_dma_handle dma_handle;
+	void *vaddr;
+	int retval;
+
+	while (dma_pool[0].free_nr < ICE_DMA_POOL_PREFILL_NR) {
+		retval = OS_ALLOC_DMA_CONTIG(dev, __class_size(0), 1,
+				&vaddr, &dma_handle, 1);
+		if (retval != 0) {
+			cve_os_log(CVE_LOGLEVEL_ERROR,
+					"DMA pool prefill failed %d\n", retval);
+			return retval;
+		}
+		__pool_put(dev, 0, vaddr, &dma_handle);
+	}
+
+	return 0;
+}
+
+void ice_dma_pool_fini(struct cve_device *dev)
+{
+	struct ice_dma_pool_class *c;
+	struct ice_dma_pool_buf *buf;
+	int cls;
+
+	for (cls = 0; cls < ICE_DMA_POOL_CLASS_NR; cls++) {
+		c = &dma_pool[cls];
+		while (c->free_list) {
+			buf = c->free_list;
+			cve_dle_remove_from_list(c->free_list, list, buf);
+			OS_FREE_DMA_CONTIG(dev, __class_size(cls), buf->vaddr,
+					&buf->dma_handle, 1);
+			OS_FREE(buf, sizeof(*buf));
+		}
+		c->free_nr = 0;
+	}
+}
+
+int ice_dma_pool_alloc(struct cve_device *dev,
+		u32 size_bytes,
+		void **out_vaddr,
+		struct cve_dma_handle *out_dma_handle)
+{
+	int cls = __size_to_class(size_bytes);
+	struct ice_dma_pool_class *c;
+	struct ice_dma_pool_buf *buf;
+
+	if (cls < 0)
+		return OS_ALLOC_DMA_CONTIG(dev, size_bytes, 1,
+				out_vaddr, out_dma_handle, 1);
+
+	c = &dma_pool[cls];
+	buf = c->free_list;
+	if (!buf) {
+		ice_swc_counter_inc(g_sph_swc_global,
+				ICEDRV_SWC_GLOBAL_COUNTER_DMA_POOL_MISS);
+		return OS_ALLOC_DMA_CONTIG(dev, __class_size(cls), 1,
+				out_vaddr, out_dma_handle, 1);
+	}
+
+	cve_dle_remove_from_list(c->free_list, list, buf);
+	c->free_nr--;
+
+	*out_vaddr = buf->vaddr;
+	*out_dma_handle = buf->dma_handle;
+	OS_FREE(buf, sizeof(*buf));
+
+	ice_swc_counter_inc(g_sph_swc_global,
+			ICEDRV_SWC_GLOBAL_COUNTER_DMA_POOL_HIT);
+
+	return 0;
+}
+
+void ice_dma_pool_free(struct cve_device *dev,
+		u32 size_bytes,
+		void *vaddr,
+		struct cve_dma_handle *dma_handle)
+{
+	int cls = __size_to_class(size_bytes);
+
+	if (cls < 0) {
+		OS_FREE_DMA_CONTIG(dev, size_bytes, vaddr, dma_handle, 1);
+		return;
+	}
+
+	__pool_put(dev, cls, vaddr, dma_handle);
+}
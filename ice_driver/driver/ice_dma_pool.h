@@ -0,0 +1,75 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2017-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _ICE_DMA_POOL_H_
+#define _ICE_DMA_POOL_H_
+
+#ifdef RING3_VALIDATION
+#include <stdint.h>
+#include <stdint_ext.h>
+#else
+#include <linux/types.h>
+#endif
+
+#include "os_interface.h"
+
+/*
+ * Size class pools of contiguous DMA memory for buffers that the driver
+ * allocates on every network or inference creation (CBDT, CB copies).
+ * Buffers are recycled instead of being returned to the system.
+ * Callers are serialized by the driver big lock.
+ */
+
+/*
+ * preallocate the smallest size class. Called for every device, only the
+ * first call allocates.
+ * inputs : dev - device whose DMA device is used for allocation
+ * returns: 0 on success, a negative error code on failure
+ */
+int ice_dma_pool_init(struct cve_device *dev);
+
+/*
+ * release every pooled buffer to the system
+ * inputs : dev - device whose DMA device is used for allocation
+ */
+void ice_dma_pool_fini(struct cve_device *dev);
+
+/*
+ * take a contiguous DMA buffer (not zeroed) of at least size_bytes, ICE
+ * page aligned. Sizes above the largest class are allocated directly.
+ * inputs : dev - device whose DMA device is used for allocation
+ *          size_bytes - requested size
+ * outputs: out_vaddr - kernel virtual address of the buffer
+ *          out_dma_handle - DMA handle of the buffer
+ * returns: 0 on success, a negative error code on failure
+ */
+int ice_dma_pool_alloc(struct cve_device *dev,
+		u32 size_bytes,
+		void **out_vaddr,
+		struct cve_dma_handle *out_dma_handle);
+
+/*
+ * return a buffer taken with ice_dma_pool_alloc
+ * inputs : dev - device whose DMA device is used for allocation
+ *          size_bytes - size that was passed to ice_dma_pool_alloc
+ *          vaddr - kernel virtual address of the buffer
+ *          dma_handle - DMA handle of the buffer
+ */
+void ice_dma_pool_free(struct cve_device *dev,
+		u32 size_bytes,
+		void *vaddr,
+		struct cve_dma_handle *dma_handle);
+
+#endif /* _ICE_DMA_POOL_H_ */
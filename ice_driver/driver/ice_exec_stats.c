@@ -0,0 +1,126 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2017-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifdef RING3_VALIDATION
+#include <stdint.h>
+#include <stdint_ext.h>
+#include "linux_kernel_mock.h"
+#else
+#include <linux/types.h>
+#endif
+
+#include "ice_exec_stats.h"
+#include "os_interface.h"
+
+/* the histogram is aged once it holds this many samples */
+#define ICE_EXEC_STATS_MAX_SAMPLES 1024
+
+static u32 __bucket_of(u32 us)
+{
+	u32 msb = 0;
+	u32 v = us;
+	u32 idx;
+
+	if (us < (1 << ICE_EXEC_STATS_SUB_BITS))
+		return us;
+
+	while (v > 1) {
+		v >>= 1;
+		msb++;
+	}
+
+	idx = ((msb - ICE_EXEC_STATS_SUB_BITS + 1) << ICE_EXEC_STATS_SUB_BITS) +
+		((us >> (msb - ICE_EXEC_STATS_SUB_BITS)) &
+		((1 << ICE_EXEC_STATS_SUB_BITS) - 1));
+	if (idx >= ICE_EXEC_STATS_BUCKETS)
+		idx = ICE_EXEC_STATS_BUCKETS - 1;
+
+	return idx;
+}
+
+/* middle of the range covered by a bucket */
+static u32 __bucket_value(u32 idx)
+{
+	u32 shift, sub;
+
+	if (idx < (1 << ICE_EXEC_STATS_SUB_BITS))
+		return idx;
+
+	shift = (idx >> ICE_EXEC_STATS_SUB_BITS) - 1;
+	sub = idx & ((1 << ICE_EXEC_STATS_SUB_BITS) - 1);
+
+	return (((1 << ICE_EXEC_STATS_SUB_BITS) + sub) << shift) +
+		((1 << shift) >> 1);
+}
+
+void ice_exec_stats_add(struct ice_exec_stats *stats, u32 exec_us)
+{
+	u32 i;
+
+	if (stats->hist_nr >= ICE_EXEC_STATS_MAX_SAMPLES) {
+		stats->hist_nr = 0;
+		for (i = 0; i < ICE_EXEC_STATS_BUCKETS; i++) {
+			stats->hist[i] >>= 1;
+			stats->hist_nr += stats->hist[i];
+		}
+	}
+
+	stats->hist[__bucket_of(exec_us)]++;
+	stats->hist_nr++;
+	stats->samples_nr++;
+
+	if (!stats->ewma_us)
+		stats->ewma_us = exec_us;
+	else
+		stats->ewma_us = (u32)(((u64)7 * stats->ewma_us +
+					exec_us) / 8);
+}
+
+u32 ice_exec_stats_pct(struct ice_exec_stats *stats, u32 pct)
+{
+	u32 i, rank, sum = 0;
+
+	if (!stats->hist_nr)
+		return 0;
+
+	/* rank of the sample at the percentile, 1 based */
+	rank = (u32)(((u64)stats->hist_nr * pct + 99) / 100);
+	if (!rank)
+		rank = 1;
+
+	for (i = 0; i < ICE_EXEC_STATS_BUCKETS; i++) {
+		sum += stats->hist[i];
+		if (sum >= rank)
+			break;
+	}
+	if (i == ICE_EXEC_STATS_BUCKETS)
+		i--;
+
+	return __bucket_value(i);
+}
+
+u32 ice_exec_stats_cycles_to_us(u64 cycles, u32 freq_mhz)
+{
+	u64 us;
+
+	if (!freq_mhz)
+		freq_mhz = ICE_FREQ_DEFAULT;
+
+	us = cycles / freq_mhz;
+	if (us > 0xFFFFFFFF)
+		return 0xFFFFFFFF;
+
+	return (u32)us;
+}
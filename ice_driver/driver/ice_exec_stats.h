@@ -0,0 +1,72 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2017-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _ICE_EXEC_STATS_H_
+#define _ICE_EXEC_STATS_H_
+
+#ifdef RING3_VALIDATION
+#include <stdint.h>
+#include <stdint_ext.h>
+#else
+#include <linux/types.h>
+#endif
+
+/*
+ * Running execution time statistics, in usec.
+ *
+ * Keeps a moving average (1/8 weight to the latest sample) and a log
+ * bucketed histogram from which percentiles are read. Bucket i < 4 holds
+ * the value i, above that every power of 2 range is split into 4 linear
+ * buckets, so a percentile is off by at most 12.5%. Values beyond the
+ * last bucket (~33 sec) are clamped into it.
+ */
+#define ICE_EXEC_STATS_SUB_BITS 2
+#define ICE_EXEC_STATS_BUCKETS 96
+
+struct ice_exec_stats {
+	/* samples per bucket, halved when too many were recorded */
+	u16 hist[ICE_EXEC_STATS_BUCKETS];
+	/* samples in the histogram */
+	u32 hist_nr;
+	/* samples recorded since the stats were reset */
+	u32 samples_nr;
+	/* moving average, 0 until the first sample */
+	u32 ewma_us;
+};
+
+/*
+ * record a sample
+ * inputs : stats - the statistics
+ *          exec_us - execution time, in usec
+ */
+void ice_exec_stats_add(struct ice_exec_stats *stats, u32 exec_us);
+
+/*
+ * read a percentile from the histogram
+ * inputs : stats - the statistics
+ *          pct - percentile, 1 to 100
+ * returns: the percentile in usec, 0 if there are no samples
+ */
+u32 ice_exec_stats_pct(struct ice_exec_stats *stats, u32 pct);
+
+/*
+ * convert ICE cycles to usec
+ * inputs : cycles - ICE cycles
+ *          freq_mhz - ICE frequency, ICE_FREQ_DEFAULT if 0
+ * returns: usec, saturated at U32_MAX
+ */
+u32 ice_exec_stats_cycles_to_us(u64 cycles, u32 freq_mhz);
+
+#endif /* _ICE_EXEC_STATS_H_ */
@@ -0,0 +1,228 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2017-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifdef RING3_VALIDATION
+#include <stdint.h>
+#include <stdint_ext.h>
+#include "linux_kernel_mock.h"
+#else
+#include <linux/types.h>
+#endif
+
+#include "ice_pm_governor.h"
+#include "cve_device.h"
+#include "cve_device_group.h"
+#include "ice_sw_counters.h"
+
+/* idle periods needed before the histogram is trusted */
+#define ICE_PM_GOV_MIN_SAMPLES 16
+/* the histogram is aged once it holds this many idle periods */
+#define ICE_PM_GOV_MAX_SAMPLES 256
+
+static u32 __timespec_diff_ms(struct timespec *later,
+		struct timespec *earlier)
+{
+	u64 ms;
+
+	if ((later->tv_sec < earlier->tv_sec) ||
+		((later->tv_sec == earlier->tv_sec) &&
+		(later->tv_nsec <= earlier->tv_nsec)))
+		return 0;
+
+	ms = (u64)(later->tv_sec - earlier->tv_sec) * 1000;
+	if (later->tv_nsec < earlier->tv_nsec)
+		ms -= (earlier->tv_nsec - later->tv_nsec) / 1000000;
+	else
+		ms += (later->tv_nsec - earlier->tv_nsec) / 1000000;
+	if (ms > 0xFFFFFFFF)
+		return 0xFFFFFFFF;
+
+	return (u32)ms;
+}
+
+static u32 __bin_of(u32 ms)
+{
+	u32 bin = 0;
+
+	while (ms > 1 && bin < ICE_PM_GOV_BINS - 1) {
+		ms >>= 1;
+		bin++;
+	}
+
+	return bin;
+}
+
+/* candidate delay k covers the idle periods of bins below k */
+static u32 __bin_delay_ms(u32 k)
+{
+	return k ? (1 << k) : 0;
+}
+
+static void __age_histogram(struct ice_pm_gov *gov)
+{
+	u32 i;
+
+	gov->samples_nr = 0;
+	for (i = 0; i < ICE_PM_GOV_BINS; i++) {
+		gov->hist_nr[i] >>= 1;
+		gov->hist_ms[i] >>= 1;
+		gov->samples_nr += gov->hist_nr[i];
+	}
+}
+
+/*
+ * total powered idle time the fixed delay would have spent on the
+ * recorded idle periods, i.e. the sum of min(period, delay). Only a
+ * lower bound is known for the bin holding the delay.
+ */
+static u64 __fixed_delay_idle_ms(struct ice_pm_gov *gov, u32 delay_ms)
+{
+	u64 idle_ms = 0, lo_ms, hi_ms, cut_ms;
+	u32 i;
+
+	for (i = 0; i < ICE_PM_GOV_BINS; i++) {
+		lo_ms = __bin_delay_ms(i);
+		hi_ms = __bin_delay_ms(i + 1);
+
+		if (lo_ms >= delay_ms) {
+			idle_ms += (u64)gov->hist_nr[i] * delay_ms;
+		} else if (i < ICE_PM_GOV_BINS - 1 && hi_ms <= delay_ms) {
+			idle_ms += gov->hist_ms[i];
+		} else {
+			/* each period is at least lo_ms and, below the last
+			 * bin, loses at most hi_ms - 1 - delay_ms
+			 */
+			cut_ms = (u64)gov->hist_nr[i] * lo_ms;
+			if (i < ICE_PM_GOV_BINS - 1 &&
+				gov->hist_ms[i] > cut_ms +
+				(u64)gov->hist_nr[i] * (hi_ms - 1 - delay_ms))
+				cut_ms = gov->hist_ms[i] -
+					(u64)gov->hist_nr[i] *
+					(hi_ms - 1 - delay_ms);
+			idle_ms += cut_ms;
+		}
+	}
+
+	return idle_ms;
+}
+
+/*
+ * pick the delay with the fewest expected wake ups, among those which
+ * spend no more powered idle time than the fixed delay on the recorded
+ * idle periods. The powered idle time grows with the delay, so the
+ * search stops at the first delay over the budget. The smallest of
+ * equally good delays is kept.
+ */
+static u32 __choose_delay(struct ice_pm_gov *gov, u32 fixed_delay_ms)
+{
+	u64 below_ms = 0, idle_ms;
+	u64 budget_ms = __fixed_delay_idle_ms(gov, fixed_delay_ms);
+	u32 below_nr = 0, above_nr;
+	u32 best_above_nr = gov->samples_nr;
+	u32 best_k = 0;
+	u32 k;
+
+	for (k = 0; k < ICE_PM_GOV_BINS; k++) {
+		above_nr = gov->samples_nr - below_nr;
+
+		/* total powered idle time had delay k been used throughout */
+		idle_ms = below_ms + (u64)above_nr * __bin_delay_ms(k);
+		if (idle_ms > budget_ms)
+			break;
+
+		if (above_nr < best_above_nr) {
+			best_above_nr = above_nr;
+			best_k = k;
+		}
+
+		below_nr += gov->hist_nr[k];
+		below_ms += gov->hist_ms[k];
+	}
+
+	return __bin_delay_ms(best_k);
+}
+
+void ice_pm_gov_init(struct cve_device *dev)
+{
+	struct ice_pm_gov *gov = &dev->pm_gov;
+	int budget_ms = ice_get_power_off_delay_param();
+
+	memset(gov, 0, sizeof(*gov));
+	gov->delay_ms = (budget_ms < 0) ? 0 : (u32)budget_ms;
+
+	ice_swc_counter_set(dev->hswc,
+			ICEDRV_SWC_DEVICE_COUNTER_POWER_OFF_DELAY,
+			gov->delay_ms);
+}
+
+u32 ice_pm_gov_idle_start(struct cve_device *dev)
+{
+	struct ice_pm_gov *gov = &dev->pm_gov;
+
+	gov->armed_delay_ms = gov->delay_ms;
+	gov->idle_tracked = 1;
+
+	return gov->armed_delay_ms;
+}
+
+void ice_pm_gov_idle_end(struct cve_device *dev, struct timespec *now,
+		u8 powered_off)
+{
+	struct ice_pm_gov *gov = &dev->pm_gov;
+	u32 idle_ms, bin, fixed_delay_ms;
+
+	/* devices that were off since probe have no idle period */
+	if (!gov->idle_tracked)
+		return;
+	gov->idle_tracked = 0;
+
+	idle_ms = __timespec_diff_ms(now, &dev->poweroff_ts);
+
+	/* energy estimate, time spent powered without work */
+	ice_swc_counter_add(dev->hswc,
+			ICEDRV_SWC_DEVICE_COUNTER_IDLE_POWERED_TIME,
+			powered_off ? gov->armed_delay_ms : idle_ms);
+
+	bin = __bin_of(idle_ms);
+	gov->hist_nr[bin]++;
+	gov->hist_ms[bin] += idle_ms;
+	gov->samples_nr++;
+	if (gov->samples_nr >= ICE_PM_GOV_MAX_SAMPLES)
+		__age_histogram(gov);
+
+	fixed_delay_ms = (u32)ice_get_power_off_delay_param();
+	if (!ice_enable_adaptive_power_off() ||
+		gov->samples_nr < ICE_PM_GOV_MIN_SAMPLES)
+		gov->delay_ms = fixed_delay_ms;
+	else
+		gov->delay_ms = __choose_delay(gov, fixed_delay_ms);
+
+	ice_swc_counter_set(dev->hswc,
+			ICEDRV_SWC_DEVICE_COUNTER_POWER_OFF_DELAY,
+			gov->delay_ms);
+
+	cve_os_dev_log(CVE_LOGLEVEL_DEBUG, dev->dev_index,
+			"Idle for %u msec (powered off:%u), next power off delay %u msec\n",
+			idle_ms, powered_off, gov->delay_ms);
+}
+
+void ice_pm_gov_wakeup(struct cve_device *dev, u32 penalty_us)
+{
+	ice_swc_counter_inc(dev->hswc,
+			ICEDRV_SWC_DEVICE_COUNTER_WAKEUP_COUNT);
+	ice_swc_counter_add(dev->hswc,
+			ICEDRV_SWC_DEVICE_COUNTER_WAKEUP_PENALTY_TIME,
+			penalty_us);
+}
@@ -0,0 +1,94 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2017-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _ICE_PM_GOVERNOR_H_
+#define _ICE_PM_GOVERNOR_H_
+
+#ifdef RING3_VALIDATION
+#include <stdint.h>
+#include <stdint_ext.h>
+#else
+#include <linux/types.h>
+#endif
+
+/*
+ * Adaptive power off delay of an ICE.
+ *
+ * Every idle period of an ICE, from the moment it is queued for power off
+ * until it is used again, is recorded in a histogram of log2(ms) bins.
+ * From the histogram the governor picks the power off delay that
+ * minimizes the number of wake ups (each costing a power up sequence)
+ * while spending no more powered idle time on the recorded idle periods
+ * than the fixed ice_power_off_delay_ms would have, min(period, delay)
+ * for each of them.
+ * A delay covering all idle periods keeps the ICE on, a zero delay powers
+ * it off as soon as the power off thread runs.
+ */
+
+/* bin i holds idle periods of [2^i, 2^(i+1)) ms, the last bin the rest */
+#define ICE_PM_GOV_BINS 16
+
+struct cve_device;
+struct timespec;
+
+struct ice_pm_gov {
+	/* idle periods per bin, halved when too many were recorded */
+	u32 hist_nr[ICE_PM_GOV_BINS];
+	/* sum of the idle periods per bin, in ms */
+	u64 hist_ms[ICE_PM_GOV_BINS];
+	/* idle periods in the histogram */
+	u32 samples_nr;
+	/* power off delay for the next idle period, in ms */
+	u32 delay_ms;
+	/* delay the current idle period was queued with, used by the
+	 * power off thread
+	 */
+	u32 armed_delay_ms;
+	/* set while an idle period is being measured */
+	u8 idle_tracked;
+};
+
+/*
+ * reset the governor of a device to the configured fixed delay
+ * inputs : dev - the device
+ */
+void ice_pm_gov_init(struct cve_device *dev);
+
+/*
+ * start an idle period. Called when the device is queued for power off,
+ * after dev->poweroff_ts is set.
+ * inputs : dev - the device
+ * returns: the power off delay of this idle period, in ms
+ */
+u32 ice_pm_gov_idle_start(struct cve_device *dev);
+
+/*
+ * end the idle period of a device that is used again and choose the
+ * delay of the next one
+ * inputs : dev - the device
+ *          now - current time
+ *          powered_off - set if the device was powered off while idle
+ */
+void ice_pm_gov_idle_end(struct cve_device *dev, struct timespec *now,
+		u8 powered_off);
+
+/*
+ * account the time taken to power a device back on
+ * inputs : dev - the device
+ *          penalty_us - time from power enable until the device was ready
+ */
+void ice_pm_gov_wakeup(struct cve_device *dev, u32 penalty_us);
+
+#endif /* _ICE_PM_GOVERNOR_H_ */
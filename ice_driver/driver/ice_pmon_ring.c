@@ -0,0 +1,59 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2017-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifdef RING3_VALIDATION
+#include <stdint.h>
+#include <stdint_ext.h>
+#include "linux_kernel_mock.h"
+#else
+#include <linux/types.h>
+#endif
+
+#include "ice_pmon_ring.h"
+#include "os_interface.h"
+
+struct ice_pmon_sample *ice_pmon_ring_next(struct ice_pmon_ring *ring)
+{
+	u32 head;
+
+	if (ring->count == ICE_PMON_RING_SIZE) {
+		ring->tail = (ring->tail + 1) % ICE_PMON_RING_SIZE;
+		ring->count--;
+		ring->lost_nr++;
+	}
+
+	head = (ring->tail + ring->count) % ICE_PMON_RING_SIZE;
+	ring->count++;
+
+	return &ring->samples[head];
+}
+
+struct ice_pmon_sample *ice_pmon_ring_peek(struct ice_pmon_ring *ring,
+		u32 *out_nr)
+{
+	u32 nr = ICE_PMON_RING_SIZE - ring->tail;
+
+	*out_nr = (ring->count < nr) ? ring->count : nr;
+
+	return &ring->samples[ring->tail];
+}
+
+void ice_pmon_ring_consume(struct ice_pmon_ring *ring, u32 nr)
+{
+	ASSERT(nr <= ring->count);
+
+	ring->tail = (ring->tail + nr) % ICE_PMON_RING_SIZE;
+	ring->count -= nr;
+}
@@ -0,0 +1,68 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2017-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _ICE_PMON_RING_H_
+#define _ICE_PMON_RING_H_
+
+#ifdef RING3_VALIDATION
+#include <stdint.h>
+#include <stdint_ext.h>
+#else
+#include <linux/types.h>
+#endif
+
+#include "cve_driver.h"
+
+/*
+ * Ring of PMON samples of a network. Writer is the job completion, reader
+ * the PMON samples ioctl, both under the driver lock. When full, a new
+ * sample overwrites the oldest one.
+ */
+#define ICE_PMON_RING_SIZE 256
+
+struct ice_pmon_ring {
+	struct ice_pmon_sample samples[ICE_PMON_RING_SIZE];
+	/* index of the oldest sample */
+	u32 tail;
+	/* number of samples in the ring */
+	u32 count;
+	/* samples overwritten since the last read */
+	u32 lost_nr;
+};
+
+/*
+ * reserve the slot of the next sample, overwriting the oldest if full
+ * inputs : ring - the ring
+ * returns: the slot to fill
+ */
+struct ice_pmon_sample *ice_pmon_ring_next(struct ice_pmon_ring *ring);
+
+/*
+ * get the oldest samples that are contiguous in the ring
+ * inputs : ring - the ring
+ * outputs: out_nr - number of samples, 0 if the ring is empty
+ * returns: the oldest sample
+ */
+struct ice_pmon_sample *ice_pmon_ring_peek(struct ice_pmon_ring *ring,
+		u32 *out_nr);
+
+/*
+ * drop the oldest samples once they were read
+ * inputs : ring - the ring
+ *          nr - number of samples, at most as returned by peek
+ */
+void ice_pmon_ring_consume(struct ice_pmon_ring *ring, u32 nr);
+
+#endif /* _ICE_PMON_RING_H_ */
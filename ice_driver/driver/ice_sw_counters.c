@@ -51,7 +51,28 @@ static const struct sph_sw_counter_info g_swc_global_info[] = {
 	 "Total number of Destroyed Context"},
 	/* ICEDRV_SWC_GLOBAL_ACTIVE_ICE_COUNT */
 	{ICEDRV_SWC_GLOBAL_GROUP_GEN, "activeICECount",
-	 "Total number of Active ICE"}
+	 "Total number of Active ICE"},
+	/* ICEDRV_SWC_GLOBAL_COUNTER_PIN_CACHE_HIT */
+	{ICEDRV_SWC_GLOBAL_GROUP_GEN, "pinCacheHit",
+	 "Number of user buffers found pinned in the registration cache"},
+	/* ICEDRV_SWC_GLOBAL_COUNTER_PIN_CACHE_MISS */
+	{ICEDRV_SWC_GLOBAL_GROUP_GEN, "pinCacheMiss",
+	 "Number of user buffers pinned on registration"},
+	/* ICEDRV_SWC_GLOBAL_COUNTER_PIN_CACHE_INVALIDATED */
+	{ICEDRV_SWC_GLOBAL_GROUP_GEN, "pinCacheInvalidated",
+	 "Number of cached user buffers invalidated by an MMU notifier"},
+	/* ICEDRV_SWC_GLOBAL_COUNTER_DMA_POOL_HIT */
+	{ICEDRV_SWC_GLOBAL_GROUP_GEN, "dmaPoolHit",
+	 "Number of driver DMA buffers taken from the pool"},
+	/* ICEDRV_SWC_GLOBAL_COUNTER_DMA_POOL_MISS */
+	{ICEDRV_SWC_GLOBAL_GROUP_GEN, "dmaPoolMiss",
+	 "Number of driver DMA buffers allocated from the system"},
+	/* ICEDRV_SWC_GLOBAL_COUNTER_INF_DBUF_CACHE_HIT */
+	{ICEDRV_SWC_GLOBAL_GROUP_GEN, "infDmaBufCacheHit",
+	 "Number of infer dma-buf attachments reused from the network buffer"},
+	/* ICEDRV_SWC_GLOBAL_COUNTER_INF_DBUF_CACHE_MISS */
+	{ICEDRV_SWC_GLOBAL_GROUP_GEN, "infDmaBufCacheMiss",
+	 "Number of infer dma-buf attachments created"}
 };
 
 static const struct sph_sw_counters_set g_swc_global_set = {
@@ -139,7 +160,40 @@ static const struct sph_sw_counter_info g_swc_sub_network_info[] = {
 	 "Number of Infer Requests that are completed"},
 	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_INF_DESTROYED */
 	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "inferDestroyed",
-	 "Total number of Destroyed Infer Request"}
+	 "Total number of Destroyed Infer Request"},
+	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED */
+	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "icePlaced",
+	 "Number of Jobs placed on a scored ICE"},
+	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_WARM */
+	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "icePlacedWarm",
+	 "Number of Jobs placed on an ICE still holding this network"},
+	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_POWERED */
+	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "icePlacedPowered",
+	 "Number of Jobs placed on an already powered on ICE"},
+	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_BO_ACTIVE */
+	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "icePlacedBoActive",
+	 "Number of Jobs placed on an ICE whose ICEBO peer is active"},
+	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_EFFICIENT */
+	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "icePlacedEfficient",
+	 "Number of Jobs placed on an ICE recommended by the power balancer"},
+	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_CREATE_PREPARE_TIME */
+	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "createPrepareTime",
+	 "Time in usec spent preparing the network without the driver lock"},
+	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_CREATE_COMMIT_TIME */
+	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "createCommitTime",
+	 "Time in usec spent creating the network under the driver lock"},
+	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_HYBRID_POLL_HIT */
+	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "hybridPollHit",
+	 "Completion events found while polling before sleeping"},
+	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_HYBRID_POLL_MISS */
+	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "hybridPollMiss",
+	 "Polls that ran out of budget and fell back to sleeping"},
+	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_STICKY_HIT */
+	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "stickyHit",
+	 "Inferences that ran on the resources kept from the previous one"},
+	/* ICEDRV_SWC_SUB_NETWORK_COUNTER_STICKY_MISS */
+	{ICEDRV_SWC_SUB_NETWORK_GROUP_GEN, "stickyMiss",
+	 "Kept resources given to other networks or powered off before reuse"}
 };
 
 static const struct sph_sw_counters_set g_swc_sub_network_set = {
@@ -224,6 +278,24 @@ static const struct sph_sw_counter_info g_swc_device_info[] = {
 	/* ICEDRV_SWC_DEVICE_COUNTER_ECC_DERRCOUNT */
 	{ICEDRV_SWC_DEVICE_GROUP_GEN, "eccDerrCount",
 	 "Total count of Deep SRAM ECC double errors"},
+	/* ICEDRV_SWC_DEVICE_COUNTER_TLB_INV_FULL */
+	{ICEDRV_SWC_DEVICE_GROUP_GEN, "tlbInvalidateFull",
+	 "Total full TLB invalidations done on this device"},
+	/* ICEDRV_SWC_DEVICE_COUNTER_TLB_INV_SKIPPED */
+	{ICEDRV_SWC_DEVICE_GROUP_GEN, "tlbInvalidateSkipped",
+	 "Page table changes not flushed as the device did not hold the page table"},
+	/* ICEDRV_SWC_DEVICE_COUNTER_POWER_OFF_DELAY */
+	{ICEDRV_SWC_DEVICE_GROUP_GEN, "powerOffDelay",
+	 "Power off delay chosen for the next idle period, in msec"},
+	/* ICEDRV_SWC_DEVICE_COUNTER_WAKEUP_COUNT */
+	{ICEDRV_SWC_DEVICE_GROUP_GEN, "wakeupCount",
+	 "Number of times the device was powered on to run work"},
+	/* ICEDRV_SWC_DEVICE_COUNTER_WAKEUP_PENALTY_TIME */
+	{ICEDRV_SWC_DEVICE_GROUP_GEN, "wakeupPenaltyTime",
+	 "Total time spent waiting for the device to power on, in usec"},
+	/* ICEDRV_SWC_DEVICE_COUNTER_IDLE_POWERED_TIME */
+	{ICEDRV_SWC_DEVICE_GROUP_GEN, "idlePoweredTime",
+	 "Total time the device stayed powered without work, in msec"},
 };
 
 static const struct sph_sw_counters_set g_swc_device_set = {
@@ -257,6 +329,18 @@ static const struct sph_sw_counter_info g_swc_infer_device_info[] = {
 	/* ICEDRV_SWC_INFER_DEVICE_COUNTER_UNMAPPED_ERR_ID */
 	{ICEDRV_SWC_INFER_DEVICE_GROUP_GEN, "unmappedErrId",
 	 "Unmapped TID that caused the error"},
+	/* ICEDRV_SWC_INFER_DEVICE_COUNTER_EXEC_TIME_EWMA */
+	{ICEDRV_SWC_INFER_DEVICE_GROUP_GEN, "execTimeEwma",
+	 "Moving average of the job execution time on this ICE, in usec"},
+	/* ICEDRV_SWC_INFER_DEVICE_COUNTER_EXEC_TIME_P50 */
+	{ICEDRV_SWC_INFER_DEVICE_GROUP_GEN, "execTimeP50",
+	 "Median of recent job execution times on this ICE, in usec"},
+	/* ICEDRV_SWC_INFER_DEVICE_COUNTER_EXEC_TIME_P99 */
+	{ICEDRV_SWC_INFER_DEVICE_GROUP_GEN, "execTimeP99",
+	 "99th percentile of recent job execution times on this ICE, in usec"},
+	/* ICEDRV_SWC_INFER_DEVICE_COUNTER_SLOW_EXEC_COUNT */
+	{ICEDRV_SWC_INFER_DEVICE_GROUP_GEN, "slowExecCount",
+	 "Count of jobs that ran more than twice the moving average"},
 };
 
 static const struct sph_sw_counters_set g_swc_infer_device_set = {
@@ -829,7 +913,7 @@ inline u64 _swc_counter_get(void *h_counter, u32 idx)
 	struct sph_sw_counters *counter = (struct sph_sw_counters *)h_counter;
 
 	if (counter)
-		return SPH_SW_COUNTER_GET(counter, idx);
+		return sph_sw_counter_get(counter, idx);
 	else
 		return 0;
 }
@@ -886,46 +970,31 @@ inline void _swc_counter_atomic_inc(void *h_counter, u32 idx)
 {
 	struct sph_sw_counters *counter = (struct sph_sw_counters *)h_counter;
 
-	if (counter) {
+	/* per-CPU delta, the value is folded when read */
+	if (counter)
 		SPH_SW_COUNTER_ATOMIC_INC(counter, idx);
-		cve_os_log(CVE_LOGLEVEL_DEBUG,
-				"SwCounter[%u] = %llu\n",
-				idx, counter->values[idx]);
-	}
 }
 
 inline void _swc_counter_atomic_dec(void *h_counter, u32 idx)
 {
 	struct sph_sw_counters *counter = (struct sph_sw_counters *)h_counter;
 
-	if (counter) {
+	if (counter)
 		SPH_SW_COUNTER_ATOMIC_DEC(counter, idx);
-		cve_os_log(CVE_LOGLEVEL_DEBUG,
-				"SwCounter[%u] = %llu\n",
-				idx, counter->values[idx]);
-	}
 }
 
 inline void _swc_counter_atomic_add(void *h_counter, u32 idx, u64 val)
 {
 	struct sph_sw_counters *counter = (struct sph_sw_counters *)h_counter;
 
-	if (counter) {
+	if (counter)
 		SPH_SW_COUNTER_ATOMIC_ADD(counter, idx, val);
-		cve_os_log(CVE_LOGLEVEL_DEBUG,
-				"SwCounter[%u] = %llu\n",
-				idx, counter->values[idx]);
-	}
 }
 
 inline void _swc_counter_atomic_dec_val(void *h_counter, u32 idx, u64 val)
 {
 	struct sph_sw_counters *counter = (struct sph_sw_counters *)h_counter;
 
-	if (counter) {
+	if (counter)
 		SPH_SW_COUNTER_ATOMIC_DEC_VAL(counter, idx, val);
-		cve_os_log(CVE_LOGLEVEL_DEBUG,
-				"SwCounter[%u] = %llu\n",
-				idx, counter->values[idx]);
-	}
 }
@@ -56,7 +56,14 @@ enum ICEDRV_SWC_GLOBAL_COUNTER {
 	ICEDRV_SWC_GLOBAL_COUNTER_CTX_TOTAL,
 	ICEDRV_SWC_GLOBAL_COUNTER_CTX_CURR,
 	ICEDRV_SWC_GLOBAL_COUNTER_CTX_DEST,
-	ICEDRV_SWC_GLOBAL_ACTIVE_ICE_COUNT
+	ICEDRV_SWC_GLOBAL_ACTIVE_ICE_COUNT,
+	ICEDRV_SWC_GLOBAL_COUNTER_PIN_CACHE_HIT,
+	ICEDRV_SWC_GLOBAL_COUNTER_PIN_CACHE_MISS,
+	ICEDRV_SWC_GLOBAL_COUNTER_PIN_CACHE_INVALIDATED,
+	ICEDRV_SWC_GLOBAL_COUNTER_DMA_POOL_HIT,
+	ICEDRV_SWC_GLOBAL_COUNTER_DMA_POOL_MISS,
+	ICEDRV_SWC_GLOBAL_COUNTER_INF_DBUF_CACHE_HIT,
+	ICEDRV_SWC_GLOBAL_COUNTER_INF_DBUF_CACHE_MISS
 };
 
 /* Groups in ICEDRV_SWC_CLASS_CONTEXT */
@@ -95,7 +102,18 @@ enum ICEDRV_SWC_SUB_NETWORK_COUNTER {
 	ICEDRV_SWC_SUB_NETWORK_COUNTER_INF_CREATED,
 	ICEDRV_SWC_SUB_NETWORK_COUNTER_INF_SCHEDULED,
 	ICEDRV_SWC_SUB_NETWORK_COUNTER_INF_COMPLETED,
-	ICEDRV_SWC_SUB_NETWORK_COUNTER_INF_DESTROYED
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_INF_DESTROYED,
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED,
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_WARM,
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_POWERED,
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_BO_ACTIVE,
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_ICE_PLACED_EFFICIENT,
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_CREATE_PREPARE_TIME,
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_CREATE_COMMIT_TIME,
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_HYBRID_POLL_HIT,
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_HYBRID_POLL_MISS,
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_STICKY_HIT,
+	ICEDRV_SWC_SUB_NETWORK_COUNTER_STICKY_MISS
 };
 
 /* Groups in ICEDRV_SWC_CLASS_INFER */
@@ -140,6 +158,12 @@ enum ICEDRV_SWC_DEVICE_COUNTER {
 	ICEDRV_SWC_DEVICE_COUNTER_ECC_SERRCOUNT,
 	ICEDRV_SWC_DEVICE_COUNTER_ECC_DERRCOUNT_WRAP,
 	ICEDRV_SWC_DEVICE_COUNTER_ECC_DERRCOUNT,
+	ICEDRV_SWC_DEVICE_COUNTER_TLB_INV_FULL,
+	ICEDRV_SWC_DEVICE_COUNTER_TLB_INV_SKIPPED,
+	ICEDRV_SWC_DEVICE_COUNTER_POWER_OFF_DELAY,
+	ICEDRV_SWC_DEVICE_COUNTER_WAKEUP_COUNT,
+	ICEDRV_SWC_DEVICE_COUNTER_WAKEUP_PENALTY_TIME,
+	ICEDRV_SWC_DEVICE_COUNTER_IDLE_POWERED_TIME,
 };
 
 /* Groups in ICEDRV_SWC_CLASS_INFER_DEVICE */
@@ -154,6 +178,10 @@ enum ICEDRV_SWC_INFER_DEVICE_COUNTER {
 	ICEDRV_SWC_INFER_DEVICE_COUNTER_ECC_DERRCOUNT,
 	ICEDRV_SWC_INFER_DEVICE_COUNTER_PARITY_ERRCOUNT,
 	ICEDRV_SWC_INFER_DEVICE_COUNTER_UNMAPPED_ERR_ID,
+	ICEDRV_SWC_INFER_DEVICE_COUNTER_EXEC_TIME_EWMA,
+	ICEDRV_SWC_INFER_DEVICE_COUNTER_EXEC_TIME_P50,
+	ICEDRV_SWC_INFER_DEVICE_COUNTER_EXEC_TIME_P99,
+	ICEDRV_SWC_INFER_DEVICE_COUNTER_SLOW_EXEC_COUNT,
 };
 
 #define _swc_no_op do {} while (0)
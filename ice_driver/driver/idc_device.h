@@ -32,7 +32,6 @@
 struct dev_isr_status {
 	uint64_t ice_status;
 	uint64_t idc_status;
-	uint32_t ice_isr_status[NUM_ICE_UNIT];
 	int8_t valid;
 	/* To discard outdated interrupts */
 	struct timespec cur_ts;
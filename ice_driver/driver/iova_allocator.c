@@ -16,23 +16,27 @@
 #ifdef RING3_VALIDATION
 #include <stdio.h>
 #include <errno.h>
+#include <linux_kernel_mock.h>
+#include "rbtree_augmented.h"
 #else
 #include <linux/errno.h>
+#include <linux/rbtree_augmented.h>
 #endif
 #include "iova_allocator.h"
-#include "doubly_linked_list.h"
 #include "cve_driver_internal.h"
 
 /* DATA TYPES */
 
-/* a range of iova */
+/* a range of free iova */
 struct ia_node {
-	/* links to the list of nodes in the allocator */
-	struct cve_dle_t list;
+	/* links to the tree of free ranges, sorted by 'start' */
+	struct rb_node rb;
 	/* first page frame in the range */
 	u32 start;
 	/* last page frame in the range (actually one pass it) */
 	u32 end;
+	/* number of pages in the largest range of this subtree */
+	u32 subtree_max;
 };
 
 /* allocator */
@@ -41,33 +45,100 @@ struct ia_allocator {
 	u32 bottom;
 	/* the highest iova (page frame index) that can be allocated */
 	u32 top;
-	/* list of free ranges */
-	struct ia_node *free_list;
+	/* tree of free ranges augmented with the largest range size */
+	struct rb_root free_tree;
+	/* number of free ranges */
+	u32 free_ranges_nr;
+	/* number of free pages */
+	u32 free_pages_nr;
 };
 
 /* MODULE LEVEL VARIABLES */
 
 /* INTERNAL FUNCTIONS */
 
+static inline struct ia_node *__ia_node(struct rb_node *rb)
+{
+	return rb ? rb_entry(rb, struct ia_node, rb) : NULL;
+}
+
+static inline u32 __ia_node_pages(struct ia_node *node)
+{
+	return node->end - node->start;
+}
+
+static u32 __ia_compute_max(struct ia_node *node)
+{
+	u32 max = __ia_node_pages(node);
+	struct ia_node *child;
+
+	child = __ia_node(node->rb.rb_left);
+	if (child && child->subtree_max > max)
+		max = child->subtree_max;
+
+	child = __ia_node(node->rb.rb_right);
+	if (child && child->subtree_max > max)
+		max = child->subtree_max;
+
+	return max;
+}
+
+static void __ia_augment_propagate(struct rb_node *rb, struct rb_node *stop)
+{
+	while (rb != stop) {
+		struct ia_node *node = __ia_node(rb);
+		u32 max = __ia_compute_max(node);
+
+		if (node->subtree_max == max)
+			break;
+		node->subtree_max = max;
+		rb = rb_parent(&node->rb);
+	}
+}
+
+static void __ia_augment_copy(struct rb_node *rb_old, struct rb_node *rb_new)
+{
+	__ia_node(rb_new)->subtree_max = __ia_node(rb_old)->subtree_max;
+}
+
+static void __ia_augment_rotate(struct rb_node *rb_old,
+		struct rb_node *rb_new)
+{
+	struct ia_node *old = __ia_node(rb_old);
+
+	__ia_node(rb_new)->subtree_max = old->subtree_max;
+	old->subtree_max = __ia_compute_max(old);
+}
+
+static const struct rb_augment_callbacks ia_augment_cb = {
+	.propagate = __ia_augment_propagate,
+	.copy = __ia_augment_copy,
+	.rotate = __ia_augment_rotate,
+};
+
+/* range of the node was resized in place */
+static void __ia_node_update(struct ia_node *node)
+{
+	/* Force recompute of this node even if the max did not change */
+	node->subtree_max = 0;
+	__ia_augment_propagate(&node->rb, NULL);
+}
+
 /*
- * initialize the allocator's free
- * list with a single node that holds the given range
+ * insert a new free range into the tree
  * inputs :
  *	allocator -
- *	start - the lowest iova that can be
- *			allocated (as page frame index)
- *	end -	the highest iova (page frame index)
- *			that can be allocated (address
- *			of the first page above the
- *			available region)
- *	outputs:
+ *	start - first page frame of the range
+ *	end - first page frame above the range
  * returns: 0 on success, a negative error code on failure
  */
-static int init_allocator_list(struct ia_allocator *allocator,
+static int __ia_insert_range(struct ia_allocator *allocator,
 		u32 start,
 		u32 end)
 {
-	struct ia_node *node = NULL;
+	struct rb_node **link = &allocator->free_tree.rb_node;
+	struct rb_node *parent = NULL;
+	struct ia_node *node = NULL, *cur;
 	int retval = OS_ALLOC_ZERO(sizeof(*node),
 			(void **)&node);
 
@@ -79,13 +150,118 @@ static int init_allocator_list(struct ia_allocator *allocator,
 
 	node->start = start;
 	node->end = end;
-	cve_dle_add_to_list_after(allocator->free_list, list, node);
+	node->subtree_max = end - start;
+
+	while (*link) {
+		parent = *link;
+		cur = __ia_node(parent);
+		if (cur->subtree_max < node->subtree_max)
+			cur->subtree_max = node->subtree_max;
+		if (start < cur->start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+
+	rb_link_node(&node->rb, parent, link);
+	rb_insert_augmented(&node->rb, &allocator->free_tree, &ia_augment_cb);
 
+	allocator->free_ranges_nr++;
+	allocator->free_pages_nr += end - start;
 	retval = 0;
 out:
 	return retval;
 }
 
+static void __ia_erase_node(struct ia_allocator *allocator,
+		struct ia_node *node)
+{
+	rb_erase_augmented(&node->rb, &allocator->free_tree, &ia_augment_cb);
+	allocator->free_ranges_nr--;
+	allocator->free_pages_nr -= __ia_node_pages(node);
+	OS_FREE(node, sizeof(*node));
+}
+
+/*
+ * find the free ranges around the given page frame
+ * inputs :
+ *	allocator -
+ *	start - page frame to look for
+ * outputs:
+ *	out_prev - last range starting below 'start', NULL if none
+ *	out_next - first range starting at or above 'start', NULL if none
+ */
+static void __ia_find_neighbours(struct ia_allocator *allocator,
+		u32 start,
+		struct ia_node **out_prev,
+		struct ia_node **out_next)
+{
+	struct rb_node *rb = allocator->free_tree.rb_node;
+	struct ia_node *node, *prev = NULL, *next = NULL;
+
+	while (rb) {
+		node = __ia_node(rb);
+		if (node->start < start) {
+			prev = node;
+			rb = rb->rb_right;
+		} else {
+			next = node;
+			rb = rb->rb_left;
+		}
+	}
+
+	*out_prev = prev;
+	*out_next = next;
+}
+
+/*
+ * find the lowest free range with at least 'pages_nr' pages. Subtrees
+ * whose largest range is too small are skipped, so this is O(log n).
+ */
+static struct ia_node *__ia_find_first_fit(struct ia_allocator *allocator,
+		u32 pages_nr)
+{
+	struct rb_node *rb = allocator->free_tree.rb_node;
+	struct ia_node *node, *left;
+
+	if (!rb || __ia_node(rb)->subtree_max < pages_nr)
+		return NULL;
+
+	while (rb) {
+		node = __ia_node(rb);
+		left = __ia_node(rb->rb_left);
+		if (left && left->subtree_max >= pages_nr) {
+			rb = rb->rb_left;
+			continue;
+		}
+
+		if (__ia_node_pages(node) >= pages_nr)
+			return node;
+
+		rb = rb->rb_right;
+	}
+
+	/* subtree_max guarantees a match, tree is corrupted */
+	ASSERT(false);
+	return NULL;
+}
+
+static void __ia_destroy_tree(struct ia_allocator *allocator)
+{
+	struct rb_node *rb = rb_first_postorder(&allocator->free_tree);
+	struct rb_node *next;
+
+	while (rb) {
+		next = rb_next_postorder(rb);
+		OS_FREE(__ia_node(rb), sizeof(struct ia_node));
+		rb = next;
+	}
+
+	allocator->free_tree = RB_ROOT;
+	allocator->free_ranges_nr = 0;
+	allocator->free_pages_nr = 0;
+}
+
 /* INTERFACE FUNCTIONS */
 
 int cve_iova_allocator_init(u32 bottom,
@@ -102,10 +278,11 @@ int cve_iova_allocator_init(u32 bottom,
 		goto out;
 	}
 
-	retval = init_allocator_list(allocator, bottom, top);
+	allocator->free_tree = RB_ROOT;
+	retval = __ia_insert_range(allocator, bottom, top);
 	if (retval != 0) {
 		cve_os_log_default(CVE_LOGLEVEL_ERROR,
-				"init_allocator_list failed %d\n", retval);
+				"__ia_insert_range failed %d\n", retval);
 		goto out;
 	}
 	allocator->bottom = bottom;
@@ -126,10 +303,9 @@ int cve_iova_alloc(cve_iova_allocator_handle_t _allocator,
 		u32 *out_first_page_iova)
 {
 	struct ia_allocator *allocator = (struct ia_allocator *)_allocator;
-	struct ia_node *free_node = allocator->free_list;
+	struct ia_node *free_node;
 	int retval = CVE_DEFAULT_ERROR_CODE;
 	u32 first_page_iova;
-	int found = 0;
 
 	if (cve_pages_nr == 0) {
 		cve_os_log_default(CVE_LOGLEVEL_ERROR,
@@ -140,45 +316,22 @@ int cve_iova_alloc(cve_iova_allocator_handle_t _allocator,
 
 	cve_iova_print_free_list(allocator);
 
-	if (free_node) {
-		do {
-			u32 node_pages_nr =
-					free_node->end - free_node->start;
-
-			if (free_node->end <= free_node->start) {
-				cve_os_log_default(CVE_LOGLEVEL_ERROR,
-						"start=%u end=%u\n",
-						free_node->start,
-						free_node->end);
-			}
-			ASSERT(free_node->end > free_node->start);
-			if (node_pages_nr >= cve_pages_nr) {
-				u32 new_node_pages_nr =
-						node_pages_nr - cve_pages_nr;
-				found = 1;
-				/* remove the range from the free list */
-				first_page_iova = free_node->start;
-				if (new_node_pages_nr == 0) {
-					cve_dle_remove_from_list(
-							allocator->free_list,
-							list,
-							free_node);
-					OS_FREE(free_node,
-							sizeof(*free_node));
-				} else {
-					free_node->start += cve_pages_nr;
-				}
-			}
-			if (!found)
-				free_node = cve_dle_next(free_node, list);
-		} while (!found && free_node != allocator->free_list);
-	}
-
-	if (!found) {
+	free_node = __ia_find_first_fit(allocator, cve_pages_nr);
+	if (!free_node) {
 		retval = -ICEDRV_KERROR_IOVA_NOMEM;
 		goto out;
 	}
 
+	/* remove the range from the free tree */
+	first_page_iova = free_node->start;
+	if (__ia_node_pages(free_node) == cve_pages_nr) {
+		__ia_erase_node(allocator, free_node);
+	} else {
+		free_node->start += cve_pages_nr;
+		allocator->free_pages_nr -= cve_pages_nr;
+		__ia_node_update(free_node);
+	}
+
 	/* success */
 	*out_first_page_iova = first_page_iova;
 	cve_os_log(CVE_LOGLEVEL_DEBUG,
@@ -197,6 +350,10 @@ int cve_iova_claim(cve_iova_allocator_handle_t _allocator,
 		u32 cve_pages_nr)
 {
 	struct ia_allocator *allocator = (struct ia_allocator *)_allocator;
+	struct ia_node *prev, *next, *freenode;
+	u32 start = first_page_iova;
+	u32 end = first_page_iova + cve_pages_nr;
+	u32 old_end;
 	int retval = -ICEDRV_KERROR_IOVA_NOMEM;
 
 	if (cve_pages_nr == 0) {
@@ -208,59 +365,46 @@ int cve_iova_claim(cve_iova_allocator_handle_t _allocator,
 
 	cve_iova_print_free_list(allocator);
 
-	if (!allocator->free_list) {
-		retval = -ICEDRV_KERROR_IOVA_NOMEM;
+	/* the only range that can hold 'start' is the one starting at it
+	 * or the last one starting below it
+	 */
+	__ia_find_neighbours(allocator, start, &prev, &next);
+	if (next && next->start == start)
+		freenode = next;
+	else
+		freenode = prev;
+
+	if (!freenode || freenode->start > start || freenode->end < end)
 		goto out;
+
+	if ((start == freenode->start) && (end == freenode->end)) {
+		__ia_erase_node(allocator, freenode);
+	} else if (start == freenode->start) {
+		freenode->start = end;
+		allocator->free_pages_nr -= cve_pages_nr;
+		__ia_node_update(freenode);
+	} else if (end == freenode->end) {
+		freenode->end = start;
+		allocator->free_pages_nr -= cve_pages_nr;
+		__ia_node_update(freenode);
 	} else {
-		int done = 0;
-		struct ia_node *freenode = allocator->free_list;
-		u32 start = first_page_iova;
-		u32 end = first_page_iova + cve_pages_nr;
-
-		do {
-			if ((freenode->start <= start) &&
-					(freenode->end >= end)) {
-				if ((start == freenode->start) &&
-						(end == freenode->end)) {
-					cve_dle_remove_from_list(
-							allocator->free_list,
-							list, freenode);
-					OS_FREE(freenode,
-							sizeof(*freenode));
-				} else if ((start == freenode->start) &&
-						(end < freenode->end)) {
-					freenode->start = end;
-				} else if ((start > freenode->start) &&
-						(end == freenode->end)) {
-					freenode->end = start;
-					/* start > freenode->start
-					 * && end < freenode->end
-					 */
-				} else {
-					struct ia_node *new_node = NULL;
-
-					retval = OS_ALLOC_ZERO(
-							sizeof(*new_node),
-							(void **)&new_node);
-					if (retval != 0) {
-						cve_os_log(CVE_LOGLEVEL_ERROR,
-								"OS_ALLOC_ZERO failed %d\n"
-								, retval);
-						goto out;
-					}
-					new_node->start = end;
-					new_node->end = freenode->end;
-					cve_dle_add_to_list_after(
-							freenode, list,
-							new_node);
-					freenode->end = start;
-				}
-				done = 1;
-				retval = 0;
-			} else {
-				freenode = cve_dle_next(freenode, list);
-			}
-		} while (!done && (freenode != allocator->free_list));
+		/* start > freenode->start && end < freenode->end */
+		old_end = freenode->end;
+		freenode->end = start;
+		allocator->free_pages_nr -= old_end - start;
+		__ia_node_update(freenode);
+
+		retval = __ia_insert_range(allocator, end, old_end);
+		if (retval != 0) {
+			cve_os_log(CVE_LOGLEVEL_ERROR,
+					"__ia_insert_range failed %d\n",
+					retval);
+			/* restore the original range */
+			freenode->end = old_end;
+			allocator->free_pages_nr += old_end - start;
+			__ia_node_update(freenode);
+			goto out;
+		}
 	}
 
 	cve_os_log(CVE_LOGLEVEL_DEBUG,
@@ -269,6 +413,7 @@ int cve_iova_claim(cve_iova_allocator_handle_t _allocator,
 
 	cve_iova_print_free_list(allocator);
 
+	retval = 0;
 out:
 	return retval;
 }
@@ -279,6 +424,9 @@ int cve_iova_free(cve_iova_allocator_handle_t _allocator,
 {
 	struct ia_allocator *allocator =
 			(struct ia_allocator *)_allocator;
+	struct ia_node *prev, *next;
+	u32 start = first_page_iova;
+	u32 end = first_page_iova + cve_pages_nr;
 	int retval = CVE_DEFAULT_ERROR_CODE;
 
 	cve_os_log(CVE_LOGLEVEL_DEBUG,
@@ -303,176 +451,44 @@ int cve_iova_free(cve_iova_allocator_handle_t _allocator,
 		goto out;
 	}
 
-	if (!allocator->free_list) {
-		/* case 0) free list is empty
-		 * - init the list with a newly
-		 * created node
-		 */
-		retval = init_allocator_list(allocator,
+	__ia_find_neighbours(allocator, start, &prev, &next);
+
+	if ((prev && (start < prev->end)) || (next && (end > next->start))) {
+		/* trying to reclaim a region that is already free */
+		cve_os_log_default(CVE_LOGLEVEL_ERROR,
+				"reclaiming non-distinct region %u(%u)\n",
 				first_page_iova,
-				first_page_iova + cve_pages_nr);
+				cve_pages_nr);
+		retval = -EINVAL;
+		goto out;
+	}
+
+	if (prev && (start == prev->end) && next && (end == next->start)) {
+		/* merge 2 nodes and free one of them */
+		end = next->end;
+		__ia_erase_node(allocator, next);
+		allocator->free_pages_nr += end - prev->end;
+		prev->end = end;
+		__ia_node_update(prev);
+	} else if (prev && (start == prev->end)) {
+		/* merge the reclaimed range with the prev node */
+		prev->end = end;
+		allocator->free_pages_nr += cve_pages_nr;
+		__ia_node_update(prev);
+	} else if (next && (end == next->start)) {
+		/* merge the reclaimed range with the next node */
+		next->start = start;
+		allocator->free_pages_nr += cve_pages_nr;
+		__ia_node_update(next);
+	} else {
+		/* create a new node and add it to the free tree */
+		retval = __ia_insert_range(allocator, start, end);
 		if (retval != 0) {
 			cve_os_log_default(CVE_LOGLEVEL_ERROR,
-					"init_allocator_list failed %d\n"
-					, retval);
+					"__ia_insert_range failed %d\n",
+					retval);
 			goto out;
 		}
-	} else {
-		/* look for the right place to insert the new range.
-		 * the free list is sorted by 'start', and the ranges are
-		 * distinct. so consequently it is sorted by 'end' too
-		 */
-		int done = 0;
-		struct ia_node *next = allocator->free_list;
-		struct ia_node *prev = NULL;
-		u32 start = first_page_iova;
-		u32 end = first_page_iova + cve_pages_nr;
-
-		do {
-			if ((!prev) &&
-					(next) &&
-					(end < next->start)) {
-				/* create a new node
-				 * and add it to the free list
-				 */
-				struct ia_node *new_node = NULL;
-
-				retval = OS_ALLOC_ZERO(sizeof(*new_node)
-						, (void **)&new_node);
-
-				if (retval != 0) {
-					cve_os_log(CVE_LOGLEVEL_ERROR,
-							"OS_ALLOC_ZERO failed %d\n"
-							, retval);
-					goto out;
-				}
-				new_node->start = start;
-				new_node->end = end;
-				cve_dle_add_to_list_before(
-						next, list, new_node);
-				allocator->free_list = new_node;
-				done = 1;
-			} else if ((!prev) &&
-					(next) &&
-					(end == next->start)) {
-				/* merge the reclaimed
-				 * range with the next node
-				 */
-				next->start = start;
-				done = 1;
-			} else if ((prev) &&
-					(next) &&
-					(start == prev->end) &&
-					(end < next->start)) {
-				/* merge the reclaimed
-				 * range with the prev node
-				 */
-				prev->end = end;
-				done = 1;
-			} else if ((prev) &&
-					(next) &&
-					(start > prev->end) &&
-					(end < next->start)) {
-				/* create a new node and
-				 * add it to the free list
-				 */
-				struct ia_node *new_node = NULL;
-
-				retval = OS_ALLOC_ZERO(sizeof(*new_node),
-						(void **)&new_node);
-				if (retval != 0) {
-					cve_os_log(CVE_LOGLEVEL_ERROR,
-							"OS_ALLOC_ZERO failed %d\n",
-							retval);
-					goto out;
-				}
-				new_node->start = start;
-				new_node->end = end;
-				cve_dle_add_to_list_after(prev, list, new_node);
-				done = 1;
-			} else if ((prev) &&
-					(next) &&
-					(start == prev->end) &&
-					(end == next->start)) {
-				/* merge 2 nodes and
-				 * free one of them
-				 */
-				prev->end = next->end;
-				cve_dle_remove_from_list(
-						allocator->free_list,
-						list, next);
-				OS_FREE(next, sizeof(*next));
-				done = 1;
-			} else if ((prev) &&
-					(next) &&
-					(start > prev->end) &&
-					(end == next->start)) {
-				/* merge the reclaimed
-				 * range with the next node
-				 */
-				next->start = start;
-				done = 1;
-			} else if ((prev) &&
-					(!next)	&&
-					(start == prev->end)) {
-				/* merge the reclaimed
-				 * range with the prev node
-				 */
-				prev->end = end;
-				done = 1;
-			} else if ((prev) &&
-					(!next)	&&
-					(start > prev->end)) {
-				/* create a new node and
-				 * add it to the free list
-				 */
-				struct ia_node *new_node = NULL;
-
-				retval = OS_ALLOC_ZERO(sizeof(*new_node),
-						(void **)&new_node);
-				if (retval != 0) {
-					cve_os_log(CVE_LOGLEVEL_ERROR,
-							"OS_ALLOC_ZERO failed %d\n",
-							retval);
-					goto out;
-				}
-				new_node->start = start;
-				new_node->end = end;
-				cve_dle_add_to_list_after(prev, list, new_node);
-				done = 1;
-			} else if ((next) &&
-					(start <= next->start) &&
-					(end > next->start)) {
-				/* trying to reclaim a
-				 * region that is already free
-				 */
-				cve_os_log_default(CVE_LOGLEVEL_ERROR,
-						"reclaiming non-distinct region 1 %u(%u)\n",
-						first_page_iova,
-						cve_pages_nr);
-				retval = -EINVAL;
-				goto out;
-			} else if ((prev) &&
-					(start < prev->end) &&
-					(end >= prev->start)) {
-				/* trying to reclaim a
-				 * region that is already free
-				 */
-				cve_os_log_default(CVE_LOGLEVEL_ERROR,
-						"reclaiming non-distinct region 2 %u(%u)\n",
-						first_page_iova,
-						cve_pages_nr);
-				retval = -EINVAL;
-				goto out;
-			} else {
-				prev = next;
-				if (next) {
-					next = cve_dle_next(next, list);
-					if (next == allocator->free_list)
-						next = NULL;
-				}
-			}
-		} while (!done && (prev));
 	}
 
 	cve_iova_print_free_list(allocator);
@@ -490,51 +506,43 @@ int cve_iova_copy_free_list(
 			(struct ia_allocator *)source_allocator;
 	struct ia_allocator *poutput_allocator =
 			(struct ia_allocator *)dest_allocator;
-	int retval = -EBUSY;
+	struct rb_node *rb;
+	struct ia_node *source_node;
+	int retval = 0;
 
 	/* remove all nodes from destination allocator */
-	if (poutput_allocator->free_list) {
-		struct cve_dle_t *ne = &poutput_allocator->free_list->list;
-		struct cve_dle_t *e = NULL;
-
-		do {
-			e = ne;
-			ne = cve_dle_remove(e);
-			OS_FREE(e->container,
-					sizeof(struct ia_node));
-		} while (ne != e);
-		poutput_allocator->free_list = NULL;
-	}
+	__ia_destroy_tree(poutput_allocator);
 
 	/* copy source nodes to destination allocator */
-	if (pinput_allocator->free_list) {
-		struct ia_node *source_node = pinput_allocator->free_list;
-
-		do {
-			struct ia_node *new_node = NULL;
-
-			retval = OS_ALLOC_ZERO(sizeof(*new_node),
-					(void **)&new_node);
-			if (retval != 0) {
-				cve_os_log(CVE_LOGLEVEL_ERROR,
-						"OS_ALLOC_ZERO failed %d\n"
-						, retval);
-				goto out;
-			}
-			new_node->start = source_node->start;
-			new_node->end = source_node->end;
-			cve_dle_add_to_list_before(poutput_allocator->free_list,
-					list,
-					new_node);
-			source_node = cve_dle_next(source_node, list);
-		} while (source_node != pinput_allocator->free_list);
+	for (rb = rb_first(&pinput_allocator->free_tree); rb;
+			rb = rb_next(rb)) {
+		source_node = __ia_node(rb);
+		retval = __ia_insert_range(poutput_allocator,
+				source_node->start,
+				source_node->end);
+		if (retval != 0) {
+			cve_os_log(CVE_LOGLEVEL_ERROR,
+					"__ia_insert_range failed %d\n",
+					retval);
+			goto out;
+		}
 	}
 
-	retval = 0;
 out:
 	return retval;
 }
 
+void cve_iova_get_free_stats(cve_iova_allocator_handle_t _allocator,
+		struct ice_iova_free_stats *stats)
+{
+	struct ia_allocator *allocator = (struct ia_allocator *)_allocator;
+	struct ia_node *root = __ia_node(allocator->free_tree.rb_node);
+
+	stats->free_ranges_nr = allocator->free_ranges_nr;
+	stats->free_pages_nr = allocator->free_pages_nr;
+	stats->largest_free_pages_nr = root ? root->subtree_max : 0;
+}
+
 void cve_iova_allocator_destroy(cve_iova_allocator_handle_t *pallocator)
 {
 	struct ia_allocator *allocator = (struct ia_allocator *)*pallocator;
@@ -543,22 +551,7 @@ void cve_iova_allocator_destroy(cve_iova_allocator_handle_t *pallocator)
 	if (!allocator)
 		return;
 
-	if (allocator->free_list) {
-		struct cve_dle_t *ne = &allocator->free_list->list;
-		struct cve_dle_t *e = NULL;
-
-		do {
-			e = ne;
-			ne = cve_dle_remove(e);
-			if (ne != e) {
-				OS_FREE(e->container,
-					sizeof(struct ia_node));
-			}
-		} while (ne != e);
-		/* release the anchor node */
-		OS_FREE(allocator->free_list, sizeof(struct ia_node));
-		allocator->free_list = NULL;
-	}
+	__ia_destroy_tree(allocator);
 
 	OS_FREE(allocator, sizeof(*allocator));
 	*pallocator = NULL;
@@ -568,16 +561,16 @@ void cve_iova_allocator_destroy(cve_iova_allocator_handle_t *pallocator)
 void cve_iova_print_free_list(cve_iova_allocator_handle_t _allocator)
 {
 	struct ia_allocator *allocator = (struct ia_allocator *)_allocator;
+	struct rb_node *rb = rb_first(&allocator->free_tree);
 
 	printf("%s> allocator=%p: ", __func__, allocator);
-	if (allocator->free_list) {
-		struct ia_node *node = allocator->free_list;
+	if (rb) {
+		for (; rb; rb = rb_next(rb)) {
+			struct ia_node *node = __ia_node(rb);
 
-		do {
 			printf("%s> %x-%x, node: %p | ", __func__,
 					node->start, node->end, node);
-			node = cve_dle_next(node, list);
-		} while (node != allocator->free_list);
+		}
 		printf("\n");
 	} else {
 		printf("%s> empty list\n", __func__);
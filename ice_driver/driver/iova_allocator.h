@@ -29,6 +29,16 @@
 
 typedef void *cve_iova_allocator_handle_t;
 
+/* fragmentation snapshot of an iova allocator */
+struct ice_iova_free_stats {
+	/* number of distinct free ranges */
+	u32 free_ranges_nr;
+	/* total number of free pages */
+	u32 free_pages_nr;
+	/* number of pages in the largest free range */
+	u32 largest_free_pages_nr;
+};
+
 struct ice_iova_desc {
 	/* LLC policy */
 	u32 llc_policy;
@@ -101,6 +111,15 @@ int cve_iova_free(cve_iova_allocator_handle_t allocator,
 int cve_iova_copy_free_list(cve_iova_allocator_handle_t dest_allocator,
 		cve_iova_allocator_handle_t source_allocator);
 
+/*
+ * get the fragmentation state of the allocator, O(1)
+ * inputs :	allocator - a handle to the allocator
+ * outputs: stats - free range count, free pages and largest free range
+ * returns:
+ */
+void cve_iova_get_free_stats(cve_iova_allocator_handle_t allocator,
+		struct ice_iova_free_stats *stats);
+
 /*
  * reclaims all the resources taken by an iova allocator
  * inputs :	allocator - a pointer to the allocator's handle
@@ -49,9 +49,28 @@
 #include "lin_mm_internal.h"
 #include "ice_debug.h"
 #include "doubly_linked_list.h"
+#include "cve_device_group.h"
+#include "ice_sw_counters.h"
+
+/* number of unused dma-buf attachments kept per network buffer */
+#define ICE_DBUF_CACHE_IDLE_MAX 8
 
 /* DATA TYPES */
 
+/* dma-buf attached and mapped for an ICE, reused across infer buffers */
+struct ice_dbuf_attach {
+	struct cve_dle_t list;
+	/* key, a reference is held for the lifetime of the entry */
+	struct dma_buf *dbuf;
+	struct device *dev;
+	/* attachment and its sg table, DMA mapped for 'dev' */
+	struct dma_buf_attachment *dbuf_attach;
+	struct sg_table *sgt;
+	enum dma_data_direction dir;
+	/* number of infer allocations using the entry */
+	u32 refcount;
+};
+
 /* allocation descriptor */
 struct lin_mm_allocation {
 	/* Is zero for Network copy */
@@ -78,6 +97,10 @@ struct lin_mm_allocation {
 	struct page **pages;
 	/* number of page frames */
 	size_t os_pages_nr;
+	/* registration cache entry holding the pages, NULL if not cached */
+	struct ice_pin_entry *pin_entry;
+	/* pinned by the prefetch path, outside of the driver lock */
+	u8 prefetch;
 	/* ICE page shift */
 	u8 page_shift;
 	/* allocation type */
@@ -92,8 +115,19 @@ struct lin_mm_allocation {
 	struct ice_lin_mm_buf_config buf_meta_data;
 	/* number of ice page frames */
 	size_t ice_pages_nr;
+	/* set if the driver moved the buffer to a large page partition */
+	u8 promoted;
 	os_domain_handle hdomain[MAX_CVE_DEVICES_NR];
 	u32 dma_domain_array_size;
+	/* network buffer of an infer allocation, NULL otherwise */
+	struct lin_mm_allocation *ntw_alloc;
+	/*
+	 * dma-buf attachments of the infer buffers created over a network
+	 * buffer, most recently used first
+	 */
+	struct ice_dbuf_attach *dbuf_cache;
+	/* number of entries in 'dbuf_cache' with no user */
+	u32 dbuf_cache_idle_nr;
 };
 
 
@@ -424,9 +458,60 @@ out:
 	return retval;
 }
 
+/*
+ * map one physically contiguous run of a scatter/gather list
+ * inputs : adom - domain in which the run is mapped
+ *          alloc
+ *          mmu_config - MMU config of the allocation's partition
+ *          offset - offset of the run's first segment
+ *          dma_addr - device physical address of the run
+ *          len - length of the run in bytes
+ *          iova - page frame index at which the run is mapped
+ *          total_size_bytes - bytes of the allocation mapped so far,
+ *                             updated with this run
+ * outputs: out_pages_nr - number of ICE pages consumed by the run
+ * returns: 0 on success, a negative error code on failure
+ */
+static int map_sg_run(struct cve_lin_mm_domain *adom,
+		struct lin_mm_allocation *alloc,
+		struct ice_mmu_config *mmu_config,
+		u32 offset, cve_dma_addr_t dma_addr, u64 len, u32 iova,
+		u64 *total_size_bytes, u32 *out_pages_nr)
+{
+	/* each run is aligned to CVE page
+	 * to calculate minimum num of CVE pages required
+	 * offset is OS page aligned
+	 */
+	u64 run_size = round_up_cve_pagesize(
+			(offset & (mmu_config->page_sz - 1)) + len,
+			mmu_config->page_sz);
+	u64 size_bytes = run_size;
+	int retval;
+
+	*total_size_bytes += run_size;
+	if (*total_size_bytes >= alloc->size_bytes)
+		size_bytes -= (*total_size_bytes - alloc->size_bytes);
+
+	retval = lin_mm_map(adom,
+			IOVA_TO_VADDR(iova, mmu_config->page_shift),
+			dma_addr,
+			size_bytes,
+			&alloc->buf_meta_data);
+	if (retval) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+			"lin_mm_map failed %d\n", retval);
+		return retval;
+	}
+
+	*out_pages_nr = bytes_to_cve_pages(run_size, mmu_config->page_shift);
+
+	return 0;
+}
+
 /*
  * add all the papges in the given allocation's scatter/gather list
- * to the device's page tables.
+ * to the device's page tables. segments which are back to back in device
+ * physical memory are mapped as a single run.
  * inputs : alloc
  *          cve_alloc_data - pointer to cve specific alloc data (dma & domain)
  *          cve_vaddr - the device-virtual address at which the allocation
@@ -445,8 +530,10 @@ static int add_sglist_to_device_page_table(struct lin_mm_allocation *alloc,
 	struct cve_lin_mm_domain *adom =
 		(struct cve_lin_mm_domain *)cve_alloc_data->domain;
 	struct ice_mmu_config *mmu_config = &(adom->mmu_config[partition_id]);
-	struct scatterlist *sg = NULL;
-	u32 mapped_pages_nr = 0;
+	struct scatterlist *sg = NULL, *run_sg = NULL;
+	cve_dma_addr_t run_end = 0;
+	u64 run_len = 0;
+	u32 mapped_pages_nr = 0, run_pages_nr;
 	int retval = CVE_DEFAULT_ERROR_CODE;
 	u32 base_iova, iova;
 	int i;
@@ -459,37 +546,39 @@ static int add_sglist_to_device_page_table(struct lin_mm_allocation *alloc,
 
 	for_each_sg(sglist, sg, nents, i) {
 
-		/* each segment in list is aligned to CVE page
-		 * to calculate minimum num of CVE pages required
-		 * sg->offset is OS page aligned
-		 */
-		u32 size_bytes = round_up_cve_pagesize(
-				(sg->offset & (mmu_config->page_sz - 1)) +
-				sg_dma_len(sg), mmu_config->page_sz);
-		u32 size_cve_pages = bytes_to_cve_pages(size_bytes,
-				mmu_config->page_shift);
-		ice_va_t cva = IOVA_TO_VADDR(iova, mmu_config->page_shift);
-
-		total_size_bytes += size_bytes;
-		if (total_size_bytes >= alloc->size_bytes)
-			size_bytes -= (total_size_bytes - alloc->size_bytes);
-
-		retval = lin_mm_map(adom,
-				cva,
-				sg_dma_address(sg),
-				size_bytes,
-				&alloc->buf_meta_data);
-		if (retval) {
-			cve_os_log(CVE_LOGLEVEL_ERROR,
-				"lin_mm_map failed %d\n", retval);
-			goto cleanup_error;
+		if (run_sg && sg_dma_address(sg) == run_end) {
+			run_len += sg_dma_len(sg);
+			run_end += sg_dma_len(sg);
+			continue;
 		}
 
-		if (total_size_bytes >= alloc->size_bytes)
-			break;
+		if (run_sg) {
+			retval = map_sg_run(adom, alloc, mmu_config,
+					run_sg->offset, sg_dma_address(run_sg),
+					run_len, iova, &total_size_bytes,
+					&run_pages_nr);
+			if (retval)
+				goto cleanup_error;
+
+			if (total_size_bytes >= alloc->size_bytes)
+				break;
+
+			iova += run_pages_nr;
+			mapped_pages_nr += run_pages_nr;
+		}
 
-		iova += size_cve_pages;
-		mapped_pages_nr += size_cve_pages;
+		run_sg = sg;
+		run_len = sg_dma_len(sg);
+		run_end = sg_dma_address(sg) + sg_dma_len(sg);
+	}
+
+	if (run_sg && total_size_bytes < alloc->size_bytes) {
+		retval = map_sg_run(adom, alloc, mmu_config,
+				run_sg->offset, sg_dma_address(run_sg),
+				run_len, iova, &total_size_bytes,
+				&run_pages_nr);
+		if (retval)
+			goto cleanup_error;
 	}
 
 	/* success */
@@ -540,6 +629,8 @@ static int pin_user_memory(struct lin_mm_allocation *alloc)
 	u32 array_size;
 	int os_pages_nr;
 	struct page **pages = NULL;
+	struct ice_pin_entry *entry;
+	u32 seq;
 	long nr = 0;
 	int ret = -ENOMEM;
 	int is_writable =
@@ -556,6 +647,17 @@ static int pin_user_memory(struct lin_mm_allocation *alloc)
 	os_pages_nr = calc_alloc_os_pages_nr(alloc);
 	array_size = os_pages_nr * sizeof(struct page *);
 
+	/* must be done before taking mmap_sem */
+	entry = ice_pin_cache_get(start, alloc->size_bytes,
+			alloc->buf_meta_data.prot, !alloc->prefetch, &seq);
+	if (entry) {
+		alloc->pin_entry = entry;
+		alloc->pages = entry->pages;
+		alloc->os_pages_nr = entry->os_pages_nr;
+		ret = 0;
+		goto out;
+	}
+
 	ret = OS_ALLOC_ZERO(array_size, (void **)&pages);
 	if (ret != 0) {
 		cve_os_log(CVE_LOGLEVEL_ERROR,
@@ -596,6 +698,9 @@ static int pin_user_memory(struct lin_mm_allocation *alloc)
 
 	alloc->pages = pages;
 	alloc->os_pages_nr = os_pages_nr;
+	alloc->pin_entry = ice_pin_cache_add(start, alloc->size_bytes,
+			alloc->buf_meta_data.prot, pages, os_pages_nr,
+			!alloc->prefetch, seq);
 
 out:
 	FUNC_LEAVE();
@@ -630,6 +735,16 @@ static void unpin_user_memory(struct lin_mm_allocation *alloc)
 		return;
 	}
 
+	/* the cache keeps the pages pinned */
+	if (alloc->pin_entry) {
+		ice_pin_cache_put(alloc->pin_entry, !alloc->prefetch);
+		alloc->pin_entry = NULL;
+		alloc->pages = NULL;
+		alloc->os_pages_nr = 0;
+		FUNC_LEAVE();
+		return;
+	}
+
 	might_be_dirty = ((alloc->buf_meta_data.prot & CVE_MM_PROT_WRITE) != 0);
 
 	while (alloc->os_pages_nr) {
@@ -646,6 +761,32 @@ static void unpin_user_memory(struct lin_mm_allocation *alloc)
 	FUNC_LEAVE();
 }
 
+int cve_osmm_prefetch_user_buffer(void *vaddr, u64 size_bytes, u32 prot)
+{
+	struct lin_mm_allocation alloc;
+	int ret;
+
+	/* pages pinned here would be released right away */
+	if (!ice_get_pin_cache_max_entries())
+		return 0;
+
+	memset(&alloc, 0, sizeof(alloc));
+	alloc.vaddr = vaddr;
+	alloc.size_bytes = size_bytes;
+	alloc.mem_type = OSMM_USER_MEMORY;
+	alloc.buf_meta_data.prot = prot;
+	alloc.prefetch = 1;
+
+	ret = pin_user_memory(&alloc);
+	if (ret != 0)
+		return ret;
+
+	/* the registration cache keeps the pages pinned */
+	unpin_user_memory(&alloc);
+
+	return 0;
+}
+
 /*
  * allocate sg for user pages
  * inputs : alloc - user allocation general data
@@ -716,6 +857,63 @@ static void user_mem_free_sg(struct cve_os_allocation *cve_alloc_data)
 	FUNC_LEAVE();
 }
 
+/*
+ * reuse the DMA mapped sg table of the allocation's pin cache entry
+ * inputs : alloc - user allocation general data
+ *          cve_alloc_data - cve specific allocation data
+ * outputs: the allocation's 'sgt'
+ * returns: 1 if the cached table is mapped for the domain's device,
+ *          0 otherwise
+ */
+static int user_mem_get_cached_sg(struct lin_mm_allocation *alloc,
+	struct cve_os_allocation *cve_alloc_data)
+{
+	struct ice_pin_entry *entry = alloc->pin_entry;
+	struct cve_lin_mm_domain *adom =
+		(struct cve_lin_mm_domain *)cve_alloc_data->domain;
+
+	if (!entry || !entry->sgt ||
+		entry->dev != to_cve_os_device(adom->cve_dev)->dev)
+		return 0;
+
+	cve_alloc_data->dma_handle.mem_type = CVE_MEMORY_TYPE_USER;
+	cve_alloc_data->dma_handle.mem_handle.sgt = entry->sgt;
+
+	return 1;
+}
+
+/*
+ * hand a freshly mapped sg table over to the allocation's pin cache entry
+ * so that it outlives the allocation
+ * inputs : alloc - user allocation general data
+ *          cve_alloc_data - cve specific allocation data
+ * outputs:
+ * returns:
+ */
+static void user_mem_cache_sg(struct lin_mm_allocation *alloc,
+	struct cve_os_allocation *cve_alloc_data)
+{
+	struct ice_pin_entry *entry = alloc->pin_entry;
+	struct cve_lin_mm_domain *adom =
+		(struct cve_lin_mm_domain *)cve_alloc_data->domain;
+
+	if (!entry || entry->sgt)
+		return;
+
+	ice_pin_cache_set_sg(entry, cve_alloc_data->dma_handle.mem_handle.sgt,
+			to_cve_os_device(adom->cve_dev)->dev,
+			prot_2_dir(alloc->buf_meta_data.prot));
+}
+
+/* check if the sg table is owned by the allocation's pin cache entry */
+static int user_mem_is_cached_sg(struct lin_mm_allocation *alloc,
+	struct cve_os_allocation *cve_alloc_data)
+{
+	return alloc->pin_entry &&
+		alloc->pin_entry->sgt ==
+			cve_alloc_data->dma_handle.mem_handle.sgt;
+}
+
 static int dma_buf_sharing_connect_to_buffer(
 	struct device *dev,
 	struct lin_mm_allocation *alloc,
@@ -780,6 +978,168 @@ static void dma_buf_sharing_disconnect_from_buffer(
 	FUNC_LEAVE();
 }
 
+static void dma_buf_cache_free_entry(struct ice_dbuf_attach *entry)
+{
+	dma_unmap_sg(entry->dev, entry->sgt->sgl, entry->sgt->nents,
+			entry->dir);
+	dma_buf_unmap_attachment(entry->dbuf_attach, entry->sgt, entry->dir);
+	dma_buf_detach(entry->dbuf, entry->dbuf_attach);
+	dma_buf_put(entry->dbuf);
+
+	OS_FREE(entry, sizeof(*entry));
+}
+
+/*
+ * reuse the dma-buf attachment of an earlier infer buffer created over
+ * the same network buffer
+ * inputs : alloc - infer allocation general data
+ *          cve_alloc_data - cve specific allocation data
+ * outputs: the allocation's 'sgt' and 'dbuf_attach'
+ * returns: 1 if an attachment for the domain's device was found,
+ *          0 otherwise
+ */
+static int dma_buf_cache_get(struct lin_mm_allocation *alloc,
+	struct cve_os_allocation *cve_alloc_data)
+{
+	struct lin_mm_allocation *ntw_alloc = alloc->ntw_alloc;
+	struct cve_lin_mm_domain *adom =
+		(struct cve_lin_mm_domain *)cve_alloc_data->domain;
+	struct device *dev = to_cve_os_device(adom->cve_dev)->dev;
+	struct ice_dbuf_attach *entry;
+
+	if (!ntw_alloc)
+		return 0;
+
+	if (!ntw_alloc->dbuf_cache)
+		goto miss;
+
+	entry = ntw_alloc->dbuf_cache;
+	do {
+		if (entry->dbuf == alloc->dbuf && entry->dev == dev)
+			goto hit;
+		entry = cve_dle_next(entry, list);
+	} while (entry != ntw_alloc->dbuf_cache);
+
+miss:
+	ice_swc_counter_inc(g_sph_swc_global,
+			ICEDRV_SWC_GLOBAL_COUNTER_INF_DBUF_CACHE_MISS);
+	return 0;
+
+hit:
+	if (!entry->refcount)
+		ntw_alloc->dbuf_cache_idle_nr--;
+	entry->refcount++;
+
+	/* keep the list in LRU order */
+	cve_dle_remove_from_list(ntw_alloc->dbuf_cache, list, entry);
+	cve_dle_add_to_list_before(ntw_alloc->dbuf_cache, list, entry);
+	ntw_alloc->dbuf_cache = entry;
+
+	cve_alloc_data->dma_handle.mem_type =
+		CVE_MEMORY_TYPE_SHARED_BUFFER_SG;
+	cve_alloc_data->dma_handle.mem_handle.sgt = entry->sgt;
+	cve_alloc_data->dbuf_attach = entry->dbuf_attach;
+
+	ice_swc_counter_inc(g_sph_swc_global,
+			ICEDRV_SWC_GLOBAL_COUNTER_INF_DBUF_CACHE_HIT);
+	return 1;
+}
+
+/*
+ * hand a freshly mapped dma-buf attachment over to the network buffer
+ * so that it outlives the infer allocation. if no entry can be allocated
+ * the attachment stays owned by the allocation.
+ * inputs : alloc - infer allocation general data
+ *          cve_alloc_data - cve specific allocation data
+ * outputs:
+ * returns:
+ */
+static void dma_buf_cache_add(struct lin_mm_allocation *alloc,
+	struct cve_os_allocation *cve_alloc_data)
+{
+	struct lin_mm_allocation *ntw_alloc = alloc->ntw_alloc;
+	struct cve_lin_mm_domain *adom =
+		(struct cve_lin_mm_domain *)cve_alloc_data->domain;
+	struct ice_dbuf_attach *entry = NULL;
+
+	if (!ntw_alloc)
+		return;
+
+	if (OS_ALLOC_ZERO(sizeof(*entry), (void **)&entry) != 0)
+		return;
+
+	get_dma_buf(alloc->dbuf);
+	entry->dbuf = alloc->dbuf;
+	entry->dev = to_cve_os_device(adom->cve_dev)->dev;
+	entry->dbuf_attach = cve_alloc_data->dbuf_attach;
+	entry->sgt = cve_alloc_data->dma_handle.mem_handle.sgt;
+	entry->dir = prot_2_dir(alloc->buf_meta_data.prot);
+	entry->refcount = 1;
+
+	cve_dle_add_to_list_before(ntw_alloc->dbuf_cache, list, entry);
+	ntw_alloc->dbuf_cache = entry;
+}
+
+/*
+ * drop the infer allocation's reference of a cached attachment. unused
+ * attachments beyond ICE_DBUF_CACHE_IDLE_MAX are released, least
+ * recently used first.
+ * inputs : alloc - infer allocation general data
+ *          cve_alloc_data - cve specific allocation data
+ * outputs:
+ * returns: 1 if the attachment is owned by the cache, 0 otherwise
+ */
+static int dma_buf_cache_put(struct lin_mm_allocation *alloc,
+	struct cve_os_allocation *cve_alloc_data)
+{
+	struct lin_mm_allocation *ntw_alloc = alloc->ntw_alloc;
+	struct ice_dbuf_attach *entry, *prev;
+
+	if (!ntw_alloc)
+		return 0;
+
+	entry = cve_dle_lookup(ntw_alloc->dbuf_cache, list, dbuf_attach,
+			cve_alloc_data->dbuf_attach);
+	if (!entry)
+		return 0;
+
+	if (--entry->refcount)
+		return 1;
+
+	ntw_alloc->dbuf_cache_idle_nr++;
+
+	entry = cve_dle_prev(ntw_alloc->dbuf_cache, list);
+	while (ntw_alloc->dbuf_cache_idle_nr > ICE_DBUF_CACHE_IDLE_MAX) {
+		prev = cve_dle_prev(entry, list);
+		if (!entry->refcount) {
+			cve_dle_remove_from_list(ntw_alloc->dbuf_cache, list,
+					entry);
+			ntw_alloc->dbuf_cache_idle_nr--;
+			dma_buf_cache_free_entry(entry);
+		}
+		entry = prev;
+	}
+
+	return 1;
+}
+
+/* release the cached attachments of a network buffer */
+static void dma_buf_cache_drain(struct lin_mm_allocation *ntw_alloc)
+{
+	struct ice_dbuf_attach *entry;
+
+	while (ntw_alloc->dbuf_cache) {
+		entry = ntw_alloc->dbuf_cache;
+
+		/* infer buffers are destroyed before the network buffer */
+		ASSERT(!entry->refcount);
+
+		cve_dle_remove_from_list(ntw_alloc->dbuf_cache, list, entry);
+		dma_buf_cache_free_entry(entry);
+	}
+	ntw_alloc->dbuf_cache_idle_nr = 0;
+}
+
 static int ice_osmm_get_iceva(struct lin_mm_allocation *ntw_alloc,
 		struct lin_mm_allocation *inf_alloc)
 {
@@ -929,7 +1289,8 @@ static int ice_osmm_get_sgt(struct cve_dma_handle **dma_handle,
 		cve_alloc_data->cve_index =
 			domain->cve_dev->dev_index;
 
-		if (USER_MEM_ONLY(mem_type)) {
+		if (USER_MEM_ONLY(mem_type) &&
+			!user_mem_get_cached_sg(alloc, cve_alloc_data)) {
 			/*
 			 * kernel memory is either allocated with
 			 * dma_coherent_alloc for contig or allocated as
@@ -956,10 +1317,12 @@ static int ice_osmm_get_sgt(struct cve_dma_handle **dma_handle,
 					sizeof(*cve_alloc_data));
 				goto undo_loop;
 			}
+			user_mem_cache_sg(alloc, cve_alloc_data);
 		}
 
 		/* shared buffer memory (dma_buf) */
-		else if (SHARED_MEM_ONLY(mem_type)) {
+		else if (SHARED_MEM_ONLY(mem_type) &&
+			!dma_buf_cache_get(alloc, cve_alloc_data)) {
 			cve_alloc_data->dma_handle.mem_type =
 				CVE_MEMORY_TYPE_SHARED_BUFFER_SG;
 			dev = to_cve_os_device(domain->cve_dev)->dev;
@@ -987,6 +1350,7 @@ static int ice_osmm_get_sgt(struct cve_dma_handle **dma_handle,
 					sizeof(*cve_alloc_data));
 				goto undo_loop;
 			}
+			dma_buf_cache_add(alloc, cve_alloc_data);
 		}
 
 		cve_os_log(CVE_LOGLEVEL_DEBUG,
@@ -1015,7 +1379,12 @@ undo_loop:
 				list,
 				cve_alloc);
 
-		if (cve_alloc->dma_handle.mem_type == CVE_MEMORY_TYPE_USER) {
+		if (cve_alloc->dma_handle.mem_type == CVE_MEMORY_TYPE_USER &&
+			user_mem_is_cached_sg(alloc, cve_alloc)) {
+			cve_sync_sgt_to_llc(
+				cve_alloc->dma_handle.mem_handle.sgt);
+		} else if (cve_alloc->dma_handle.mem_type ==
+			CVE_MEMORY_TYPE_USER) {
 			unmap_user_allocation(cve_alloc,
 				prot_2_dir(alloc->buf_meta_data.prot),
 				cve_alloc->dma_handle.mem_handle.sgt->nents);
@@ -1025,7 +1394,8 @@ undo_loop:
 		}
 
 		if (cve_alloc->dma_handle.mem_type ==
-			CVE_MEMORY_TYPE_SHARED_BUFFER_SG) {
+			CVE_MEMORY_TYPE_SHARED_BUFFER_SG &&
+			!dma_buf_cache_put(alloc, cve_alloc)) {
 			unmap_user_allocation(cve_alloc,
 				prot_2_dir(alloc->buf_meta_data.prot),
 				cve_alloc->dma_handle.mem_handle.sgt->nents);
@@ -1068,7 +1438,13 @@ static void ice_osmm_release_sgt(struct lin_mm_allocation *alloc)
 				list,
 				cve_alloc);
 
-		if (cve_alloc->dma_handle.mem_type == CVE_MEMORY_TYPE_USER) {
+		if (cve_alloc->dma_handle.mem_type == CVE_MEMORY_TYPE_USER &&
+			user_mem_is_cached_sg(alloc, cve_alloc)) {
+			/* the cache keeps the table mapped */
+			cve_sync_sgt_to_llc(
+				cve_alloc->dma_handle.mem_handle.sgt);
+		} else if (cve_alloc->dma_handle.mem_type ==
+			CVE_MEMORY_TYPE_USER) {
 			unmap_user_allocation(cve_alloc, dir,
 				cve_alloc->dma_handle.mem_handle.sgt->nents);
 			cve_sync_sgt_to_llc(
@@ -1077,7 +1453,8 @@ static void ice_osmm_release_sgt(struct lin_mm_allocation *alloc)
 		}
 
 		if (cve_alloc->dma_handle.mem_type ==
-			CVE_MEMORY_TYPE_SHARED_BUFFER_SG) {
+			CVE_MEMORY_TYPE_SHARED_BUFFER_SG &&
+			!dma_buf_cache_put(alloc, cve_alloc)) {
 			unmap_user_allocation(cve_alloc, dir,
 				cve_alloc->dma_handle.mem_handle.sgt->nents);
 
@@ -1202,6 +1579,140 @@ void ice_osmm_get_inf_ice_domain(
 	}
 }
 
+#if ICE_ENABLE_EXTENDED_VA_MODE
+/* large pages a buffer may be promoted to, largest first */
+static const struct {
+	u8 page_shift;
+	u8 partition_id;
+} large_page_cfg[] = {
+	{ICE_PAGE_SHIFT_32M, MEM_PARTITION_HIGH_32MB},
+	{ICE_PAGE_SHIFT_16M, MEM_PARTITION_HIGH_16MB},
+};
+
+/*
+ * check if the device physical layout of an allocation can be mapped with
+ * pages of the given size. every physically contiguous run must start on
+ * a page boundary and span whole pages, so that no memory outside of the
+ * buffer becomes visible to the ICE.
+ */
+static bool is_mappable_with_page_sz(struct lin_mm_allocation *alloc,
+		struct cve_os_allocation *cve_alloc_data, u64 page_sz)
+{
+	struct sg_table *sgt = cve_alloc_data->dma_handle.mem_handle.sgt;
+	enum cve_memory_type mem_type = cve_alloc_data->dma_handle.mem_type;
+	cve_dma_addr_t run_start = 0, run_end = 0;
+	struct scatterlist *sg;
+	unsigned int i;
+
+	if (mem_type != CVE_MEMORY_TYPE_USER &&
+		mem_type != CVE_MEMORY_TYPE_KERNEL_SG &&
+		mem_type != CVE_MEMORY_TYPE_SHARED_BUFFER_SG) {
+		run_start = cve_alloc_data->dma_handle.mem_handle.dma_address;
+		return IS_ALIGNED(run_start, page_sz) &&
+			IS_ALIGNED(alloc->size_bytes, page_sz);
+	}
+
+	for_each_sg(sgt->sgl, sg, sgt->nents, i) {
+		if (i && sg_dma_address(sg) == run_end) {
+			run_end += sg_dma_len(sg);
+			continue;
+		}
+
+		if (i && !IS_ALIGNED(run_end - run_start, page_sz))
+			return false;
+
+		run_start = sg_dma_address(sg);
+		if (!IS_ALIGNED(run_start, page_sz))
+			return false;
+		run_end = run_start + sg_dma_len(sg);
+	}
+
+	return (run_end != run_start) &&
+		IS_ALIGNED(run_end - run_start, page_sz);
+}
+
+/*
+ * Move an allocation which UMD allowed above 4GB with the default page size
+ * into a large page partition if all its DMA mappings are suitably
+ * contiguous. The VA consumed is bounded by the part of the partition that
+ * is not reserved by the network's page size config.
+ */
+static void promote_to_large_page(struct lin_mm_allocation *alloc)
+{
+	struct cve_os_allocation *cve_alloc_data;
+	struct cve_lin_mm_domain *domain;
+	u64 page_sz = 0, sz = 0;
+	u32 i, j;
+	u8 pid = 0;
+
+	if (!ice_enable_large_page_promotion() ||
+		alloc->buf_meta_data.partition_id != MEM_PARTITION_HIGH_32KB)
+		return;
+
+	for (j = 0; j < ARRAY_SIZE(large_page_cfg); j++) {
+		page_sz = ICE_PAGE_SZ(large_page_cfg[j].page_shift);
+		pid = large_page_cfg[j].partition_id;
+		sz = round_up_cve_pagesize(alloc->actual_sz, page_sz);
+
+		cve_alloc_data = alloc->per_cve;
+		for (i = 0; i < alloc->dma_domain_array_size; i++) {
+			domain = (struct cve_lin_mm_domain *)alloc->hdomain[i];
+
+			if (domain->promote_budget[pid] < sz ||
+				!is_mappable_with_page_sz(alloc,
+					cve_alloc_data, page_sz))
+				break;
+
+			cve_alloc_data = cve_dle_next(cve_alloc_data, list);
+		}
+
+		if (i == alloc->dma_domain_array_size)
+			break;
+	}
+
+	if (j == ARRAY_SIZE(large_page_cfg))
+		return;
+
+	for (i = 0; i < alloc->dma_domain_array_size; i++) {
+		domain = (struct cve_lin_mm_domain *)alloc->hdomain[i];
+		domain->promote_budget[pid] -= sz;
+	}
+
+	cve_os_log(CVE_LOGLEVEL_DEBUG,
+			"Promoted buffer SizeBytes=0x%llx PageSz=0x%llx Partition=%u\n",
+			alloc->size_bytes, page_sz, pid);
+
+	alloc->page_sz = page_sz;
+	alloc->page_shift = large_page_cfg[j].page_shift;
+	alloc->buf_meta_data.partition_id = pid;
+	alloc->ice_pages_nr = calc_alloc_cve_pages_nr(alloc);
+	alloc->promoted = 1;
+}
+
+/* give the VA budget of a promoted allocation back to its partition */
+static void put_promote_budget(struct lin_mm_allocation *alloc)
+{
+	struct cve_lin_mm_domain *domain;
+	u8 pid = alloc->buf_meta_data.partition_id;
+	u32 i;
+
+	for (i = 0; i < alloc->dma_domain_array_size; i++) {
+		domain = (struct cve_lin_mm_domain *)alloc->hdomain[i];
+		domain->promote_budget[pid] +=
+			(u64)alloc->ice_pages_nr << alloc->page_shift;
+	}
+	alloc->promoted = 0;
+}
+#else
+static inline void promote_to_large_page(struct lin_mm_allocation *alloc)
+{
+}
+
+static inline void put_promote_budget(struct lin_mm_allocation *alloc)
+{
+}
+#endif
+
 /* INTERFACE FUNCTIONS */
 
 /*
@@ -1246,6 +1757,7 @@ int cve_osmm_inf_dma_buf_map(u64 inf_id,
 	memcpy(inf_alloc->hdomain, hdomain,
 		dma_domain_array_size * sizeof(os_domain_handle));
 	inf_alloc->dma_domain_array_size = ntw_alloc->dma_domain_array_size;
+	inf_alloc->ntw_alloc = ntw_alloc;
 
 	retval = ice_osmm_get_iceva(ntw_alloc, inf_alloc);
 	if (retval != 0) {
@@ -1337,34 +1849,57 @@ int cve_osmm_dma_buf_map(os_domain_handle *hdomain,
 		goto out;
 	}
 
-	retval = ice_osmm_get_iceva(alloc, alloc);
+	/* DMA mapping is done first so that its layout can decide the
+	 * partition from which the ICE VA is taken
+	 */
+	retval = ice_osmm_get_sgt(dma_handle, alloc_addr, mem_type, alloc);
 	if (retval != 0) {
 		cve_os_log(CVE_LOGLEVEL_ERROR,
-			"ice_osmm_get_iceva failed %d\n", retval);
+			"ice_osmm_get_sgt failed %d\n", retval);
 		goto free_mem;
 	}
 
-	retval = ice_osmm_get_sgt(dma_handle, alloc_addr, mem_type, alloc);
+	if (cve_addr == CVE_INVALID_VIRTUAL_ADDR)
+		promote_to_large_page(alloc);
+
+	retval = ice_osmm_get_iceva(alloc, alloc);
+	if (retval != 0 && alloc->promoted) {
+		/* no room in the large page partition, use the requested one */
+		put_promote_budget(alloc);
+		alloc->cve_vaddr = cve_addr;
+		alloc->page_sz = iova_desc->page_sz;
+		alloc->page_shift = iova_desc->page_shift;
+		alloc->buf_meta_data.partition_id = iova_desc->partition_id;
+		alloc->ice_pages_nr = calc_alloc_cve_pages_nr(alloc);
+
+		retval = ice_osmm_get_iceva(alloc, alloc);
+	}
 	if (retval != 0) {
 		cve_os_log(CVE_LOGLEVEL_ERROR,
-			"ice_osmm_get_sgt failed %d\n", retval);
-		goto release_iceva;
+			"ice_osmm_get_iceva failed %d\n", retval);
+		goto release_sgt;
 	}
 
 	retval = ice_osmm_set_pte(dma_domain_array_size, alloc);
 	if (retval != 0) {
 		cve_os_log(CVE_LOGLEVEL_ERROR,
 			"ice_osmm_set_pte failed %d\n", retval);
-		goto release_sgt;
+		goto release_iceva;
 	}
 
+	iova_desc->page_sz = alloc->page_sz;
+	iova_desc->page_shift = alloc->page_shift;
+	iova_desc->partition_id = alloc->buf_meta_data.partition_id;
+
 	*out_halloc = alloc;
 	goto out;
 
-release_sgt:
-	ice_osmm_release_sgt(alloc);
 release_iceva:
 	ice_osmm_release_iceva(alloc);
+	if (alloc->promoted)
+		put_promote_budget(alloc);
+release_sgt:
+	ice_osmm_release_sgt(alloc);
 free_mem:
 	OS_FREE(alloc, sizeof(*alloc));
 out:
@@ -1391,8 +1926,13 @@ void cve_osmm_dma_buf_unmap(os_allocation_handle halloc,
 		ice_osmm_release_sgt(ntw_alloc);
 
 		ice_osmm_release_iceva(ntw_alloc);
+
+		if (ntw_alloc->promoted)
+			put_promote_budget(ntw_alloc);
 	}
 
+	dma_buf_cache_drain(ntw_alloc);
+
 	OS_FREE(ntw_alloc, sizeof(*ntw_alloc));
 
 	FUNC_LEAVE();
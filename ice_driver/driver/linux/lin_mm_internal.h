@@ -20,10 +20,13 @@
 #include "linux_kernel_mock.h"
 #include <stdint.h>
 #include <stdint_ext.h>
+#else
+#include <linux/dma-direction.h>
 #endif
 
 #include "sph_device_regs.h"
 #include "iova_allocator.h"
+#include "doubly_linked_list.h"
 
 enum iova_partition_list {
 	ICE_MEM_BASE_PARTITION = 0,
@@ -99,6 +102,10 @@ struct cve_lin_mm_domain {
 	/* MMU config, dynamic parameters for MMU configurations */
 	struct ice_mmu_config mmu_config[ICE_MEM_MAX_PARTITION];
 	u32 page_sz_reg_config_arr[ICE_PAGE_SZ_CONFIG_REG_COUNT];
+	/* VA (bytes) of large page partitions which is not claimed by the
+	 * network's page size config and may be used for promoted buffers
+	 */
+	u64 promote_budget[ICE_MEM_MAX_PARTITION];
 };
 
 /*
@@ -167,4 +174,104 @@ void lin_mm_unmap(struct cve_lin_mm_domain *adom,
 
 void cve_page_table_dump(struct cve_lin_mm_domain *adom);
 
+struct ice_pin_mm;
+
+/* user buffer kept pinned by the registration cache */
+struct ice_pin_entry {
+	struct cve_dle_t list;
+	/* process which owns the buffer */
+	struct ice_pin_mm *pin_mm;
+	/* key */
+	unsigned long vaddr;
+	u64 size_bytes;
+	u32 prot;
+	/* pinned page frames */
+	struct page **pages;
+	u32 os_pages_nr;
+	/*
+	 * sg table of the pages, DMA mapped for 'dev'. NULL until the first
+	 * allocation over the buffer hands its table over to the cache.
+	 * Set under the cache lock, see ice_pin_cache_set_sg()
+	 */
+	struct sg_table *sgt;
+	struct device *dev;
+	enum dma_data_direction dir;
+	/* number of allocations using the entry */
+	u32 refcount;
+	/* number of those which map the buffer for the device */
+	u32 dma_refcount;
+};
+
+#ifndef RING3_VALIDATION
+/*
+ * look up a pinned buffer of the current process
+ * inputs : vaddr, size_bytes, prot - the buffer
+ *          dma_user - the caller maps the buffer for the device. 0 on the
+ *                     prefetch path, which runs outside of the driver lock
+ *                     and must not sync a buffer the device may be using
+ * outputs: out_seq - invalidation sequence to pass to ice_pin_cache_add()
+ *                    on a miss
+ * returns: the entry with a reference taken, NULL on a miss
+ */
+struct ice_pin_entry *ice_pin_cache_get(unsigned long vaddr,
+		u64 size_bytes, u32 prot, u8 dma_user, u32 *out_seq);
+
+/*
+ * hand over pages pinned after a miss to the cache
+ * inputs : vaddr, size_bytes, prot - the buffer
+ *          pages, os_pages_nr - the pinned page frames
+ *          dma_user - as in ice_pin_cache_get()
+ *          seq - sequence returned by the failed lookup
+ * outputs:
+ * returns: the new entry with a reference taken, NULL if the buffer is
+ *          not cached and the caller still owns the pages
+ */
+struct ice_pin_entry *ice_pin_cache_add(unsigned long vaddr,
+		u64 size_bytes, u32 prot, struct page **pages,
+		u32 os_pages_nr, u8 dma_user, u32 seq);
+
+/* hand the DMA mapped sg table of the buffer over to the entry */
+void ice_pin_cache_set_sg(struct ice_pin_entry *entry,
+		struct sg_table *sgt, struct device *dev,
+		enum dma_data_direction dir);
+
+/*
+ * drop a reference taken by ice_pin_cache_get()/ice_pin_cache_add(),
+ * dma_user must match the one the reference was taken with
+ */
+void ice_pin_cache_put(struct ice_pin_entry *entry, u8 dma_user);
+
+/* release all the cached buffers, on module unload */
+void ice_pin_cache_fini(void);
+#else
+static inline struct ice_pin_entry *ice_pin_cache_get(unsigned long vaddr,
+		u64 size_bytes, u32 prot, u8 dma_user, u32 *out_seq)
+{
+	*out_seq = 0;
+	return NULL;
+}
+
+static inline struct ice_pin_entry *ice_pin_cache_add(unsigned long vaddr,
+		u64 size_bytes, u32 prot, struct page **pages,
+		u32 os_pages_nr, u8 dma_user, u32 seq)
+{
+	return NULL;
+}
+
+static inline void ice_pin_cache_set_sg(struct ice_pin_entry *entry,
+		struct sg_table *sgt, struct device *dev,
+		enum dma_data_direction dir)
+{
+}
+
+static inline void ice_pin_cache_put(struct ice_pin_entry *entry,
+		u8 dma_user)
+{
+}
+
+static inline void ice_pin_cache_fini(void)
+{
+}
+#endif
+
 #endif /* _LIN_MM_INTERNAL_H_ */
@@ -450,94 +450,127 @@ static void __dealloc_l2_page(struct cve_lin_mm_domain *cve_domain,
 }
 
 /*
- * map a page in the page table of the given memory domain
+ * build the L2 entry bits which are common to all pages of a buffer
+ * inputs : buf_meta_data - access permissions and llc policy
+ * outputs: out_entry_bits - protection and llc bits of the L2 entry
+ * returns: 0 on success, a negative error code on failure
+ */
+static int l2_entry_bits(struct ice_lin_mm_buf_config *buf_meta_data,
+		pt_entry_t *out_entry_bits)
+{
+	pt_entry_t entry_bits = 0;
+	int retval;
+
+	/* there are 3 bits for protection */
+	if (buf_meta_data->prot & CVE_MM_PROT_READ)
+		entry_bits |= CVE_PROT_READ_BIT;
+	if (buf_meta_data->prot & CVE_MM_PROT_WRITE)
+		entry_bits |= CVE_PROT_WRITE_BIT;
+
+	retval = cve_pt_llc_update(&entry_bits, buf_meta_data->llc_policy);
+	if (retval != 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+			"cve_project_ddr_addr_remapping failed %d\n",
+			retval);
+		return retval;
+	}
+
+	*out_entry_bits = entry_bits;
+	return 0;
+}
+
+/*
+ * make sure that L2 pages exist for the given range of the page directory
  * inputs : cve_domain - the memory domain
- *          iova - device's virtual address where the page will be
- *                 mapped.
- *                 the offset into the page is cleared
- *          dma_addr - the address which the device sees.
- *                     the offset into the page is cleared by the function
- *          prot - access permissions
- *          llc_policy - hold the index of the llc policy in
- *                       the AXI attribute table
+ *          mmu_config - configuration of the partition being mapped
+ *          va_start - first device virtual address of the range
+ *          va_end - device virtual address right after the range
  * outputs:
  * returns: 0 on success, a negative error code on failure
  */
-static int l2_map_page(struct cve_lin_mm_domain *cve_domain,
-		ice_va_t iova,
-		cve_dma_addr_t dma_addr,
-		struct ice_lin_mm_buf_config *buf_meta_data)
+static int l2_prealloc_range(struct cve_lin_mm_domain *cve_domain,
+		struct ice_mmu_config *mmu_config,
+		ice_va_t va_start,
+		ice_va_t va_end)
 {
-	int retval = -ENOMEM;
-	struct ice_mmu_config *mmu_config =
-		&cve_domain->mmu_config[buf_meta_data->partition_id];
-	u8 page_shift = mmu_config->page_shift;
-	u32 l1_idx = iova >> ICE_L1PT_SHIFT;
-	pt_entry_t l1_entry = cve_domain->pgd_vaddr[l1_idx];
-	pt_entry_t *l2_pt_vaddr;
-	cve_dma_addr_t l2_pt_dma_addr;
-	ice_va_t iova_start = iova;
-	unsigned int l2_idx;
-	pt_entry_t prot_bits = 0;
+	u32 l1_idx = va_start >> ICE_L1PT_SHIFT;
+	u32 l1_last;
+	int retval = 0;
 
-	FUNC_ENTER();
+	if (va_end <= va_start)
+		return 0;
+
+	l1_last = (va_end - 1) >> ICE_L1PT_SHIFT;
+	for (; l1_idx <= l1_last; l1_idx++) {
+		/* L2 page shared by several PD entries is set for all */
+		if (cve_domain->pgd_vaddr[l1_idx] != INVALID_PAGE)
+			continue;
 
-	if (l1_entry == INVALID_PAGE) {
 		retval = __alloc_new_l2_page(cve_domain, mmu_config, l1_idx);
 		if (retval != 0) {
 			cve_os_log(CVE_LOGLEVEL_ERROR,
 				"alloc_page_table failed %d\n", retval);
-			goto out;
+			break;
 		}
-		l1_entry = cve_domain->pgd_vaddr[l1_idx];
 	}
 
-	l2_pt_vaddr = cve_domain->virtual_l1[l1_idx];
-	l2_pt_dma_addr = TBL_DMA_ADDR(cve_domain->pgd_vaddr[l1_idx]);
-	ASSERT((l2_pt_vaddr) && (l2_pt_dma_addr != 0));
-
-	dma_addr = round_down_cve_pagesize(dma_addr, mmu_config->page_sz);
+	return retval;
+}
 
-	l2_idx = ((iova_start >> page_shift) &
+/*
+ * map contiguous pages which belong to a single L2 page in the page table
+ * of the given memory domain. L2 page must already exist.
+ * inputs : cve_domain - the memory domain
+ *          iova - device's virtual address of the first page, page aligned
+ *          dma_addr - the address which the device sees for the first
+ *                     page, page aligned
+ *          pages_nr - number of pages to map
+ *          entry_bits - protection and llc bits of the L2 entries
+ *          mmu_config - configuration of the partition being mapped
+ * outputs:
+ * returns: 0 on success, a negative error code on failure. Nothing is
+ *          mapped on failure.
+ */
+static int l2_map_range(struct cve_lin_mm_domain *cve_domain,
+		ice_va_t iova,
+		cve_dma_addr_t dma_addr,
+		u32 pages_nr,
+		pt_entry_t entry_bits,
+		struct ice_mmu_config *mmu_config)
+{
+	u32 l1_idx = iova >> ICE_L1PT_SHIFT;
+	pt_entry_t *l2_pt_vaddr = cve_domain->virtual_l1[l1_idx];
+	cve_dma_addr_t __maybe_unused l2_pt_dma_addr =
+		TBL_DMA_ADDR(cve_domain->pgd_vaddr[l1_idx]);
+	u32 l2_idx = ((iova >> mmu_config->page_shift) &
 		       ICE_L2PT_MASK(mmu_config->l2_width));
+	u32 i;
 
-	if (l2_pt_vaddr[l2_idx] != INVALID_PAGE) {
-		cve_os_log(CVE_LOGLEVEL_DEBUG,
-			   "double-mapping: pgtbl=<v=%p,d=%pad>, l2_pt=<v=%p,d=%pad> l2_idx %u\n",
-			   cve_domain->pgd_vaddr,
-			   &cve_domain->pgd_dma_handle.mem_handle.dma_address,
-			   l2_pt_vaddr, &l2_pt_dma_addr, l2_idx);
-		retval = -ICEDRV_KERROR_PT_DUPLICATE_ENTRY;
-		goto out;
+	ASSERT((l2_pt_vaddr) && (l2_pt_dma_addr != 0));
+	ASSERT(l2_idx + pages_nr <= ICE_L2PT_PTES(mmu_config->l2_width));
+
+	for (i = l2_idx; i < l2_idx + pages_nr; i++) {
+		if (l2_pt_vaddr[i] != INVALID_PAGE) {
+			cve_os_log(CVE_LOGLEVEL_DEBUG,
+				   "double-mapping: pgtbl=<v=%p,d=%pad>, l2_pt=<v=%p,d=%pad> l2_idx %u\n",
+				   cve_domain->pgd_vaddr,
+				   &cve_domain->pgd_dma_handle.mem_handle.dma_address,
+				   l2_pt_vaddr, &l2_pt_dma_addr, i);
+			return -ICEDRV_KERROR_PT_DUPLICATE_ENTRY;
+		}
 	}
 
-	/* there are 3 bits for protection */
-	if (buf_meta_data->prot & CVE_MM_PROT_READ)
-		prot_bits |= CVE_PROT_READ_BIT;
-	if (buf_meta_data->prot & CVE_MM_PROT_WRITE)
-		prot_bits |= CVE_PROT_WRITE_BIT;
-
-	/* Update PT entry */
-	l2_pt_vaddr[l2_idx] = (dma_addr >> ICE_DEFAULT_L2_SHIFT) | prot_bits;
-
-	retval = cve_pt_llc_update(&l2_pt_vaddr[l2_idx],
-			buf_meta_data->llc_policy);
-	if (retval != 0) {
-		cve_os_log(CVE_LOGLEVEL_ERROR,
-			"cve_project_ddr_addr_remapping failed %d\n",
-			retval);
-		goto out;
+	for (i = l2_idx; i < l2_idx + pages_nr; i++) {
+		l2_pt_vaddr[i] = (dma_addr >> ICE_DEFAULT_L2_SHIFT) |
+			entry_bits;
+		dma_addr += mmu_config->page_sz;
 	}
 
 	cve_os_log(CVE_LOGLEVEL_DEBUG,
-		"[PT] page mapped. ICEVA=0x%llx, PA=0x%llx. PD_Idx=%u, PT_Idx=%u, PT_Entry='0x%x', LLC_Policy=0x%x\n",
-		iova, dma_addr, l1_idx, l2_idx,
-		l2_pt_vaddr[l2_idx], buf_meta_data->llc_policy);
+		"[PT] range mapped. ICEVA=0x%llx, Pages=%u. PD_Idx=%u, PT_Idx=%u, PT_Entry='0x%x'\n",
+		iova, pages_nr, l1_idx, l2_idx, l2_pt_vaddr[l2_idx]);
 
-	retval = 0;
-out:
-	FUNC_LEAVE();
-	return retval;
+	return 0;
 }
 
 /*
@@ -612,9 +645,10 @@ int lin_mm_map(struct cve_lin_mm_domain *adom,
 	u32 cve_pages_nr = (va_end - va_start) >> mmu_config->page_shift;
 	u32 mapped_pages = 0;
 	ice_va_t va = va_start;
-	cve_dma_addr_t da = dma_addr;
+	cve_dma_addr_t da;
+	pt_entry_t entry_bits;
+	u32 l2_idx, l2_ptes, pages_nr;
 	int retval;
-	u32 j;
 
 	FUNC_ENTER();
 	cve_os_log(CVE_LOGLEVEL_DEBUG,
@@ -634,16 +668,36 @@ int lin_mm_map(struct cve_lin_mm_domain *adom,
 		goto out;
 	}
 
-	for (j = 0; j < cve_pages_nr; j++) {
-		retval = l2_map_page(adom, va, da, buf_meta_data);
+	retval = l2_entry_bits(buf_meta_data, &entry_bits);
+	if (retval != 0)
+		goto out;
+
+	/* All L2 pages of the range are created upfront */
+	retval = l2_prealloc_range(adom, mmu_config, va_start, va_end);
+	if (retval != 0)
+		goto out;
+
+	da = round_down_cve_pagesize(dma_addr, mmu_config->page_sz);
+	l2_ptes = ICE_L2PT_PTES(mmu_config->l2_width);
+
+	/* Fill L2 entries one L2 page at a time */
+	while (mapped_pages < cve_pages_nr) {
+		l2_idx = ((va >> mmu_config->page_shift) &
+				ICE_L2PT_MASK(mmu_config->l2_width));
+		pages_nr = cve_pages_nr - mapped_pages;
+		if (pages_nr > l2_ptes - l2_idx)
+			pages_nr = l2_ptes - l2_idx;
+
+		retval = l2_map_range(adom, va, da, pages_nr, entry_bits,
+				mmu_config);
 		if (retval < 0) {
 			cve_os_log(CVE_LOGLEVEL_ERROR,
-				"l2_map_page failed %d\n", retval);
+				"l2_map_range failed %d\n", retval);
 			goto rollback;
 		}
-		va += mmu_config->page_sz;
-		da += mmu_config->page_sz;
-		mapped_pages++;
+		va += (ice_va_t)pages_nr << mmu_config->page_shift;
+		da += (cve_dma_addr_t)pages_nr << mmu_config->page_shift;
+		mapped_pages += pages_nr;
 	}
 	retval = 0;
 out:
@@ -656,15 +710,18 @@ rollback:
 
 
 static void __configure_partition_sz(u64 *sz_per_page_alignment,
-		u64 *infer_buf_page_config, u64 *partition_sz_list)
+		u64 *infer_buf_page_config, u64 *partition_sz_list,
+		u64 *promote_budget_list)
 {
 	u8 i = IOVA_PAGE_ALIGNMENT_32K;
 	u32 max_active_infer;
 	u64 sz, total_sz = 0, infer_sz = 1;
+	u64 ntw_sz[IOVA_PAGE_ALIGNMENT_MAX] = {0};
 
 	/* Calculate total size requirement for buffer in network and infer*/
 	for (; i < IOVA_PAGE_ALIGNMENT_MAX; i++) {
 
+		ntw_sz[i] = sz_per_page_alignment[i];
 		sz_per_page_alignment[i] = round_up_cve_pagesize(
 						sz_per_page_alignment[i],
 						ICE_PAGE_SZ_256M);
@@ -692,9 +749,15 @@ static void __configure_partition_sz(u64 *sz_per_page_alignment,
 		if (partition_sz_list[i] == 0)
 			partition_sz_list[i] = ICE_PAGE_SZ_256M;
 
+		/* VA left after the network and its Infers are served */
+		sz = ntw_sz[i] + (infer_buf_page_config[i] * max_active_infer);
+		promote_budget_list[i] = (partition_sz_list[i] > sz) ?
+			(partition_sz_list[i] - sz) : 0;
+
 		cve_os_log(CVE_LOGLEVEL_DEBUG,
-				"partition_sz_list[%d]:%llu MaxActiveInfer:%d\n",
-				i, partition_sz_list[i], max_active_infer);
+				"partition_sz_list[%d]:%llu MaxActiveInfer:%d PromoteBudget:0x%llx\n",
+				i, partition_sz_list[i], max_active_infer,
+				promote_budget_list[i]);
 	}
 }
 
@@ -706,9 +769,10 @@ static void __do_mmu_config(struct cve_lin_mm_domain *domain,
 	struct ice_mmu_config *mmu_config;
 	u64 start = 0, end = 0;
 	u64 _sz_per_page_alignment[IOVA_PAGE_ALIGNMENT_MAX] = {0};
+	u64 promote_budget[IOVA_PAGE_ALIGNMENT_MAX] = {0};
 
 	__configure_partition_sz(sz_per_page_alignment, infer_buf_page_config,
-			_sz_per_page_alignment);
+			_sz_per_page_alignment, promote_budget);
 
 	for (; partition < ICE_MEM_MAX_PARTITION; partition++) {
 		mmu_config = &domain->mmu_config[partition];
@@ -737,6 +801,8 @@ static void __do_mmu_config(struct cve_lin_mm_domain *domain,
 				_sz_per_page_alignment[IOVA_PAGE_ALIGNMENT_16M];
 			mmu_config->va_end = end;
 			mmu_config->va_start = start;
+			domain->promote_budget[partition] =
+				promote_budget[IOVA_PAGE_ALIGNMENT_16M];
 			break;
 		case MEM_PARTITION_HIGH_32MB:
 			__mmu_config_35bit_va_page_32M(mmu_config);
@@ -745,6 +811,8 @@ static void __do_mmu_config(struct cve_lin_mm_domain *domain,
 				_sz_per_page_alignment[IOVA_PAGE_ALIGNMENT_32M];
 			end = round_up_cve_pagesize(end, ICE_PAGE_SZ_256M);
 			mmu_config->va_end = end;
+			domain->promote_budget[partition] =
+				promote_budget[IOVA_PAGE_ALIGNMENT_32M];
 		}
 
 		mmu_config->pde_start_idx =
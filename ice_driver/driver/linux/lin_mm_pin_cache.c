@@ -0,0 +1,555 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2017-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+/*
+ * Registration cache of pinned user buffers.
+ *
+ * Buffers are keyed by (mm, vaddr, size, prot). The pinned pages and the
+ * DMA mapped sg table of a buffer stay alive after the last allocation over
+ * it is destroyed, so that the next allocation over the same user memory
+ * skips get_user_pages and dma_map_sg.
+ *
+ * An MMU notifier per process marks the entries of a VA range stale when
+ * the range is unmapped or changed, and all the entries of a process when
+ * it exits. Notifier callbacks only move entries to the stale list under
+ * the cache lock; pages are released later from driver context, either on
+ * the next lookup or when the last allocation using the entry goes away.
+ *
+ * Allocations call in with the device group lock taken. Buffers are also
+ * prefetched outside of that lock, so the lists, the reference counts and
+ * the sg table of an entry are only accessed under the cache lock. The
+ * prefetch path never syncs the buffer for the CPU or the device since a
+ * network may be using it; only references taken by allocations, counted
+ * in dma_refcount, do.
+ */
+
+#include <linux/sched.h>
+#include <linux/types.h>
+#include <linux/mm.h>
+#include <linux/mmu_notifier.h>
+#include <linux/spinlock.h>
+#include <linux/dma-mapping.h>
+#include <linux/version.h>
+#include <asm/current.h>
+
+#include "os_interface.h"
+#include "osmm_interface.h"
+#include "cve_device_group.h"
+#include "lin_mm_internal.h"
+#include "ice_sw_counters.h"
+#include "doubly_linked_list.h"
+
+#ifdef CONFIG_MMU_NOTIFIER
+
+#define MMU_NOTIFIER_HAS_RANGE \
+	(KERNEL_VERSION(5, 0, 0) <= LINUX_VERSION_CODE)
+#define MMU_NOTIFIER_HAS_BLOCKABLE \
+	(KERNEL_VERSION(4, 19, 0) <= LINUX_VERSION_CODE)
+
+/* user memory of one process which has entries in the cache */
+struct ice_pin_mm {
+	struct cve_dle_t list;
+	struct mmu_notifier mn;
+	struct mm_struct *mm;
+	/* incremented on every invalidation of the process memory */
+	u32 invalidate_seq;
+	/* set once the process address space is torn down */
+	u8 released;
+	/* number of entries, stale ones included */
+	u32 entries_nr;
+};
+
+/* protects the lists below and the stale state of the entries */
+static DEFINE_SPINLOCK(pin_cache_lock);
+/* valid entries, most recently used first */
+static struct ice_pin_entry *pin_entry_list;
+/* invalidated entries waiting to be released */
+static struct ice_pin_entry *pin_stale_list;
+static struct ice_pin_mm *pin_mm_list;
+/* number of entries in pin_entry_list */
+static u32 pin_entries_nr;
+
+/* mark all the entries of the process overlapping [start, end) stale */
+static void __invalidate_range(struct ice_pin_mm *pin_mm,
+		unsigned long start, unsigned long end)
+{
+	struct ice_pin_entry *entry, *next;
+	u32 i, count;
+
+	spin_lock(&pin_cache_lock);
+
+	pin_mm->invalidate_seq++;
+
+	entry = pin_entry_list;
+	count = pin_entries_nr;
+	for (i = 0; i < count; i++) {
+		next = cve_dle_next(entry, list);
+
+		if (entry->pin_mm == pin_mm &&
+			entry->vaddr < end &&
+			start < entry->vaddr + entry->size_bytes) {
+			cve_dle_move(pin_stale_list, pin_entry_list,
+					list, entry);
+			pin_entries_nr--;
+			ice_swc_counter_atomic_inc(g_sph_swc_global,
+				ICEDRV_SWC_GLOBAL_COUNTER_PIN_CACHE_INVALIDATED);
+		}
+
+		entry = next;
+	}
+
+	spin_unlock(&pin_cache_lock);
+}
+
+#if MMU_NOTIFIER_HAS_RANGE
+static int __mn_invalidate_range_start(struct mmu_notifier *mn,
+		const struct mmu_notifier_range *range)
+{
+	__invalidate_range(container_of(mn, struct ice_pin_mm, mn),
+			range->start, range->end);
+	return 0;
+}
+#elif MMU_NOTIFIER_HAS_BLOCKABLE
+static int __mn_invalidate_range_start(struct mmu_notifier *mn,
+		struct mm_struct *mm,
+		unsigned long start,
+		unsigned long end,
+		bool blockable)
+{
+	__invalidate_range(container_of(mn, struct ice_pin_mm, mn),
+			start, end);
+	return 0;
+}
+#else
+static void __mn_invalidate_range_start(struct mmu_notifier *mn,
+		struct mm_struct *mm,
+		unsigned long start,
+		unsigned long end)
+{
+	__invalidate_range(container_of(mn, struct ice_pin_mm, mn),
+			start, end);
+}
+#endif
+
+static void __mn_release(struct mmu_notifier *mn, struct mm_struct *mm)
+{
+	struct ice_pin_mm *pin_mm = container_of(mn, struct ice_pin_mm, mn);
+
+	spin_lock(&pin_cache_lock);
+	pin_mm->released = 1;
+	spin_unlock(&pin_cache_lock);
+
+	__invalidate_range(pin_mm, 0, ULONG_MAX);
+}
+
+static const struct mmu_notifier_ops pin_cache_mn_ops = {
+	.release = __mn_release,
+	.invalidate_range_start = __mn_invalidate_range_start,
+};
+
+static struct ice_pin_mm *__lookup_pin_mm(struct mm_struct *mm)
+{
+	struct ice_pin_mm *pin_mm;
+
+	pin_mm = cve_dle_lookup(pin_mm_list, list, mm, mm);
+	if (pin_mm && pin_mm->released)
+		return NULL;
+
+	return pin_mm;
+}
+
+static void __free_pin_mm(struct ice_pin_mm *pin_mm)
+{
+	/* waits for running callbacks and drops the reference on the mm */
+	mmu_notifier_unregister(&pin_mm->mn, pin_mm->mm);
+	OS_FREE(pin_mm, sizeof(*pin_mm));
+}
+
+/* returns the tracking object of the current process, registering the
+ * MMU notifier on first use. must not be called with mmap_sem held.
+ * Buffers are also prefetched outside of the driver lock, so two threads
+ * of a process may race to register.
+ */
+static struct ice_pin_mm *__get_pin_mm(void)
+{
+	struct ice_pin_mm *pin_mm, *other;
+	int ret;
+
+	spin_lock(&pin_cache_lock);
+	pin_mm = __lookup_pin_mm(current->mm);
+	spin_unlock(&pin_cache_lock);
+	if (pin_mm)
+		return pin_mm;
+
+	ret = OS_ALLOC_ZERO(sizeof(*pin_mm), (void **)&pin_mm);
+	if (ret != 0)
+		return NULL;
+
+	pin_mm->mm = current->mm;
+	pin_mm->mn.ops = &pin_cache_mn_ops;
+
+	ret = mmu_notifier_register(&pin_mm->mn, pin_mm->mm);
+	if (ret != 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+			"mmu_notifier_register failed %d\n", ret);
+		OS_FREE(pin_mm, sizeof(*pin_mm));
+		return NULL;
+	}
+
+	spin_lock(&pin_cache_lock);
+	other = __lookup_pin_mm(current->mm);
+	if (!other)
+		cve_dle_add_to_list_before(pin_mm_list, list, pin_mm);
+	spin_unlock(&pin_cache_lock);
+
+	if (other) {
+		__free_pin_mm(pin_mm);
+		pin_mm = other;
+	}
+
+	return pin_mm;
+}
+
+/* detach a process object which has no entries left and either exited or
+ * is dropped at module unload, NULL if there is none
+ */
+static struct ice_pin_mm *__pop_unused_pin_mm(u8 include_live)
+{
+	struct ice_pin_mm *pin_mm = pin_mm_list;
+
+	if (!pin_mm)
+		return NULL;
+
+	do {
+		if (!pin_mm->entries_nr &&
+			(pin_mm->released || include_live)) {
+			cve_dle_remove_from_list(pin_mm_list, list, pin_mm);
+			return pin_mm;
+		}
+		pin_mm = cve_dle_next(pin_mm, list);
+	} while (pin_mm != pin_mm_list);
+
+	return NULL;
+}
+
+/* unmap, unpin and free an entry which is no longer in any list */
+static void __release_entry(struct ice_pin_entry *entry)
+{
+	u32 array_size = entry->os_pages_nr * sizeof(struct page *);
+	u32 pages_nr = entry->os_pages_nr;
+	int might_be_dirty = ((entry->prot & CVE_MM_PROT_WRITE) != 0);
+
+	if (entry->sgt) {
+		dma_unmap_sg(entry->dev, entry->sgt->sgl, entry->sgt->nents,
+				entry->dir);
+		sg_free_table(entry->sgt);
+		OS_FREE(entry->sgt, sizeof(*entry->sgt));
+	}
+
+	while (pages_nr) {
+		struct page *p = entry->pages[--pages_nr];
+
+		if (might_be_dirty)
+			SetPageDirty(p);
+		put_page(p);
+	}
+	OS_FREE(entry->pages, array_size);
+
+	spin_lock(&pin_cache_lock);
+	entry->pin_mm->entries_nr--;
+	spin_unlock(&pin_cache_lock);
+
+	OS_FREE(entry, sizeof(*entry));
+}
+
+/* detach an unused entry from the stale list, NULL if there is none */
+static struct ice_pin_entry *__pop_unused_stale(void)
+{
+	struct ice_pin_entry *entry = pin_stale_list;
+
+	if (!entry)
+		return NULL;
+
+	do {
+		if (!entry->refcount) {
+			cve_dle_remove_from_list(pin_stale_list, list, entry);
+			return entry;
+		}
+		entry = cve_dle_next(entry, list);
+	} while (entry != pin_stale_list);
+
+	return NULL;
+}
+
+static void __reap_stale(u8 include_live)
+{
+	struct ice_pin_entry *entry;
+	struct ice_pin_mm *pin_mm;
+
+	for (;;) {
+		spin_lock(&pin_cache_lock);
+		entry = __pop_unused_stale();
+		spin_unlock(&pin_cache_lock);
+
+		if (!entry)
+			break;
+		__release_entry(entry);
+	}
+
+	for (;;) {
+		spin_lock(&pin_cache_lock);
+		pin_mm = __pop_unused_pin_mm(include_live);
+		spin_unlock(&pin_cache_lock);
+
+		if (!pin_mm)
+			break;
+		__free_pin_mm(pin_mm);
+	}
+}
+
+/* detach the least recently used entry if the cache is over its limit */
+static struct ice_pin_entry *__pop_evictable(u32 max_entries)
+{
+	struct ice_pin_entry *entry;
+	u32 i;
+
+	if (pin_entries_nr <= max_entries)
+		return NULL;
+
+	entry = cve_dle_prev(pin_entry_list, list);
+	for (i = 0; i < pin_entries_nr; i++) {
+		if (!entry->refcount) {
+			cve_dle_remove_from_list(pin_entry_list, list, entry);
+			pin_entries_nr--;
+			return entry;
+		}
+		entry = cve_dle_prev(entry, list);
+	}
+
+	return NULL;
+}
+
+struct ice_pin_entry *ice_pin_cache_get(unsigned long vaddr,
+		u64 size_bytes, u32 prot, u8 dma_user, u32 *out_seq)
+{
+	struct ice_pin_entry *entry = NULL;
+	struct ice_pin_mm *pin_mm;
+	struct sg_table *sgt = NULL;
+	struct device *dev = NULL;
+	enum dma_data_direction dir = DMA_NONE;
+	u32 i;
+
+	*out_seq = 0;
+
+	if (!ice_get_pin_cache_max_entries())
+		return NULL;
+
+	__reap_stale(0);
+
+	pin_mm = __get_pin_mm();
+	if (!pin_mm)
+		return NULL;
+
+	spin_lock(&pin_cache_lock);
+
+	*out_seq = pin_mm->invalidate_seq;
+
+	entry = pin_entry_list;
+	for (i = 0; i < pin_entries_nr; i++) {
+		if (entry->pin_mm == pin_mm &&
+			entry->vaddr == vaddr &&
+			entry->size_bytes == size_bytes &&
+			entry->prot == prot)
+			break;
+		entry = cve_dle_next(entry, list);
+	}
+	if (i == pin_entries_nr)
+		entry = NULL;
+
+	if (entry) {
+		entry->refcount++;
+		/* the buffer may have been written by the CPU since the
+		 * last time the device used it
+		 */
+		if (dma_user && !entry->dma_refcount++) {
+			sgt = entry->sgt;
+			dev = entry->dev;
+			dir = entry->dir;
+		}
+		/* move to the head of the list */
+		if (entry != pin_entry_list) {
+			cve_dle_remove_from_list(pin_entry_list, list, entry);
+			cve_dle_add_to_list_before(pin_entry_list, list,
+					entry);
+			pin_entry_list = entry;
+		}
+	}
+
+	spin_unlock(&pin_cache_lock);
+
+	if (sgt)
+		dma_sync_sg_for_device(dev, sgt->sgl, sgt->nents, dir);
+
+	if (entry)
+		ice_swc_counter_atomic_inc(g_sph_swc_global,
+				ICEDRV_SWC_GLOBAL_COUNTER_PIN_CACHE_HIT);
+	else
+		ice_swc_counter_atomic_inc(g_sph_swc_global,
+				ICEDRV_SWC_GLOBAL_COUNTER_PIN_CACHE_MISS);
+
+	return entry;
+}
+
+struct ice_pin_entry *ice_pin_cache_add(unsigned long vaddr,
+		u64 size_bytes, u32 prot, struct page **pages,
+		u32 os_pages_nr, u8 dma_user, u32 seq)
+{
+	struct ice_pin_entry *entry = NULL;
+	struct ice_pin_entry *evicted;
+	struct ice_pin_mm *pin_mm;
+	u32 max_entries = ice_get_pin_cache_max_entries();
+	int ret;
+
+	if (!max_entries)
+		return NULL;
+
+	spin_lock(&pin_cache_lock);
+	pin_mm = __lookup_pin_mm(current->mm);
+	spin_unlock(&pin_cache_lock);
+	if (!pin_mm)
+		return NULL;
+
+	ret = OS_ALLOC_ZERO(sizeof(*entry), (void **)&entry);
+	if (ret != 0)
+		return NULL;
+
+	entry->pin_mm = pin_mm;
+	entry->vaddr = vaddr;
+	entry->size_bytes = size_bytes;
+	entry->prot = prot;
+	entry->pages = pages;
+	entry->os_pages_nr = os_pages_nr;
+	entry->refcount = 1;
+	entry->dma_refcount = dma_user ? 1 : 0;
+
+	spin_lock(&pin_cache_lock);
+	/* the pages may be stale if the range changed while pinning */
+	if (pin_mm->released || pin_mm->invalidate_seq != seq) {
+		spin_unlock(&pin_cache_lock);
+		OS_FREE(entry, sizeof(*entry));
+		return NULL;
+	}
+	cve_dle_add_to_list_before(pin_entry_list, list, entry);
+	pin_entry_list = entry;
+	pin_entries_nr++;
+	pin_mm->entries_nr++;
+	evicted = __pop_evictable(max_entries);
+	spin_unlock(&pin_cache_lock);
+
+	if (evicted)
+		__release_entry(evicted);
+
+	return entry;
+}
+
+void ice_pin_cache_set_sg(struct ice_pin_entry *entry,
+		struct sg_table *sgt, struct device *dev,
+		enum dma_data_direction dir)
+{
+	spin_lock(&pin_cache_lock);
+	entry->dev = dev;
+	entry->dir = dir;
+	entry->sgt = sgt;
+	spin_unlock(&pin_cache_lock);
+}
+
+void ice_pin_cache_put(struct ice_pin_entry *entry, u8 dma_user)
+{
+	struct sg_table *sgt = NULL;
+	struct device *dev = NULL;
+	enum dma_data_direction dir = DMA_NONE;
+
+	spin_lock(&pin_cache_lock);
+	entry->refcount--;
+	/* other networks may still be using the buffer */
+	if (dma_user && !--entry->dma_refcount) {
+		sgt = entry->sgt;
+		dev = entry->dev;
+		dir = entry->dir;
+	}
+	spin_unlock(&pin_cache_lock);
+
+	/* references taken with dma_user are serialized by the driver lock,
+	 * so the device is done with the buffer
+	 */
+	if (sgt)
+		dma_sync_sg_for_cpu(dev, sgt->sgl, sgt->nents, dir);
+
+	/* also releases the entry itself if it was invalidated while used */
+	__reap_stale(0);
+}
+
+void ice_pin_cache_fini(void)
+{
+	struct ice_pin_entry *entry;
+
+	for (;;) {
+		spin_lock(&pin_cache_lock);
+		entry = __pop_evictable(0);
+		spin_unlock(&pin_cache_lock);
+
+		if (!entry)
+			break;
+		__release_entry(entry);
+	}
+
+	__reap_stale(1);
+
+	if (pin_entry_list || pin_stale_list)
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+			"pinned buffers are still in use\n");
+}
+
+#else /* CONFIG_MMU_NOTIFIER */
+
+struct ice_pin_entry *ice_pin_cache_get(unsigned long vaddr,
+		u64 size_bytes, u32 prot, u8 dma_user, u32 *out_seq)
+{
+	*out_seq = 0;
+	return NULL;
+}
+
+struct ice_pin_entry *ice_pin_cache_add(unsigned long vaddr,
+		u64 size_bytes, u32 prot, struct page **pages,
+		u32 os_pages_nr, u8 dma_user, u32 seq)
+{
+	return NULL;
+}
+
+void ice_pin_cache_set_sg(struct ice_pin_entry *entry,
+		struct sg_table *sgt, struct device *dev,
+		enum dma_data_direction dir)
+{
+}
+
+void ice_pin_cache_put(struct ice_pin_entry *entry, u8 dma_user)
+{
+}
+
+void ice_pin_cache_fini(void)
+{
+}
+
+#endif /* CONFIG_MMU_NOTIFIER */
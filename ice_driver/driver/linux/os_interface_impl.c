@@ -33,6 +33,7 @@
 #include <linux/slab.h>
 #include <linux/miscdevice.h>
 #include <linux/debugfs.h>
+#include <linux/poll.h>
 #include <asm/processor.h>
 #include "os_interface.h"
 #include "os_interface_impl.h"
@@ -52,6 +53,7 @@
 #include "ice_debug.h"
 #include "project_device_interface.h"
 #include "cve_firmware.h"
+#include "osmm_interface.h"
 #include "sph_iccp.h"
 #include "sph_ice_error_status.h"
 
@@ -120,6 +122,8 @@ static int cve_open_misc(struct inode *inode, struct file *file);
 static int cve_close_misc(struct inode *inode, struct file *file);
 static long cve_ioctl_misc(
 		struct file *file, unsigned int cmd, unsigned long arg);
+static int cve_mmap_misc(struct file *file, struct vm_area_struct *vma);
+static __poll_t cve_poll_misc(struct file *file, poll_table *wait);
 
 static int cve_dump_open(struct inode *inode, struct file *filp);
 static ssize_t cve_dump_read(struct file *fp, char __user *user_buffer,
@@ -150,6 +154,11 @@ static u32 initial_iccp_config[3] = {INITIAL_CDYN_VAL, RESET_CDYN_VAL,
 							BLOCKED_CDYN_VAL};
 static int ice_power_off_delay_ms = 1000;
 static int enable_ice_drv_memleak;
+static int enable_inf_cb_copy;
+static int enable_large_page_promotion = 1;
+static int pin_cache_max_entries = 256;
+static int enable_adaptive_power_off = 1;
+static int enable_sticky_resource = 1;
 
 module_param(enable_llc, int, 0);
 MODULE_PARM_DESC(enable_llc, "Enable LLC usage in driver");
@@ -175,6 +184,21 @@ MODULE_PARM_DESC(ice_fw_select, "Permit the use of rtl debug FW (0=rtl/release F
 module_param(ice_power_off_delay_ms, int, 0);
 MODULE_PARM_DESC(ice_power_off_delay_ms, "Delay in ms to power off ICEs after WL completion(value less than 0 signifies no power off)");
 
+module_param(enable_inf_cb_copy, int, 0);
+MODULE_PARM_DESC(enable_inf_cb_copy, "Keep per Infer copies of CBs with Infer patch points so that they are not patched at dispatch. Default 0 i.e disabled");
+
+module_param(enable_large_page_promotion, int, 0);
+MODULE_PARM_DESC(enable_large_page_promotion, "Map physically contiguous buffers allowed above 4GB with 16MB/32MB ICE pages. Default 1 i.e enabled");
+
+module_param(pin_cache_max_entries, int, 0);
+MODULE_PARM_DESC(pin_cache_max_entries, "Max number of user buffers kept pinned and DMA mapped after their allocation is destroyed. 0 disables the cache. Default 256");
+
+module_param(enable_adaptive_power_off, int, 0);
+MODULE_PARM_DESC(enable_adaptive_power_off, "Choose the power off delay of each ICE from its idle history, spending no more powered idle time on past idle periods than ice_power_off_delay_ms would have. Default 1 i.e enabled");
+
+module_param(enable_sticky_resource, int, 0);
+MODULE_PARM_DESC(enable_sticky_resource, "Keep the resources returned by a non reserved network bound to it until another network needs them, so that its next inference does not capture them again. Default 1 i.e enabled");
+
 module_param(block_mmu, int, 0);
 MODULE_PARM_DESC(block_mmu, "Enables MMU Block/Unblock for each Doorbell");
 
@@ -215,6 +239,8 @@ static const struct file_operations m_cve_misc_fops = {
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = cve_ioctl_misc,
 #endif
+	.mmap = cve_mmap_misc,
+	.poll = cve_poll_misc,
 };
 
 static struct miscdevice cve_misc_device = {
@@ -1156,6 +1182,23 @@ void cve_os_vunmap_dma_handle(void *vaddr)
 	vunmap(vaddr);
 }
 
+int ice_os_alloc_user_shared(u32 size_bytes, void **out_kva)
+{
+	void *kva;
+
+	kva = vmalloc_user(PAGE_ALIGN(size_bytes));
+	if (!kva)
+		return -ENOMEM;
+
+	*out_kva = kva;
+	return 0;
+}
+
+void ice_os_free_user_shared(void *kva, u32 size_bytes)
+{
+	vfree(kva);
+}
+
 int cve_os_dma_copy_from_buffer(struct cve_dma_handle *dma_handle,
 		void *buffer,
 		u32 size_bytes)
@@ -1939,6 +1982,67 @@ static int cve_close_misc(struct inode *inode, struct file *file)
 	return retval;
 }
 
+/* Maps the completion ring configured by ICE_IOCTL_COMPLETION_RING */
+static int cve_mmap_misc(struct file *file, struct vm_area_struct *vma)
+{
+	int retval;
+	struct cve_context_process *context_process = NULL;
+	cve_context_process_id_t context_pid =
+				(cve_context_process_id_t)(uintptr_t)file;
+	unsigned long sz = vma->vm_end - vma->vm_start;
+
+	retval = cve_os_lock(&g_cve_driver_biglock, CVE_INTERRUPTIBLE);
+	if (retval != 0)
+		return -ERESTARTSYS;
+
+	retval = cve_context_process_get(context_pid, &context_process);
+	if (retval != 0)
+		goto out;
+
+	if (!context_process->cring || vma->vm_pgoff ||
+		sz > PAGE_ALIGN(context_process->cring_size)) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"Invalid completion ring mmap. Size=%lu Offset=%lu\n",
+				sz, vma->vm_pgoff);
+		retval = -EINVAL;
+		goto out;
+	}
+
+	retval = remap_vmalloc_range(vma, context_process->cring, 0);
+	if (retval)
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+				"remap_vmalloc_range failed %d\n", retval);
+
+out:
+	cve_os_unlock(&g_cve_driver_biglock);
+	return retval;
+}
+
+/* Fallback for completion ring users when idle (poll/epoll) */
+static __poll_t cve_poll_misc(struct file *file, poll_table *wait)
+{
+	__poll_t mask = 0;
+	struct cve_context_process *context_process = NULL;
+	cve_context_process_id_t context_pid =
+				(cve_context_process_id_t)(uintptr_t)file;
+
+	cve_os_lock(&g_cve_driver_biglock, CVE_NON_INTERRUPTIBLE);
+
+	if (cve_context_process_get(context_pid, &context_process) != 0) {
+		mask = EPOLLERR;
+		goto out;
+	}
+
+	poll_wait(file, &context_process->events_wait_queue, wait);
+
+	if (cve_context_process_has_events(context_process))
+		mask = EPOLLIN | EPOLLRDNORM;
+
+out:
+	cve_os_unlock(&g_cve_driver_biglock);
+	return mask;
+}
+
 static long cve_ioctl_misc(
 		struct file *file, unsigned int cmd, unsigned long arg)
 {
@@ -2038,6 +2142,17 @@ static long cve_ioctl_misc(
 					&p->data);
 			break;
 		}
+	case ICE_IOCTL_EXECUTE_INFER_BATCH:
+		{
+			struct ice_execute_infer_batch *p =
+						&kparam.execute_infer_batch;
+
+			cve_os_log(CVE_LOGLEVEL_DEBUG,
+					"ICE_IOCTL_EXECUTE_INFER_BATCH\n");
+			retval = cve_ds_handle_execute_infer_batch(context_pid,
+					p);
+			break;
+		}
 	case CVE_IOCTL_DESTROY_INFER:
 		{
 			struct cve_destroy_infer *p = &kparam.destroy_infer;
@@ -2099,6 +2214,32 @@ static long cve_ioctl_misc(
 					p);
 		}
 		break;
+	case ICE_IOCTL_WAIT_FOR_EVENT_BATCH:
+		{
+			struct ice_wait_event_batch *p =
+						&kparam.wait_event_batch;
+
+			cve_os_log(CVE_LOGLEVEL_DEBUG,
+					"ICE_IOCTL_WAIT_FOR_EVENT_BATCH\n");
+			retval = cve_ds_wait_for_event_batch(
+					context_pid,
+					p);
+		}
+		break;
+	case ICE_IOCTL_COMPLETION_RING:
+		{
+			struct ice_completion_ring_params *p =
+						&kparam.completion_ring;
+
+			cve_os_log(CVE_LOGLEVEL_DEBUG,
+					"ICE_IOCTL_COMPLETION_RING\n");
+			retval = cve_context_process_config_cring(
+					context_pid,
+					p);
+			/* Address is meaningful only in simulation mode */
+			p->ring_addr = 0;
+		}
+		break;
 	case CVE_IOCTL_GET_VERSION:
 		{
 			struct cve_get_version_params *p = &kparam.get_version;
@@ -2176,6 +2317,30 @@ static long cve_ioctl_misc(
 					p->networkid);
 		}
 		break;
+	case ICE_IOCTL_PREDICT_RUNTIME:
+		{
+			struct ice_predict_runtime_params *p =
+							&kparam.predict_runtime;
+
+			cve_os_log(CVE_LOGLEVEL_DEBUG,
+					    "ICE_IOCTL_PREDICT_RUNTIME\n");
+			retval = ice_ds_predict_runtime(
+					context_pid,
+					p);
+		}
+		break;
+	case ICE_IOCTL_PMON_SAMPLES:
+		{
+			struct ice_pmon_samples_params *p =
+							&kparam.pmon_samples;
+
+			cve_os_log(CVE_LOGLEVEL_DEBUG,
+					    "ICE_IOCTL_PMON_SAMPLES\n");
+			retval = ice_ds_pmon_samples(
+					context_pid,
+					p);
+		}
+		break;
 	default:
 		retval = -ENOENT;
 		goto out;
@@ -2234,6 +2399,12 @@ static int __init cve_init(void)
 	param.ice_power_off_delay_ms = ice_power_off_delay_ms;
 	param.ice_sch_preemption = ice_sch_preemption;
 	param.enable_mmu_pmon = enable_mmu_pmon;
+	param.enable_inf_cb_copy = enable_inf_cb_copy;
+	param.enable_large_page_promotion = enable_large_page_promotion;
+	param.pin_cache_max_entries = (pin_cache_max_entries < 0) ?
+		0 : pin_cache_max_entries;
+	param.enable_adaptive_power_off = enable_adaptive_power_off;
+	param.enable_sticky_resource = enable_sticky_resource;
 	param.initial_iccp_config[0] = initial_iccp_config[0];
 	param.initial_iccp_config[1] = initial_iccp_config[1];
 	param.initial_iccp_config[2] = initial_iccp_config[2];
@@ -2361,6 +2532,8 @@ static void __exit cve_exit(void)
 	/* unregister misc device */
 	misc_deregister(&cve_misc_device);
 
+	ice_pin_cache_fini();
+
 	ice_swc_fini();
 
 	ice_flow_debug_term();
@@ -34,6 +34,8 @@
 #include "cve_device_group.h"
 #include "cve_linux_internal.h"
 #include "ice_debug.h"
+#include "ice_sw_counters.h"
+#include "ice_dma_pool.h"
 
 /* DATA TYPES */
 
@@ -260,8 +262,20 @@ void cve_mm_invalidate_tlb(os_domain_handle hdom,
 	 * driver settings requires tlb invalidation.
 	 * do tlb invalidation and clear the pages added flag.
 	 */
-	if (cve_osmm_is_need_tlb_invalidation(hdom))
-		ice_di_tlb_invalidate_full(cve_dev);
+	if (!cve_osmm_is_need_tlb_invalidation(hdom))
+		return;
+
+	/* the TLB only caches the page table programmed in the MMU. Any
+	 * other table is flushed when it gets programmed, so the changes
+	 * need no invalidation now.
+	 */
+	if (cve_dev->pd_base_addr != cve_osmm_get_domain_pd_base_addr(hdom)) {
+		ice_swc_counter_inc(cve_dev->hswc,
+				ICEDRV_SWC_DEVICE_COUNTER_TLB_INV_SKIPPED);
+		return;
+	}
+
+	ice_di_tlb_invalidate_full(cve_dev);
 }
 
 void cve_mm_reset_page_table_flags(os_domain_handle hdom)
@@ -571,6 +585,30 @@ void cve_mm_destroy_infer_buffer(
 	OS_FREE(inf_alloc, sizeof(*inf_alloc));
 }
 
+static u32 __surface_prot(struct cve_surface_descriptor *k_surface)
+{
+	u32 prot;
+
+	prot = (k_surface->direction & CVE_SURFACE_DIRECTION_IN) ?
+			CVE_MM_PROT_READ : 0;
+	prot |= (k_surface->direction & CVE_SURFACE_DIRECTION_OUT) ?
+			CVE_MM_PROT_WRITE : 0;
+
+	return prot;
+}
+
+int cve_mm_prefetch_buffer(struct cve_surface_descriptor *k_surface)
+{
+	/* only plain user memory is pinned by the driver */
+	if (k_surface->fd || !k_surface->base_address)
+		return 0;
+
+	return cve_osmm_prefetch_user_buffer(
+			(void *)(uintptr_t)k_surface->base_address,
+			k_surface->size_bytes,
+			__surface_prot(k_surface));
+}
+
 int cve_mm_create_buffer(
 	os_domain_handle *hdom,
 	u32 domain_array_size,
@@ -598,10 +636,7 @@ int cve_mm_create_buffer(
 	ASSERT((k_surface->direction & CVE_SURFACE_DIRECTION_IN) ||
 			(k_surface->direction & CVE_SURFACE_DIRECTION_OUT));
 
-	prot = (k_surface->direction & CVE_SURFACE_DIRECTION_IN) ?
-			CVE_MM_PROT_READ : 0;
-	prot |= (k_surface->direction & CVE_SURFACE_DIRECTION_OUT) ?
-			CVE_MM_PROT_WRITE : 0;
+	prot = __surface_prot(k_surface);
 
 	/* if using buffer sharing, set the allocation flag type
 	 * to shared and set the propriatery print
@@ -1009,18 +1044,42 @@ out:
 
 int ice_mm_patch_inf_pp_arr(struct ice_infer *inf)
 {
-	u32 i;
+	u32 i, patched = 0;
 	int ret = 0;
+	struct ice_network *ntw = inf->ntw;
+	struct ice_infer *prev_inf = ntw->last_patched_inf;
 	struct ice_pp_value *pp_value;
 
 	if (inf->inf_pp_arr == NULL)
 		goto out;
 
-	for (i = 0; i < inf->ntw->ntw_surf_pp_count; i++) {
+	/* CBs still hold the values written for this Infer last time */
+	if (prev_inf == inf) {
+		cve_os_log(CVE_LOGLEVEL_DEBUG,
+			"Skip patching, CBs already patched for InfID=0x%llx\n",
+			inf->infer_id);
+		goto out;
+	}
+
+	/* Invalid until all patch points are written */
+	ntw->last_patched_inf = NULL;
+
+	for (i = 0; i < ntw->ntw_surf_pp_count; i++) {
 
 		/* IAVA and Value of PP is stored in this object */
 		pp_value = &inf->inf_pp_arr[i];
 
+		/* Already written to this Infer's copy of the CB */
+		if (pp_value->in_cb_copy)
+			continue;
+
+		/* Same location was patched by previous Infer, rewrite it
+		 * only if the buffer IOVA differs.
+		 */
+		if (prev_inf && !prev_inf->inf_pp_arr[i].in_cb_copy &&
+			prev_inf->inf_pp_arr[i].pp_value == pp_value->pp_value)
+			continue;
+
 		ret = __patch_surface(pp_value->ntw_buf,
 				pp_value->pp_address, pp_value->pp_value);
 		if (ret < 0) {
@@ -1028,8 +1087,15 @@ int ice_mm_patch_inf_pp_arr(struct ice_infer *inf)
 				"ERROR:%d __patch_surface() failed\n", ret);
 			goto out;
 		}
+		patched++;
 	}
 
+	ntw->last_patched_inf = inf;
+
+	cve_os_log(CVE_LOGLEVEL_DEBUG,
+		"InfID=0x%llx Patched %u of %u patch points\n",
+		inf->infer_id, patched, ntw->ntw_surf_pp_count);
+
 out:
 	return ret;
 }
@@ -1114,6 +1180,176 @@ out:
 	return ret;
 }
 
+static void __destroy_inf_cb_copy(struct ice_inf_cb_copy *cb_copy)
+{
+	struct cve_device *dev = ice_get_first_dev();
+
+	cve_mm_reclaim_allocation(cb_copy->alloc);
+	ice_dma_pool_free(dev, cb_copy->size_bytes, cb_copy->vaddr,
+			&cb_copy->dma_handle);
+	OS_FREE(cb_copy, sizeof(*cb_copy));
+}
+
+static int __create_inf_cb_copy(struct ice_infer *inf,
+		struct cve_ntw_buffer *ntw_buf,
+		struct ice_inf_cb_copy **out_cb_copy)
+{
+	int ret = 0;
+	u32 i, domain_array_size =
+		g_cve_dev_group_list->dev_info.active_device_nr;
+	struct cve_device *dev = ice_get_first_dev();
+	struct allocation_desc *cb_alloc_desc, *alloc = NULL;
+	struct cve_dma_handle *dma_handle[MAX_CVE_DEVICES_NR];
+	struct cve_surface_descriptor surf;
+	union allocation_address alloc_addr;
+	struct ice_inf_cb_copy *cb_copy = NULL;
+
+	cb_alloc_desc = (struct allocation_desc *)ntw_buf->ntw_buf_alloc;
+
+	ret = OS_ALLOC_ZERO(sizeof(*cb_copy), (void **)&cb_copy);
+	if (ret < 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+			"os_alloc_zero failed %d\n", ret);
+		goto out;
+	}
+
+	cb_copy->ntw_buf = ntw_buf;
+	cb_copy->size_bytes = (u32)cb_alloc_desc->size_bytes;
+
+	ret = ice_dma_pool_alloc(dev, cb_copy->size_bytes,
+			&cb_copy->vaddr, &cb_copy->dma_handle);
+	if (ret < 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+			"ice_dma_pool_alloc failed %d\n", ret);
+		goto free_cb_copy;
+	}
+
+	/* Only Infer and counter patch points change after CreateNetwork */
+	if (cb_alloc_desc->fd > 0) {
+		memcpy(cb_copy->vaddr, cb_alloc_desc->vaddr,
+			cb_copy->size_bytes);
+	} else {
+		ret = cve_os_read_user_memory(cb_alloc_desc->vaddr,
+				cb_copy->size_bytes, cb_copy->vaddr);
+		if (ret < 0) {
+			cve_os_log(CVE_LOGLEVEL_ERROR,
+				"os_read_user_memory failed %d\n", ret);
+			goto free_dma;
+		}
+	}
+
+	/* Same physical copy is mapped in the domain of every ICE */
+	for (i = 0; i < domain_array_size; i++)
+		dma_handle[i] = &cb_copy->dma_handle;
+
+	memset(&surf, 0, sizeof(surf));
+	surf.llc_policy = cb_alloc_desc->iova_desc.llc_policy;
+	alloc_addr.vaddr = cb_copy->vaddr;
+
+	ret = create_new_allocation((os_domain_handle *)inf->inf_hdom,
+			dma_handle,
+			domain_array_size,
+			alloc_addr,
+			cb_copy->size_bytes,
+			CVE_SURFACE_DIRECTION_INOUT,
+			CVE_MM_PROT_READ | CVE_MM_PROT_WRITE,
+			CVE_INVALID_VIRTUAL_ADDR,
+			OSMM_KERNEL_MEMORY,
+			&surf,
+			&alloc);
+	if (ret < 0) {
+		cve_os_log(CVE_LOGLEVEL_ERROR,
+			"create_new_allocation failed %d\n", ret);
+		goto free_dma;
+	}
+
+	cb_copy->alloc = alloc;
+	cb_copy->orig_iova = cve_osmm_alloc_get_iova(cb_alloc_desc->halloc);
+	cb_copy->copy_iova = cve_osmm_alloc_get_iova(alloc->halloc);
+
+	cve_os_log(CVE_LOGLEVEL_DEBUG,
+		"InfID=0x%llx BufferID=0x%llx CB copied. ICEVA=0x%llx->0x%llx Size=0x%x\n",
+		inf->infer_id, ntw_buf->buffer_id, cb_copy->orig_iova,
+		cb_copy->copy_iova, cb_copy->size_bytes);
+
+	*out_cb_copy = cb_copy;
+	goto out;
+
+free_dma:
+	ice_dma_pool_free(dev, cb_copy->size_bytes, cb_copy->vaddr,
+			&cb_copy->dma_handle);
+free_cb_copy:
+	OS_FREE(cb_copy, sizeof(*cb_copy));
+out:
+	return ret;
+}
+
+int ice_mm_create_inf_cb_copies(struct ice_infer *inf)
+{
+	u32 i;
+	int ret = 0;
+	u8 *dst;
+	struct ice_network *ntw = inf->ntw;
+	struct ice_pp_value *pp_value;
+	struct ice_inf_cb_copy *cb_copy;
+	struct allocation_desc *cb_alloc_desc;
+
+	for (i = 0; i < ntw->ntw_surf_pp_count; i++) {
+
+		pp_value = &inf->inf_pp_arr[i];
+
+		/* Counter PPs are patched in place at dispatch */
+		if (pp_value->ntw_buf->has_cntr_pp)
+			continue;
+
+		cb_copy = cve_dle_lookup(inf->cb_copy_list, list, ntw_buf,
+				pp_value->ntw_buf);
+		if (!cb_copy) {
+			ret = __create_inf_cb_copy(inf, pp_value->ntw_buf,
+					&cb_copy);
+			if (ret < 0)
+				goto destroy_copies;
+
+			cve_dle_add_to_list_before(inf->cb_copy_list, list,
+					cb_copy);
+		}
+
+		/* Same offset in the copy as in the network CB */
+		cb_alloc_desc = (struct allocation_desc *)
+			pp_value->ntw_buf->ntw_buf_alloc;
+		dst = (u8 *)cb_copy->vaddr +
+			((u8 *)pp_value->pp_address -
+			 (u8 *)cb_alloc_desc->vaddr);
+		*(u64 *)dst = pp_value->pp_value;
+		pp_value->in_cb_copy = 1;
+	}
+
+	goto out;
+
+destroy_copies:
+	ice_mm_destroy_inf_cb_copies(inf);
+out:
+	return ret;
+}
+
+void ice_mm_destroy_inf_cb_copies(struct ice_infer *inf)
+{
+	u32 i;
+	struct ice_inf_cb_copy *cb_copy;
+
+	while (inf->cb_copy_list) {
+		cb_copy = inf->cb_copy_list;
+		cve_dle_remove_from_list(inf->cb_copy_list, list, cb_copy);
+		__destroy_inf_cb_copy(cb_copy);
+	}
+
+	if (!inf->inf_pp_arr)
+		return;
+
+	for (i = 0; i < inf->ntw->ntw_surf_pp_count; i++)
+		inf->inf_pp_arr[i].in_cb_copy = 0;
+}
+
 static int __process_surf_pp(struct cve_patch_point_descriptor *cur_pp_desc,
 		struct cve_ntw_buffer *buf_list,
 		struct job_descriptor *job)
@@ -1270,6 +1506,8 @@ int ice_mm_process_patch_point(struct cve_ntw_buffer *buf_list,
 			 */
 			jobgroup->cntr_bitmap |=
 				(1 << cur_pp_desc->cntr_id);
+			buf_list[cur_pp_desc->patching_buf_index].has_cntr_pp =
+				1;
 			break;
 		case ICE_PP_TYPE_SURFACE:
 			ret = __process_surf_pp(cur_pp_desc, buf_list, job);
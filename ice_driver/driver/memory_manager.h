@@ -78,6 +78,15 @@ void cve_mm_destroy_infer_buffer(
 		u64 inf_id,
 		struct cve_inf_buffer *inf_buf);
 
+/*
+ * pin a user buffer ahead of cve_mm_create_buffer(), without the driver
+ * lock. Other buffer types are left alone.
+ * inputs :
+ *	k_surface - the user surface descriptor (in kernel space)
+ * returns: 0 on success, a negative error value on error
+ */
+int cve_mm_prefetch_buffer(struct cve_surface_descriptor *k_surface);
+
 /*
  * create a buffer based on the given descriptor
  * inputs :
@@ -306,5 +315,18 @@ void ice_mm_get_domain_by_cve_idx(
 int ice_mm_process_inf_pp_arr(struct ice_infer *inf);
 int ice_mm_patch_inf_pp_arr(struct ice_infer *inf);
 
+/*
+ * Create a private copy of every CB which holds Infer patch points of the
+ * given Infer, map it in all ICE domains of the network and write the
+ * Infer's patch values to it. CBs with counter patch points are excluded.
+ * inputs :
+ *	inf - Infer whose inf_pp_arr is already processed
+ * returns: 0 on success, a negative error code on failure
+ */
+int ice_mm_create_inf_cb_copies(struct ice_infer *inf);
+
+/* unmap and free all CB copies of the given Infer */
+void ice_mm_destroy_inf_cb_copies(struct ice_infer *inf);
+
 #endif /* _MEMORY_MANAMGER_H_ */
 
@@ -820,6 +820,21 @@ void *cve_os_vmap_dma_handle(struct cve_dma_handle *dma_handle);
  */
 void cve_os_vunmap_dma_handle(void *vaddr);
 
+/**
+ * Allocates zeroed memory that can later be mapped to user space
+ * (mmap on the driver fd)
+ * @param size_bytes
+ * @param out_kva - kernel virtual address of the allocation
+ *
+ * returns 0 on success, negative error code otherwise
+ */
+int ice_os_alloc_user_shared(u32 size_bytes, void **out_kva);
+
+/**
+ * Frees memory allocated by ice_os_alloc_user_shared
+ */
+void ice_os_free_user_shared(void *kva, u32 size_bytes);
+
 uint32_t get_process_pid(void);
 
 u32 ice_os_get_user_intst(int dev_id);
@@ -180,6 +180,15 @@ u32 cve_osmm_is_need_tlb_invalidation(os_domain_handle hdomain);
  */
 void cve_osmm_reset_all_pt_flags(os_domain_handle hdomain);
 
+/*
+ * Pin a user buffer into the registration cache ahead of its mapping, so
+ * that the mapping does not have to pin it. Does not need the driver lock.
+ * inputs : vaddr, size_bytes - the user buffer
+ *          prot - the permissions it will be mapped with
+ * returns: 0 on success, a negative error code on failure
+ */
+int cve_osmm_prefetch_user_buffer(void *vaddr, u64 size_bytes, u32 prot);
+
 /*
  * Print the user buffer.
  * inputs:
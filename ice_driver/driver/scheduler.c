@@ -28,11 +28,20 @@
 #endif
 #include "ice_debug_event.h"
 
+/* Time a pending reservation may wait for free resources while later
+ * Inferences keep borrowing them. Beyond it, Inferences which need to
+ * borrow are held back until the reservation is admitted.
+ */
+#define ICE_SCH_RES_MAX_WAIT_US 2000
+
 static void __del_rr_from_queue(struct execution_node *node);
 
 /* Each scheduler queue is associated with Priority */
 static struct execution_node *sch_queue[EXE_INF_PRIORITY_MAX];
 
+/* Pending reservations, in arrival order */
+static struct execution_node *sch_res_queue;
+
 /* return 1 iff job is marked as finished */
 static inline int is_jobgroup_finished(struct jobgroup_descriptor *jobgroup)
 {
@@ -42,7 +51,9 @@ static inline int is_jobgroup_finished(struct jobgroup_descriptor *jobgroup)
 enum sch_status {
 	SCH_STATUS_DONE,
 	SCH_STATUS_WAIT,
-	SCH_STATUS_DISCARD
+	SCH_STATUS_DISCARD,
+	/* RR node was served, queues must be walked again */
+	SCH_STATUS_RESCAN
 };
 
 static void __discard_inference(struct ice_infer *inf)
@@ -247,11 +258,140 @@ out:
 	return status;
 }
 
+/* Run the oldest Inference of a Ntw which just got its reservation */
+static void __schedule_ntw_head(struct ice_network *ntw)
+{
+	struct execution_node *node = ntw->sch_queue[EXE_INF_PRIORITY_0];
+
+	if (!node)
+		node = ntw->sch_queue[EXE_INF_PRIORITY_1];
+
+	if (node && node->ntype == NODE_TYPE_INFERENCE)
+		__schedule_node(node);
+}
+
+/* Serve pending reservations in arrival order, until one must wait */
+static void __admit_reservations(void)
+{
+	enum sch_status status;
+	struct execution_node *node;
+	struct ice_network *ntw;
+
+	while (sch_res_queue) {
+
+		node = sch_res_queue;
+		ntw = node->ntw;
+
+		status = __schedule_rr_node(node);
+		if (status == SCH_STATUS_WAIT)
+			break;
+
+		if (status == SCH_STATUS_DONE)
+			__schedule_ntw_head(ntw);
+	}
+}
+
+/* Is the oldest pending reservation waiting beyond its bound */
+static bool __is_reservation_fenced(void)
+{
+	struct timespec curr_ts;
+
+	if (!sch_res_queue)
+		return false;
+
+	getnstimeofday(&curr_ts);
+
+	return (ice_get_usec_timediff(&curr_ts, &sch_res_queue->queued_ts) >
+		ICE_SCH_RES_MAX_WAIT_US);
+}
+
+/* Under a reservation fence only the nodes that do not compete with the
+ * reservation for free resources are served: Inferences of Ntws which
+ * already own their resources, and Release nodes not ordered behind an
+ * Inference of their own Ntw.
+ */
+static bool __is_held_back(struct execution_node *node, bool fence)
+{
+	struct ice_network *ntw;
+
+	if (!fence)
+		return false;
+
+	if (node->ntype == NODE_TYPE_INFERENCE) {
+		ntw = node->inf->ntw;
+		return (!ntw->res_resource && !ntw->ntw_running);
+	}
+
+	ntw = node->ntw;
+	return (ntw->ntw_running ||
+		ntw->sch_queue[EXE_INF_PRIORITY_0] != node ||
+		ntw->sch_queue[EXE_INF_PRIORITY_1] != node);
+}
+
+static struct execution_node *__first_runnable(
+	enum ice_execute_infer_priority pr, bool fence)
+{
+	struct execution_node *head = sch_queue[pr];
+	struct execution_node *node = head;
+
+	if (!head)
+		return NULL;
+
+	do {
+		if (!__is_held_back(node, fence))
+			return node;
+
+		node = cve_dle_next(node, sch_list[pr]);
+	} while (node != head);
+
+	return NULL;
+}
+
+/* Serve the queue of given priority in order. Returns SCH_STATUS_WAIT if
+ * a node must wait for resources, SCH_STATUS_RESCAN if a Release node was
+ * served, else SCH_STATUS_DONE.
+ */
+static enum sch_status __schedule_queue(enum ice_execute_infer_priority pr,
+	bool fence)
+{
+	enum sch_status status;
+	struct execution_node *node;
+
+	while ((node = __first_runnable(pr, fence))) {
+
+		if (node->ntype == NODE_TYPE_INFERENCE) {
+
+			status = __schedule_node(node);
+			if (status == SCH_STATUS_WAIT) {
+				cve_os_log(CVE_LOGLEVEL_DEBUG, "Waiting\n");
+				return SCH_STATUS_WAIT;
+			}
+			continue;
+		}
+
+		/* Without a fence the Release node is served only once it
+		 * heads both queues
+		 */
+		if (!fence && (sch_queue[EXE_INF_PRIORITY_0] != node ||
+			sch_queue[EXE_INF_PRIORITY_1] != node))
+			return SCH_STATUS_DONE;
+
+		status = __schedule_rr_node(node);
+		if (status == SCH_STATUS_WAIT)
+			return SCH_STATUS_WAIT;
+
+		return SCH_STATUS_RESCAN;
+	}
+
+	return SCH_STATUS_DONE;
+}
+
 void ice_sch_engine(struct ice_network *ntw)
 {
 	enum sch_status status;
-	struct execution_node *head, *pr0_head, *pr1_head;
+	struct execution_node *pr0_head, *pr1_head;
 	bool pr0_head_rdy = false, pr1_head_rdy = false;
+	bool fence;
 
 	if (ntw) {
 		/* If any request pending in this Ntw then run it, else
@@ -295,23 +435,12 @@ void ice_sch_engine(struct ice_network *ntw)
 
 		if (pr0_head_rdy && pr1_head_rdy) {
 
+			/* Reservations wait in their own queue */
 			ASSERT(pr0_head == pr1_head);
-			if (ntw->res_resource) {
-				ASSERT(pr0_head->ntype ==
-						NODE_TYPE_RELEASE);
-			} else {
-				ASSERT(pr0_head->ntype ==
-						NODE_TYPE_RESERVE);
-			}
-			status = __schedule_rr_node(pr0_head);
-			if (status == SCH_STATUS_DONE) {
+			ASSERT(pr0_head->ntype == NODE_TYPE_RELEASE);
 
-				if (pr0_head->ntype == NODE_TYPE_RESERVE)
-					ice_sch_engine(pr0_head->ntw);
-				else
-					ice_sch_engine(NULL);
-
-			} else if (status == SCH_STATUS_DISCARD)
+			status = __schedule_rr_node(pr0_head);
+			if (status != SCH_STATUS_WAIT)
 				ice_sch_engine(NULL);
 
 			return;
@@ -325,55 +454,21 @@ void ice_sch_engine(struct ice_network *ntw)
 
 scheduler_beginning:
 
-	while (sch_queue[EXE_INF_PRIORITY_0]) {
-
-		if (sch_queue[EXE_INF_PRIORITY_0]->ntype != NODE_TYPE_INFERENCE)
-			break;
-
-		status = __schedule_node(sch_queue[EXE_INF_PRIORITY_0]);
-		if (status == SCH_STATUS_WAIT) {
-			cve_os_log(CVE_LOGLEVEL_DEBUG, "Waiting\n");
-			goto out;
-		}
-	};
-
-	while (sch_queue[EXE_INF_PRIORITY_1]) {
-
-		if (sch_queue[EXE_INF_PRIORITY_1]->ntype != NODE_TYPE_INFERENCE)
-			break;
-
-		status = __schedule_node(sch_queue[EXE_INF_PRIORITY_1]);
-		if (status == SCH_STATUS_WAIT) {
-			cve_os_log(CVE_LOGLEVEL_DEBUG, "Waiting\n");
-			goto out;
-		}
-	};
-
-	if (!sch_queue[EXE_INF_PRIORITY_0] && !sch_queue[EXE_INF_PRIORITY_1])
-		return;
-
-	ASSERT(sch_queue[EXE_INF_PRIORITY_0]);
-	ASSERT(sch_queue[EXE_INF_PRIORITY_0] == sch_queue[EXE_INF_PRIORITY_1]);
-	ASSERT(sch_queue[EXE_INF_PRIORITY_0]->ntype != NODE_TYPE_INFERENCE);
-
-	head = sch_queue[EXE_INF_PRIORITY_0];
-
-	status = __schedule_rr_node(head);
-	if (status == SCH_STATUS_DONE) {
-
-		if (head->ntype == NODE_TYPE_RESERVE)
-			ice_sch_engine(head->ntw);
-		else
-			ice_sch_engine(NULL);
+	__admit_reservations();
+	fence = __is_reservation_fenced();
+	if (fence)
+		cve_os_log(CVE_LOGLEVEL_DEBUG,
+			"Holding back Inferences for pending reservation\n");
 
-	} else if (status == SCH_STATUS_DISCARD)
-		ice_sch_engine(NULL);
+	status = __schedule_queue(EXE_INF_PRIORITY_0, fence);
+	if (status == SCH_STATUS_DONE)
+		status = __schedule_queue(EXE_INF_PRIORITY_1, fence);
 
-out:
-	return;
+	if (status == SCH_STATUS_RESCAN)
+		goto scheduler_beginning;
 }
 
-void ice_sch_add_inf_to_queue(struct ice_infer *inf)
+void ice_sch_enqueue_inf(struct ice_infer *inf)
 {
 	struct ice_network *ntw = inf->ntw;
 
@@ -389,14 +484,22 @@ void ice_sch_add_inf_to_queue(struct ice_infer *inf)
 		ntw_queue[inf->inf_pr], &inf->inf_sch_node);
 
 	inf->ntw->sch_queued_inf_count++;
+}
 
+void ice_sch_trigger(void)
+{
 	ice_sch_engine(NULL);
 
 #ifdef RING3_VALIDATION
 	cve_os_log(CVE_LOGLEVEL_DEBUG, "Execute ICEs\n");
 	coral_trigger_simulation();
 #endif
+}
 
+void ice_sch_add_inf_to_queue(struct ice_infer *inf)
+{
+	ice_sch_enqueue_inf(inf);
+	ice_sch_trigger();
 }
 
 void ice_sch_del_inf_from_queue(struct ice_infer *inf)
@@ -418,16 +521,29 @@ void ice_sch_del_inf_from_queue(struct ice_infer *inf)
 
 void ice_sch_add_rr_to_queue(struct execution_node *node)
 {
+	ASSERT(!node->is_queued);
+
 	node->ready_to_run = false;
+	node->is_queued = true;
 
-	cve_dle_add_to_list_before(sch_queue[EXE_INF_PRIORITY_0],
-		sch_list[EXE_INF_PRIORITY_0], node);
-	cve_dle_add_to_list_before(sch_queue[EXE_INF_PRIORITY_1],
-		sch_list[EXE_INF_PRIORITY_1], node);
-	cve_dle_add_to_list_before(node->ntw->sch_queue[EXE_INF_PRIORITY_0],
-		ntw_queue[EXE_INF_PRIORITY_0], node);
-	cve_dle_add_to_list_before(node->ntw->sch_queue[EXE_INF_PRIORITY_1],
-		ntw_queue[EXE_INF_PRIORITY_1], node);
+	if (node->ntype == NODE_TYPE_RESERVE) {
+		/* Reservation does not block the Inferences queued after it,
+		 * it is admitted as soon as the resources are free.
+		 */
+		getnstimeofday(&node->queued_ts);
+		cve_dle_add_to_list_before(sch_res_queue, res_list, node);
+	} else {
+		cve_dle_add_to_list_before(sch_queue[EXE_INF_PRIORITY_0],
+			sch_list[EXE_INF_PRIORITY_0], node);
+		cve_dle_add_to_list_before(sch_queue[EXE_INF_PRIORITY_1],
+			sch_list[EXE_INF_PRIORITY_1], node);
+		cve_dle_add_to_list_before(
+			node->ntw->sch_queue[EXE_INF_PRIORITY_0],
+			ntw_queue[EXE_INF_PRIORITY_0], node);
+		cve_dle_add_to_list_before(
+			node->ntw->sch_queue[EXE_INF_PRIORITY_1],
+			ntw_queue[EXE_INF_PRIORITY_1], node);
+	}
 
 	node->is_success = false;
 
@@ -436,6 +552,13 @@ void ice_sch_add_rr_to_queue(struct execution_node *node)
 
 static void __del_rr_from_queue(struct execution_node *node)
 {
+	node->is_queued = false;
+
+	if (node->ntype == NODE_TYPE_RESERVE) {
+		cve_dle_remove_from_list(sch_res_queue, res_list, node);
+		return;
+	}
+
 	cve_dle_remove_from_list(sch_queue[EXE_INF_PRIORITY_0],
 		sch_list[EXE_INF_PRIORITY_0], node);
 	cve_dle_remove_from_list(sch_queue[EXE_INF_PRIORITY_1],
@@ -449,10 +572,8 @@ static void __del_rr_from_queue(struct execution_node *node)
 int ice_sch_del_rr_from_queue(struct execution_node *node)
 {
 	int ret = -1;
-	/* Dispatcher will delete only reservation node.
-	 * If it is reserved by now then node is already deleted.
-	 */
-	if (!node->ntw->res_resource) {
+	/* Node is already deleted if the scheduler has served it */
+	if (node->is_queued) {
 
 		__del_rr_from_queue(node);
 		ret = 0;
@@ -20,6 +20,11 @@
 
 void ice_sch_engine(struct ice_network *ntw);
 void ice_sch_add_inf_to_queue(struct ice_infer *inf);
+/* Queue the inference without running the scheduler. Caller must follow
+ * up with ice_sch_trigger() once all inferences of a batch are queued.
+ */
+void ice_sch_enqueue_inf(struct ice_infer *inf);
+void ice_sch_trigger(void);
 void ice_sch_del_inf_from_queue(struct ice_infer *inf);
 void ice_sch_add_rr_to_queue(struct execution_node *node);
 int ice_sch_del_rr_from_queue(struct execution_node *node);
@@ -14,6 +14,8 @@
 #include <linux/anon_inodes.h>
 #include <linux/uaccess.h>
 #include <linux/fcntl.h>
+#include <linux/percpu.h>
+#include <linux/workqueue.h>
 #include "sph_log.h"
 
 
@@ -25,6 +27,9 @@
 
 #define MAX_STALE_ATTR_NAME_LEN    32
 
+/* period of folding per-CPU deltas into mmaped values pages */
+#define SPH_SW_COUNTERS_FOLD_MS    100
+
 #define SW_COUNTERS_ASSERT(x)						\
 	do {							\
 		if (likely(x))					\
@@ -50,6 +55,8 @@ struct sph_sw_counters_bin_file_attr {
 	char				*info_buf;
 	ssize_t				info_size;
 	u64                             dirty_at_remove;
+	/* values to fold before read, NULL for info and stale files */
+	struct sph_sw_counters		*counters;
 };
 
 struct bin_stale_node {
@@ -98,8 +105,79 @@ struct sph_internal_sw_counters {
 	struct sph_sw_counters				sw_counters;
 	struct sph_internal_sw_counters			*parent;
 	struct gen_sync_attr			        *gen_sync_attr;
+	/* sum of the per-CPU deltas already folded into values */
+	u64						*pcpu_folded;
+	spinlock_t					fold_lock;
+	/* on g_mapped_values once the values file was mmaped */
+	struct list_head				mapped_node;
+	bool						mapped;
 };
 
+static void fold_mapped_values(struct work_struct *work);
+
+/* values nodes folded periodically, as mmap readers bypass read */
+static LIST_HEAD(g_mapped_values);
+static DEFINE_MUTEX(g_mapped_lock);
+static DECLARE_DELAYED_WORK(g_fold_work, fold_mapped_values);
+
+/* called with fold_lock held */
+static void fold_counter(struct sph_internal_sw_counters *sw_counters_values,
+			 u32 index)
+{
+	struct sph_sw_counters *counters = &sw_counters_values->sw_counters;
+	u64 sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		sum += per_cpu_ptr(counters->pcpu_values, cpu)[index];
+
+	/* unsigned arithmetic, so DEC deltas fold as well */
+	counters->values[index] += sum - sw_counters_values->pcpu_folded[index];
+	sw_counters_values->pcpu_folded[index] = sum;
+}
+
+static void fold_values_node(struct sph_internal_sw_counters *sw_counters_values)
+{
+	u32 count = sw_counters_values->counters_set->counters_count;
+	u32 i;
+
+	spin_lock(&sw_counters_values->fold_lock);
+	for (i = 0; i < count; i++)
+		fold_counter(sw_counters_values, i);
+	spin_unlock(&sw_counters_values->fold_lock);
+}
+
+static void fold_mapped_values(struct work_struct *work)
+{
+	struct sph_internal_sw_counters *sw_counters_values;
+
+	mutex_lock(&g_mapped_lock);
+	list_for_each_entry(sw_counters_values, &g_mapped_values, mapped_node)
+		fold_values_node(sw_counters_values);
+
+	if (!list_empty(&g_mapped_values))
+		schedule_delayed_work(&g_fold_work,
+				      msecs_to_jiffies(SPH_SW_COUNTERS_FOLD_MS));
+	mutex_unlock(&g_mapped_lock);
+}
+
+void sph_sw_counters_fold(struct sph_sw_counters *counters)
+{
+	fold_values_node(SW_COUNTERS_TO_INTERNAL(counters));
+}
+
+u64 sph_sw_counter_get(struct sph_sw_counters *counters, u32 index)
+{
+	struct sph_internal_sw_counters *sw_counters_values =
+		SW_COUNTERS_TO_INTERNAL(counters);
+
+	spin_lock(&sw_counters_values->fold_lock);
+	fold_counter(sw_counters_values, index);
+	spin_unlock(&sw_counters_values->fold_lock);
+
+	return counters->values[index];
+}
+
 /* create counters description buffer object */
 int create_sw_counters_description_data(const  struct sph_sw_counters_set *counters_set,
 					bool isRoot,
@@ -195,6 +273,24 @@ static int mmap_sph_counter_bin_values(struct file *f,
 	if (size > PAGE_SIZE)
 		return -EINVAL;
 
+	/* from now on the values page is read without us knowing */
+	if (counters_att->counters) {
+		struct sph_internal_sw_counters *sw_counters_values =
+			SW_COUNTERS_TO_INTERNAL(counters_att->counters);
+
+		fold_values_node(sw_counters_values);
+
+		mutex_lock(&g_mapped_lock);
+		if (!sw_counters_values->mapped) {
+			sw_counters_values->mapped = true;
+			list_add_tail(&sw_counters_values->mapped_node,
+				      &g_mapped_values);
+		}
+		schedule_delayed_work(&g_fold_work,
+				      msecs_to_jiffies(SPH_SW_COUNTERS_FOLD_MS));
+		mutex_unlock(&g_mapped_lock);
+	}
+
 	/*
 	 * detach this allocation from the attribute file,
 	 * so that the mapping will survive file destruction
@@ -221,6 +317,9 @@ static ssize_t read_sph_counter_bin_values(struct file *f,
 
 	struct sph_sw_counters_bin_file_attr *counters_att = (struct sph_sw_counters_bin_file_attr *)attr;
 
+	if (counters_att->counters)
+		sph_sw_counters_fold(counters_att->counters);
+
 	if (!counters_att->bin_page || !counters_att->page_count)
 		ret = -1;
 	else
@@ -1089,25 +1188,22 @@ int sph_create_sw_counters_values_node(void *hInfoNode,
 	}
 
 
-	/* initialize spinlocks for atomic counters update */
-	n = counters_size / SPH_COUNTER_SIZE;
-	if (n > 0) {
-		sw_counters_values->sw_counters.spinlocks = kmalloc_array(n,
-									  sizeof(spinlock_t),
-									  GFP_KERNEL);
-		if (sw_counters_values->sw_counters.spinlocks == NULL) {
-			sph_log_err(GENERAL_LOG, "unable to allocate memory for spinlocks\n");
-			ret = -ENOMEM;
-			goto cleanup_sw_counters_children_kobject_list;
-		}
-
-		do {
-			n--;
-			spin_lock_init(&sw_counters_values->sw_counters.spinlocks[n]);
-		} while (n > 0);
-	} else {
-		sw_counters_values->sw_counters.spinlocks = NULL;
+	/* allocate per-CPU deltas for atomic counters update */
+	n = sw_counters_info->counters_set->counters_count;
+	sw_counters_values->sw_counters.pcpu_values =
+		__alloc_percpu(max_t(u32, n, 1) * sizeof(u64), sizeof(u64));
+	sw_counters_values->pcpu_folded = kcalloc(max_t(u32, n, 1),
+						  sizeof(u64),
+						  GFP_KERNEL);
+	if (sw_counters_values->sw_counters.pcpu_values == NULL ||
+	    sw_counters_values->pcpu_folded == NULL) {
+		sph_log_err(GENERAL_LOG, "unable to allocate memory for per-CPU counters\n");
+		ret = -ENOMEM;
+		goto cleanup_sw_counters_pcpu;
 	}
+	spin_lock_init(&sw_counters_values->fold_lock);
+	INIT_LIST_HEAD(&sw_counters_values->mapped_node);
+	sw_counters_values->bin_file.counters = &sw_counters_values->sw_counters;
 
 	/* set the external buffer to user */
 	*counters = &(sw_counters_values->sw_counters);
@@ -1122,6 +1218,9 @@ int sph_create_sw_counters_values_node(void *hInfoNode,
 
 	return 0;
 
+cleanup_sw_counters_pcpu:
+	free_percpu(sw_counters_values->sw_counters.pcpu_values);
+	kfree(sw_counters_values->pcpu_folded);
 cleanup_sw_counters_children_kobject_list:
 if (sw_counters_info->counters_set->perID) {
 	struct kobj_node *kobjNode;
@@ -1157,6 +1256,7 @@ int sph_sw_counters_release_values_node(struct sph_internal_sw_counters *sw_coun
 	struct sph_internal_sw_counters *tmp_sw_counters_values = sw_counters_values;
 	struct kobj_node *kobjNode;
 	u64 root_dirty = 0;
+	bool fold_idle;
 
 	/* once new object was deleted we will update node to root */
 	while (tmp_sw_counters_values->parent != NULL) {
@@ -1165,6 +1265,18 @@ int sph_sw_counters_release_values_node(struct sph_internal_sw_counters *sw_coun
 	}
 	root_dirty = ++(*tmp_sw_counters_values->dirty);
 
+	/* stop periodic folding, and fold what is left for stale readers */
+	mutex_lock(&g_mapped_lock);
+	if (sw_counters_values->mapped)
+		list_del(&sw_counters_values->mapped_node);
+	fold_idle = list_empty(&g_mapped_values);
+	mutex_unlock(&g_mapped_lock);
+
+	if (fold_idle)
+		cancel_delayed_work_sync(&g_fold_work);
+
+	fold_values_node(sw_counters_values);
+	sw_counters_values->bin_file.counters = NULL;
 
 
 	remove_group_files(sw_counters_values);
@@ -1214,7 +1326,8 @@ int sph_sw_counters_release_values_node(struct sph_internal_sw_counters *sw_coun
 	if (bGroupsOwner)
 		kfree(sw_counters_values->sw_counters.groups);
 
-	kfree(sw_counters_values->sw_counters.spinlocks);
+	free_percpu(sw_counters_values->sw_counters.pcpu_values);
+	kfree(sw_counters_values->pcpu_folded);
 
 	mutex_destroy(&sw_counters_values->list_lock);
 	kfree(sw_counters_values);
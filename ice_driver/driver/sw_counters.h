@@ -13,6 +13,7 @@
 
 #include <linux/types.h>
 #include <linux/spinlock.h>
+#include <linux/percpu.h>
 
 struct kobject;
 
@@ -40,12 +41,19 @@ struct sph_sw_counters_set {
 	const u32				groups_count;
 };
 
-/* struct to describe counter values and enabled groups */
+/*
+ * struct to describe counter values and enabled groups
+ * ATOMIC updates go to per-CPU deltas (pcpu_values) instead of values, and
+ * are folded into values when the values file is read, periodically while
+ * it is mmaped and by sph_sw_counter_get(). A counter should be updated
+ * either with the ATOMIC macros or with the plain ones, which are left to
+ * the caller to serialize.
+ */
 struct sph_sw_counters {
 	u64        *values;
 	u32        *groups;
 	const u32  *global_groups;
-	spinlock_t *spinlocks;
+	u64 __percpu *pcpu_values;
 };
 
 /* create sw counters_set_node */
@@ -66,6 +74,12 @@ int sph_create_sw_counters_values_node(void *hInfoNode,
 /* create values object, also need to attach to corrent info node that matches values creation */
 int sph_remove_sw_counters_values_node(struct sph_sw_counters *counters);
 
+/* fold the per-CPU deltas of all counters into values */
+void sph_sw_counters_fold(struct sph_sw_counters *counters);
+
+/* fold the per-CPU deltas of a counter and return its value */
+u64 sph_sw_counter_get(struct sph_sw_counters *counters, u32 index);
+
 /* MACROS FOR SW COUNTER - g_sph_sw_counters */
 
 #define SPH_SW_GROUP_IS_ENABLE(_obj, _index)    \
@@ -94,33 +108,17 @@ int sph_remove_sw_counters_values_node(struct sph_sw_counters *counters);
 #define SPH_SW_COUNTER_DEC_VAL(_obj, _index, _val) \
 	(_obj->values[_index] -= (_val))
 
-#define SPH_SW_COUNTER_ATOMIC_INC(_obj, _index)            \
-	do {                                               \
-		spin_lock(&((_obj)->spinlocks[_index]));   \
-		(_obj->values[_index]++);                  \
-		spin_unlock(&((_obj)->spinlocks[_index])); \
-	} while (0)
-
-#define SPH_SW_COUNTER_ATOMIC_DEC(_obj, _index)            \
-	do {                                               \
-		spin_lock(&((_obj)->spinlocks[_index]));   \
-		(_obj->values[_index]--);                  \
-		spin_unlock(&((_obj)->spinlocks[_index])); \
-	} while (0)
-
-#define SPH_SW_COUNTER_ATOMIC_ADD(_obj, _index, _val)        \
-	do {                                                 \
-		spin_lock(&((_obj)->spinlocks[_index]));     \
-		(_obj->values[_index] += (_val));            \
-		spin_unlock(&((_obj)->spinlocks[_index]));   \
-	} while (0)
-
-#define SPH_SW_COUNTER_ATOMIC_DEC_VAL(_obj, _index, _val)         \
-	do {                                                      \
-		spin_lock(&((_obj)->spinlocks[_index]));          \
-		(_obj->values[_index] -= (_val));                 \
-		spin_unlock(&((_obj)->spinlocks[_index]));        \
-	} while (0)
+#define SPH_SW_COUNTER_ATOMIC_INC(_obj, _index) \
+	this_cpu_inc((_obj)->pcpu_values[(_index)])
+
+#define SPH_SW_COUNTER_ATOMIC_DEC(_obj, _index) \
+	this_cpu_dec((_obj)->pcpu_values[(_index)])
+
+#define SPH_SW_COUNTER_ATOMIC_ADD(_obj, _index, _val) \
+	this_cpu_add((_obj)->pcpu_values[(_index)], (_val))
+
+#define SPH_SW_COUNTER_ATOMIC_DEC_VAL(_obj, _index, _val) \
+	this_cpu_sub((_obj)->pcpu_values[(_index)], (_val))
 
 
 #endif //__SPH_SW_COUNTERS_H
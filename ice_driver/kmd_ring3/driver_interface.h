@@ -24,4 +24,19 @@ int cve_ioctl_misc(int fd, int request, struct cve_ioctl_param * param);
 int cve_open_misc(void);
 int cve_close_misc(int fd);
 
+/* hold and wait time of the driver big lock, for benchmarks */
+struct ice_os_lock_stats {
+	/* number of times the lock was taken while enabled */
+	__u64 acquire_nr;
+	/* total and longest time the lock was held */
+	__u64 hold_ns;
+	__u64 max_hold_ns;
+	/* total time spent waiting for the lock */
+	__u64 wait_ns;
+};
+
+/* resets the statistics and starts (enable != 0) or stops collecting */
+void ice_os_lock_stats_enable(int enable);
+void ice_os_lock_stats_get(struct ice_os_lock_stats *stats);
+
 #endif /* DRIVER_INTERFACE_H_ */
@@ -0,0 +1,184 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2017-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+/*
+ * IOVA allocator fragmentation and latency benchmark.
+ *
+ * Emulates repeated network create/destroy cycles on one allocator. Every
+ * cycle allocates the buffers of a new network and destroys a random older
+ * network, so that long uptimes are reached in a few seconds.
+ *
+ * usage: iova_bench [cycles] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "iova_allocator.h"
+
+/* 4GB of 4KB pages */
+#define BENCH_IOVA_TOP (1U << 20)
+#define BENCH_LIVE_NTW 64
+#define BENCH_MAX_BUF_PER_NTW 128
+#define BENCH_MAX_BUF_PAGES 1024
+#define BENCH_REPORT_INTERVAL 1000
+
+struct bench_ntw {
+	u32 num_buf;
+	u32 first_page[BENCH_MAX_BUF_PER_NTW];
+	u32 pages_nr[BENCH_MAX_BUF_PER_NTW];
+};
+
+struct bench_lat {
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+};
+
+static struct bench_ntw live_ntw[BENCH_LIVE_NTW];
+
+static u64 __now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+static void __lat_add(struct bench_lat *lat, u64 ns)
+{
+	lat->count++;
+	lat->total_ns += ns;
+	if (ns > lat->max_ns)
+		lat->max_ns = ns;
+}
+
+/* mostly small surfaces with a long tail of large ones */
+static u32 __buf_pages(void)
+{
+	u32 order = (u32)rand() % 11;
+
+	return 1 + ((u32)rand() % (1U << order)) % BENCH_MAX_BUF_PAGES;
+}
+
+static void __destroy_ntw(cve_iova_allocator_handle_t allocator,
+		struct bench_ntw *ntw, struct bench_lat *lat)
+{
+	u32 i;
+	u64 t;
+
+	for (i = 0; i < ntw->num_buf; i++) {
+		t = __now_ns();
+		cve_iova_free(allocator, ntw->first_page[i], ntw->pages_nr[i]);
+		__lat_add(lat, __now_ns() - t);
+	}
+	ntw->num_buf = 0;
+}
+
+static u32 __create_ntw(cve_iova_allocator_handle_t allocator,
+		struct bench_ntw *ntw, struct bench_lat *lat)
+{
+	u32 i, num_buf, failed = 0;
+	u64 t;
+	int ret;
+
+	num_buf = 1 + (u32)rand() % BENCH_MAX_BUF_PER_NTW;
+	for (i = 0; i < num_buf; i++) {
+		ntw->pages_nr[ntw->num_buf] = __buf_pages();
+
+		t = __now_ns();
+		ret = cve_iova_alloc(allocator, ntw->pages_nr[ntw->num_buf],
+				&ntw->first_page[ntw->num_buf]);
+		__lat_add(lat, __now_ns() - t);
+
+		if (ret == 0)
+			ntw->num_buf++;
+		else
+			failed++;
+	}
+
+	return failed;
+}
+
+static void __report(cve_iova_allocator_handle_t allocator, u32 cycle,
+		struct bench_lat *alloc_lat, struct bench_lat *free_lat,
+		u32 failed)
+{
+	struct ice_iova_free_stats stats;
+	u32 frag_pct = 0;
+
+	cve_iova_get_free_stats(allocator, &stats);
+	if (stats.free_pages_nr)
+		frag_pct = 100 - (u32)((u64)stats.largest_free_pages_nr *
+				100 / stats.free_pages_nr);
+
+	printf("cycle=%u ranges=%u free=%u largest=%u frag=%u%% alloc_avg=%lluns alloc_max=%lluns free_avg=%lluns free_max=%lluns failed=%u\n",
+		cycle, stats.free_ranges_nr, stats.free_pages_nr,
+		stats.largest_free_pages_nr, frag_pct,
+		(unsigned long long)(alloc_lat->count ?
+			alloc_lat->total_ns / alloc_lat->count : 0),
+		(unsigned long long)alloc_lat->max_ns,
+		(unsigned long long)(free_lat->count ?
+			free_lat->total_ns / free_lat->count : 0),
+		(unsigned long long)free_lat->max_ns,
+		failed);
+
+	memset(alloc_lat, 0, sizeof(*alloc_lat));
+	memset(free_lat, 0, sizeof(*free_lat));
+}
+
+int main(int argc, char **argv)
+{
+	cve_iova_allocator_handle_t allocator = NULL;
+	struct bench_lat alloc_lat, free_lat;
+	u32 cycles = 100000, cycle, idx, failed = 0;
+	unsigned int seed = 1;
+	int ret;
+
+	if (argc > 1)
+		cycles = (u32)strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		seed = (unsigned int)strtoul(argv[2], NULL, 0);
+	srand(seed);
+
+	ret = cve_iova_allocator_init(1, BENCH_IOVA_TOP, &allocator);
+	if (ret < 0) {
+		printf("cve_iova_allocator_init failed %d\n", ret);
+		return 1;
+	}
+
+	memset(&alloc_lat, 0, sizeof(alloc_lat));
+	memset(&free_lat, 0, sizeof(free_lat));
+
+	for (cycle = 1; cycle <= cycles; cycle++) {
+		idx = (u32)rand() % BENCH_LIVE_NTW;
+		__destroy_ntw(allocator, &live_ntw[idx], &free_lat);
+		failed += __create_ntw(allocator, &live_ntw[idx], &alloc_lat);
+
+		if (cycle % BENCH_REPORT_INTERVAL == 0) {
+			__report(allocator, cycle, &alloc_lat, &free_lat,
+					failed);
+			failed = 0;
+		}
+	}
+
+	for (idx = 0; idx < BENCH_LIVE_NTW; idx++)
+		__destroy_ntw(allocator, &live_ntw[idx], &free_lat);
+
+	cve_iova_allocator_destroy(&allocator);
+
+	return 0;
+}
@@ -259,10 +259,14 @@ void release_firmware(const struct firmware *fw);
 void atomic_set(atomic_t *v, int i);
 int atomic_read(const atomic_t *v);
 int atomic_xchg(atomic_t *v, int n);
+void atomic_or(int i, atomic_t *v);
 int atomic_add_return(int i, atomic_t *v);
 int atomic_sub_return(int i, atomic_t *v);
 void atomic64_set(atomic64_t *v, u64 i);
 u64 atomic64_read(const atomic64_t *v);
+
+#define smp_wmb() __sync_synchronize()
+#define smp_rmb() __sync_synchronize()
 u64 atomic64_xchg(atomic64_t *v, u64 n);
 u64 atomic64_add_return(u64 i, atomic64_t *v);
 
@@ -304,6 +308,9 @@ static inline void dma_buf_detach(struct dma_buf *dmabuf,
 	struct dma_buf_attachment *dbuf_attach)
 { }
 
+static inline void get_dma_buf(struct dma_buf *dmabuf)
+{ }
+
 static inline void dma_buf_put(struct dma_buf *dmabuf)
 { }        
 
@@ -25,6 +25,7 @@
 #include <pthread.h>
 #include <sys/mman.h>
 #include <sys/time.h>
+#include <time.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <fcntl.h>
@@ -369,6 +370,15 @@ int cve_os_interface_init(void)
 
 
 	param.enable_mmu_pmon = enable_mmu_pmon;
+	param.enable_inf_cb_copy = (getenv("ENABLE_INF_CB_COPY") != NULL);
+	param.enable_large_page_promotion =
+		(getenv("DISABLE_LARGE_PAGE_PROMOTION") == NULL);
+	/* For RING3, pages are not pinned so the pin cache is disabled */
+	param.pin_cache_max_entries = 0;
+	param.enable_adaptive_power_off =
+		(getenv("DISABLE_ADAPTIVE_POWER_OFF") == NULL);
+	param.enable_sticky_resource =
+		(getenv("DISABLE_STICKY_RESOURCE") == NULL);
 	param.enable_llc_config_via_axi_reg = enable_llc_config_via_axi_reg;
 	/* For RING3, space is always set to 0*/
 	param.sph_soc = 0;
@@ -685,19 +695,73 @@ int cve_os_lock_init(cve_os_lock_t *lock)
 	return pthread_mutex_init(l, NULL);
 }
 
+/* big lock statistics, updated only while holding the big lock */
+static int biglock_stats_enabled;
+static u64 biglock_acquired_ns;
+static struct ice_os_lock_stats biglock_stats;
+
+static u64 __biglock_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+void ice_os_lock_stats_enable(int enable)
+{
+	cve_os_lock(&g_cve_driver_biglock, CVE_NON_INTERRUPTIBLE);
+	memset(&biglock_stats, 0, sizeof(biglock_stats));
+	biglock_acquired_ns = 0;
+	cve_os_unlock(&g_cve_driver_biglock);
+
+	__atomic_store_n(&biglock_stats_enabled, enable, __ATOMIC_RELEASE);
+}
+
+void ice_os_lock_stats_get(struct ice_os_lock_stats *stats)
+{
+	cve_os_lock(&g_cve_driver_biglock, CVE_NON_INTERRUPTIBLE);
+	*stats = biglock_stats;
+	cve_os_unlock(&g_cve_driver_biglock);
+}
+
 int cve_os_lock(cve_os_lock_t *lock, int is_interruptible)
 {
 	pthread_mutex_t *l = (pthread_mutex_t*)lock;
-	int pthread_mutex_lock_retval = pthread_mutex_lock(l);
-	if (pthread_mutex_lock_retval)
+	u64 wait_start_ns = 0;
+	int pthread_mutex_lock_retval;
+
+	if (lock == &g_cve_driver_biglock &&
+		__atomic_load_n(&biglock_stats_enabled, __ATOMIC_ACQUIRE))
+		wait_start_ns = __biglock_now_ns();
+
+	pthread_mutex_lock_retval = pthread_mutex_lock(l);
+	if (pthread_mutex_lock_retval) {
 		cve_os_log(CVE_LOGLEVEL_ERROR, "Could not obtain lock retval=%d\n", pthread_mutex_lock_retval);
-	return pthread_mutex_lock_retval;
+		return pthread_mutex_lock_retval;
+	}
+
+	if (wait_start_ns) {
+		biglock_acquired_ns = __biglock_now_ns();
+		biglock_stats.acquire_nr++;
+		biglock_stats.wait_ns += biglock_acquired_ns - wait_start_ns;
+	}
+	return 0;
 }
 
 
 void cve_os_unlock(cve_os_lock_t *lock)
 {
 	pthread_mutex_t *l = (pthread_mutex_t*)lock;
+
+	if (lock == &g_cve_driver_biglock && biglock_acquired_ns) {
+		u64 hold_ns = __biglock_now_ns() - biglock_acquired_ns;
+
+		biglock_stats.hold_ns += hold_ns;
+		if (hold_ns > biglock_stats.max_hold_ns)
+			biglock_stats.max_hold_ns = hold_ns;
+		biglock_acquired_ns = 0;
+	}
 	ASSERT(pthread_mutex_unlock(l) == 0);
 }
 
@@ -753,6 +817,11 @@ int atomic_xchg(atomic_t *v, int n)
 	return r;
 }
 
+void atomic_or(int i, atomic_t *v)
+{
+	__sync_or_and_fetch(v, i);
+}
+
 int atomic_read(const atomic_t *v)
 {
 	return (int)*v;
@@ -921,6 +990,12 @@ int cve_ioctl_misc(int fd, int request, struct cve_ioctl_param *param)
 				param->execute_infer.inferid,
 				&param->execute_infer.data);
 		break;
+	case ICE_IOCTL_EXECUTE_INFER_BATCH:
+		cve_os_log(CVE_LOGLEVEL_DEBUG,
+				"Simulation mode - ICE_IOCTL_EXECUTE_INFER_BATCH\n");
+		retval = cve_ds_handle_execute_infer_batch(context_pid,
+				&param->execute_infer_batch);
+		break;
 	case CVE_IOCTL_DESTROY_INFER:
 		cve_os_log(CVE_LOGLEVEL_DEBUG,
 				"Simulation mode - CVE_IOCTL_DESTROY_INFER\n");
@@ -958,6 +1033,19 @@ int cve_ioctl_misc(int fd, int request, struct cve_ioctl_param *param)
 				context_pid,
 				&param->get_event);
 		break;
+	case ICE_IOCTL_WAIT_FOR_EVENT_BATCH:
+		cve_os_log(CVE_LOGLEVEL_DEBUG,
+				"Simulation mode - ICE_IOCTL_WAIT_FOR_EVENT_BATCH\n");
+		retval = cve_ds_wait_for_event_batch(
+				context_pid,
+				&param->wait_event_batch);
+		break;
+	case ICE_IOCTL_COMPLETION_RING:
+		cve_os_log(CVE_LOGLEVEL_DEBUG,
+				"Simulation mode - ICE_IOCTL_COMPLETION_RING\n");
+		retval = cve_context_process_config_cring(context_pid,
+				&param->completion_ring);
+		break;
 	case CVE_IOCTL_GET_VERSION:
 		cve_os_log(CVE_LOGLEVEL_DEBUG,
 				"Simulation mode - CVE_IOCTL_GET_VERSION\n");
@@ -1002,6 +1090,18 @@ int cve_ioctl_misc(int fd, int request, struct cve_ioctl_param *param)
                                 param->reset_network.contextid,
                                 param->reset_network.networkid);
 		break;
+	case ICE_IOCTL_PREDICT_RUNTIME:
+		cve_os_log(CVE_LOGLEVEL_DEBUG,
+				"Simulation mode - ICE_IOCTL_PREDICT_RUNTIME\n");
+		retval = ice_ds_predict_runtime(context_pid,
+				&param->predict_runtime);
+		break;
+	case ICE_IOCTL_PMON_SAMPLES:
+		cve_os_log(CVE_LOGLEVEL_DEBUG,
+				"Simulation mode - ICE_IOCTL_PMON_SAMPLES\n");
+		retval = ice_ds_pmon_samples(context_pid,
+				&param->pmon_samples);
+		break;
 	default:
 		cve_os_log(CVE_LOGLEVEL_ERROR, "Unknown ioctl request (%d) was used\n", request);
 		retval = -EINVAL;
@@ -1071,6 +1171,19 @@ void cve_os_vunmap_dma_handle(void *vaddr)
 
 }
 
+/* In simulation mode the caller shares our address space, so a plain
+ * page aligned allocation is enough.
+ */
+int ice_os_alloc_user_shared(u32 size_bytes, void **out_kva)
+{
+	return __cve_os_malloc_zero(size_bytes, out_kva);
+}
+
+void ice_os_free_user_shared(void *kva, u32 size_bytes)
+{
+	__cve_os_free(kva, size_bytes);
+}
+
 /* Currently not supported */
 u32 cve_os_cve_devices_nr(void)
 {
@@ -0,0 +1,599 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2017-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+/*
+ * Scheduler latency and throughput benchmark.
+ *
+ * Creates contexts, each with networks made of synthetic command buffers,
+ * and submits ExecuteInfer at a target rate from one thread per context
+ * while another thread per context waits for the completions. Meant for the
+ * null device build (NULL_DEVICE_RING3=1) with ICE_SIM_PROFILE set, so that
+ * ICE run time is modeled and what is measured is the driver itself.
+ *
+ * usage: sched_bench [-c contexts] [-n networks] [-i ices] [-d depth]
+ *                    [-r rate] [-t seconds]
+ *
+ * ices is the number of ICEs (jobs) of every network, depth the number of
+ * Infers of every network, and rate the total ExecuteInfer rate per second,
+ * where 0 submits as fast as Infers complete.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "stdint_ext.h"
+#include "driver_interface.h"
+
+#define BENCH_MAX_CONTEXTS 16
+#define BENCH_MAX_NTW 16
+#define BENCH_MAX_ICES 12
+#define BENCH_MAX_DEPTH 64
+#define BENCH_MAX_SAMPLES (1 << 20)
+#define BENCH_CB_SIZE 4096
+/* size of a single CB command */
+#define BENCH_CB_CMD_SIZE 32
+#define BENCH_WAIT_TIMEOUT_MS 100
+/* consecutive wait timeouts after which in flight Infers are given up */
+#define BENCH_DRAIN_TIMEOUTS 50
+
+struct bench_cfg {
+	u32 contexts;
+	u32 networks;
+	u32 ices;
+	u32 depth;
+	u32 rate;
+	u32 seconds;
+};
+
+struct bench_samples {
+	u64 *ns;
+	u64 nr;
+};
+
+struct bench_ntw;
+
+struct bench_inf {
+	struct bench_ntw *ntw;
+	u64 infer_id;
+	u64 submit_ns;
+	int in_flight;
+};
+
+struct bench_ntw {
+	u64 network_id;
+	void *cb[BENCH_MAX_ICES];
+	struct cve_surface_descriptor buf_desc[BENCH_MAX_ICES];
+	u32 cb_idx[BENCH_MAX_ICES];
+	struct cve_job job[BENCH_MAX_ICES];
+	struct cve_job_group jg;
+	struct bench_inf inf[BENCH_MAX_DEPTH];
+	u32 inf_nr;
+};
+
+struct bench_ctx {
+	int fd;
+	u64 contextid;
+	struct bench_ntw ntw[BENCH_MAX_NTW];
+	u32 ntw_nr;
+	pthread_t submit_thread;
+	pthread_t wait_thread;
+	/* ExecuteInfer ioctl duration */
+	struct bench_samples submit_lat;
+	/* ExecuteInfer call to WaitForEvent return */
+	struct bench_samples compl_lat;
+	u64 submitted;
+	u64 completed;
+	u64 failed;
+	/* submissions delayed because all the Infers were in flight */
+	u64 backpressure;
+	int in_flight_nr;
+};
+
+static struct bench_cfg cfg = {
+	.contexts = 1,
+	.networks = 1,
+	.ices = 1,
+	.depth = 4,
+	.rate = 0,
+	.seconds = 5,
+};
+static struct bench_ctx ctx_list[BENCH_MAX_CONTEXTS];
+static int stop_submit;
+
+static u64 __now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+static void __sleep_until_ns(u64 deadline_ns)
+{
+	struct timespec ts;
+
+	ts.tv_sec = deadline_ns / 1000000000ULL;
+	ts.tv_nsec = deadline_ns % 1000000000ULL;
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static void __add_sample(struct bench_samples *s, u64 ns)
+{
+	if (s->nr < BENCH_MAX_SAMPLES)
+		s->ns[s->nr++] = ns;
+}
+
+static int __cmp_u64(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a;
+	u64 y = *(const u64 *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int __create_ntw(struct bench_ctx *ctx, struct bench_ntw *ntw)
+{
+	struct cve_ioctl_param param;
+	struct ice_network_descriptor *desc;
+	u32 i;
+	int ret;
+
+	for (i = 0; i < cfg.ices; i++) {
+		ntw->cb[i] = aligned_alloc(BENCH_CB_SIZE, BENCH_CB_SIZE);
+		if (!ntw->cb[i])
+			return -1;
+		memset(ntw->cb[i], 0, BENCH_CB_SIZE);
+
+		ntw->buf_desc[i].obj_id = i;
+		ntw->buf_desc[i].base_address = (u64)(uintptr_t)ntw->cb[i];
+		ntw->buf_desc[i].size_bytes = BENCH_CB_SIZE;
+		ntw->buf_desc[i].actual_size_bytes = BENCH_CB_CMD_SIZE;
+		ntw->buf_desc[i].direction = CVE_SURFACE_DIRECTION_IN;
+		ntw->buf_desc[i].surface_type = ICE_BUFFER_TYPE_SIMPLE_CB;
+
+		ntw->cb_idx[i] = i;
+		ntw->job[i].cb_nr = 1;
+		ntw->job[i].cb_buf_desc_list = (u64)(uintptr_t)&ntw->cb_idx[i];
+		ntw->job[i].graph_ice_id = -1;
+	}
+
+	ntw->jg.jobs_nr = cfg.ices;
+	ntw->jg.jobs = (u64)(uintptr_t)ntw->job;
+	ntw->jg.num_of_cves = cfg.ices;
+	ntw->jg.produce_completion = 1;
+
+	memset(&param, 0, sizeof(param));
+	param.create_network.contextid = ctx->contextid;
+	desc = &param.create_network.network;
+	desc->obj_id = -1;
+	desc->parent_obj_id = -1;
+	desc->num_ice = cfg.ices;
+	desc->buf_desc_list = ntw->buf_desc;
+	desc->num_buf_desc = cfg.ices;
+	desc->jg_desc_list = &ntw->jg;
+	desc->num_jg_desc = 1;
+	desc->produce_completion = 1;
+	desc->network_type = ICE_SIMPLE_NETWORK;
+	desc->icebo_req = ICEBO_DEFAULT;
+
+	ret = cve_ioctl_misc(ctx->fd, CVE_IOCTL_CREATE_NETWORK, &param);
+	if (ret) {
+		fprintf(stderr, "CreateNetwork failed %d\n", ret);
+		return ret;
+	}
+	ntw->network_id = desc->network_id;
+
+	for (i = 0; i < cfg.depth; i++) {
+		struct bench_inf *inf = &ntw->inf[i];
+
+		inf->ntw = ntw;
+		memset(&param, 0, sizeof(param));
+		param.create_infer.contextid = ctx->contextid;
+		param.create_infer.networkid = ntw->network_id;
+		param.create_infer.infer.obj_id = -1;
+		param.create_infer.infer.user_data = (u64)(uintptr_t)inf;
+
+		ret = cve_ioctl_misc(ctx->fd, CVE_IOCTL_CREATE_INFER, &param);
+		if (ret) {
+			fprintf(stderr, "CreateInfer failed %d\n", ret);
+			return ret;
+		}
+		inf->infer_id = param.create_infer.infer.infer_id;
+		ntw->inf_nr++;
+	}
+
+	return 0;
+}
+
+static void __destroy_ntw(struct bench_ctx *ctx, struct bench_ntw *ntw)
+{
+	struct cve_ioctl_param param;
+	u32 i;
+
+	for (i = 0; i < ntw->inf_nr; i++) {
+		memset(&param, 0, sizeof(param));
+		param.destroy_infer.contextid = ctx->contextid;
+		param.destroy_infer.networkid = ntw->network_id;
+		param.destroy_infer.inferid = ntw->inf[i].infer_id;
+		cve_ioctl_misc(ctx->fd, CVE_IOCTL_DESTROY_INFER, &param);
+	}
+
+	if (ntw->network_id) {
+		memset(&param, 0, sizeof(param));
+		param.destroy_network.contextid = ctx->contextid;
+		param.destroy_network.networkid = ntw->network_id;
+		cve_ioctl_misc(ctx->fd, CVE_IOCTL_DESTROY_NETWORK, &param);
+	}
+
+	for (i = 0; i < cfg.ices; i++)
+		free(ntw->cb[i]);
+}
+
+static int __create_ctx(struct bench_ctx *ctx)
+{
+	struct cve_ioctl_param param;
+	int ret;
+
+	ctx->submit_lat.ns = calloc(BENCH_MAX_SAMPLES, sizeof(u64));
+	ctx->compl_lat.ns = calloc(BENCH_MAX_SAMPLES, sizeof(u64));
+	if (!ctx->submit_lat.ns || !ctx->compl_lat.ns)
+		return -1;
+
+	ctx->fd = cve_open_misc();
+	if (ctx->fd < 0) {
+		fprintf(stderr, "open failed %d\n", ctx->fd);
+		return ctx->fd;
+	}
+
+	memset(&param, 0, sizeof(param));
+	param.create_context.obj_id = -1;
+	ret = cve_ioctl_misc(ctx->fd, CVE_IOCTL_CREATE_CONTEXT, &param);
+	if (ret) {
+		fprintf(stderr, "CreateContext failed %d\n", ret);
+		return ret;
+	}
+	ctx->contextid = param.create_context.out_contextid;
+
+	for (ctx->ntw_nr = 0; ctx->ntw_nr < cfg.networks; ctx->ntw_nr++) {
+		ret = __create_ntw(ctx, &ctx->ntw[ctx->ntw_nr]);
+		if (ret) {
+			/* partially created, destroyed with the others */
+			ctx->ntw_nr++;
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static void __destroy_ctx(struct bench_ctx *ctx)
+{
+	struct cve_ioctl_param param;
+	u32 i;
+
+	if (ctx->fd <= 0)
+		goto free_samples;
+
+	for (i = 0; i < ctx->ntw_nr; i++)
+		__destroy_ntw(ctx, &ctx->ntw[i]);
+
+	if (ctx->contextid) {
+		memset(&param, 0, sizeof(param));
+		param.destroy_context.contextid = ctx->contextid;
+		cve_ioctl_misc(ctx->fd, CVE_IOCTL_DESTROY_CONTEXT, &param);
+	}
+	cve_close_misc(ctx->fd);
+
+free_samples:
+	free(ctx->submit_lat.ns);
+	free(ctx->compl_lat.ns);
+}
+
+/* round robin over the networks, then over the Infers of each network */
+static struct bench_inf *__get_free_inf(struct bench_ctx *ctx, u32 *cursor)
+{
+	u32 total = ctx->ntw_nr * cfg.depth;
+	u32 i;
+
+	for (i = 0; i < total; i++) {
+		u32 pos = (*cursor + i) % total;
+		struct bench_inf *inf =
+			&ctx->ntw[pos % ctx->ntw_nr].inf[pos / ctx->ntw_nr];
+
+		if (!__atomic_load_n(&inf->in_flight, __ATOMIC_ACQUIRE)) {
+			*cursor = pos + 1;
+			return inf;
+		}
+	}
+
+	return NULL;
+}
+
+static void *__submit_thread(void *arg)
+{
+	struct bench_ctx *ctx = arg;
+	struct cve_ioctl_param param;
+	struct bench_inf *inf;
+	u64 interval_ns = 0, next_ns, t0, t1;
+	u32 cursor = 0;
+	int ret;
+
+	if (cfg.rate)
+		interval_ns = 1000000000ULL * cfg.contexts / cfg.rate;
+	next_ns = __now_ns();
+
+	while (!__atomic_load_n(&stop_submit, __ATOMIC_ACQUIRE)) {
+		if (interval_ns) {
+			__sleep_until_ns(next_ns);
+			next_ns += interval_ns;
+		}
+
+		inf = __get_free_inf(ctx, &cursor);
+		if (!inf) {
+			ctx->backpressure++;
+			/* open loop keeps its schedule, the Infer is dropped */
+			if (!interval_ns)
+				sched_yield();
+			continue;
+		}
+
+		memset(&param, 0, sizeof(param));
+		param.execute_infer.contextid = ctx->contextid;
+		param.execute_infer.networkid = inf->ntw->network_id;
+		param.execute_infer.inferid = inf->infer_id;
+		param.execute_infer.data.priority = EXE_INF_PRIORITY_0;
+
+		__atomic_store_n(&inf->in_flight, 1, __ATOMIC_RELEASE);
+		__atomic_add_fetch(&ctx->in_flight_nr, 1, __ATOMIC_ACQ_REL);
+
+		t0 = __now_ns();
+		inf->submit_ns = t0;
+		ret = cve_ioctl_misc(ctx->fd, CVE_IOCTL_EXECUTE_INFER, &param);
+		t1 = __now_ns();
+
+		if (ret) {
+			__atomic_store_n(&inf->in_flight, 0, __ATOMIC_RELEASE);
+			__atomic_sub_fetch(&ctx->in_flight_nr, 1,
+					__ATOMIC_ACQ_REL);
+			ctx->failed++;
+			continue;
+		}
+
+		__add_sample(&ctx->submit_lat, t1 - t0);
+		ctx->submitted++;
+	}
+
+	return NULL;
+}
+
+static void *__wait_thread(void *arg)
+{
+	struct bench_ctx *ctx = arg;
+	struct cve_ioctl_param param;
+	struct bench_inf *inf;
+	u32 timeouts = 0;
+	int ret;
+
+	while (!__atomic_load_n(&stop_submit, __ATOMIC_ACQUIRE) ||
+		__atomic_load_n(&ctx->in_flight_nr, __ATOMIC_ACQUIRE)) {
+
+		memset(&param, 0, sizeof(param));
+		param.get_event.contextid = ctx->contextid;
+		param.get_event.timeout_msec = BENCH_WAIT_TIMEOUT_MS;
+
+		ret = cve_ioctl_misc(ctx->fd, CVE_IOCTL_WAIT_FOR_EVENT, &param);
+		if (ret ||
+			param.get_event.wait_status != CVE_WAIT_EVENT_COMPLETE) {
+			if (__atomic_load_n(&stop_submit, __ATOMIC_ACQUIRE) &&
+				++timeouts >= BENCH_DRAIN_TIMEOUTS)
+				break;
+			continue;
+		}
+		timeouts = 0;
+
+		inf = (struct bench_inf *)(uintptr_t)param.get_event.user_data;
+		__add_sample(&ctx->compl_lat, __now_ns() - inf->submit_ns);
+		if (param.get_event.jobs_group_status ==
+				CVE_JOBSGROUPSTATUS_COMPLETED)
+			ctx->completed++;
+		else
+			ctx->failed++;
+
+		__atomic_store_n(&inf->in_flight, 0, __ATOMIC_RELEASE);
+		__atomic_sub_fetch(&ctx->in_flight_nr, 1, __ATOMIC_ACQ_REL);
+	}
+
+	return NULL;
+}
+
+static void __report_lat(const char *name, struct bench_samples *all)
+{
+	static const u32 pct_x10[] = {500, 900, 990, 999};
+	u32 i;
+
+	if (!all->nr) {
+		printf("%-10s no samples\n", name);
+		return;
+	}
+
+	qsort(all->ns, all->nr, sizeof(u64), __cmp_u64);
+	printf("%-10s", name);
+	for (i = 0; i < sizeof(pct_x10) / sizeof(pct_x10[0]); i++)
+		printf(" p%u.%u=%.1fus", pct_x10[i] / 10, pct_x10[i] % 10,
+			all->ns[(all->nr - 1) * pct_x10[i] / 1000] / 1000.0);
+	printf(" max=%.1fus\n", all->ns[all->nr - 1] / 1000.0);
+}
+
+static int __merge_samples(struct bench_samples *all, size_t offset)
+{
+	u32 i;
+
+	all->nr = 0;
+	for (i = 0; i < cfg.contexts; i++)
+		all->nr += ((struct bench_samples *)
+			((char *)&ctx_list[i] + offset))->nr;
+
+	all->ns = malloc((all->nr ? all->nr : 1) * sizeof(u64));
+	if (!all->ns)
+		return -1;
+
+	all->nr = 0;
+	for (i = 0; i < cfg.contexts; i++) {
+		struct bench_samples *s = (struct bench_samples *)
+			((char *)&ctx_list[i] + offset);
+
+		memcpy(&all->ns[all->nr], s->ns, s->nr * sizeof(u64));
+		all->nr += s->nr;
+	}
+
+	return 0;
+}
+
+static void __report(u64 elapsed_ns, struct ice_os_lock_stats *lock)
+{
+	struct bench_samples all;
+	u64 submitted = 0, completed = 0, failed = 0, backpressure = 0;
+	double elapsed_s = elapsed_ns / 1e9;
+	u32 i;
+
+	for (i = 0; i < cfg.contexts; i++) {
+		submitted += ctx_list[i].submitted;
+		completed += ctx_list[i].completed;
+		failed += ctx_list[i].failed;
+		backpressure += ctx_list[i].backpressure;
+	}
+
+	printf("contexts=%u networks=%u ices=%u depth=%u rate=%u time=%.2fs\n",
+		cfg.contexts, cfg.networks, cfg.ices, cfg.depth, cfg.rate,
+		elapsed_s);
+	printf("submitted=%llu completed=%llu failed=%llu backpressure=%llu\n",
+		(unsigned long long)submitted, (unsigned long long)completed,
+		(unsigned long long)failed, (unsigned long long)backpressure);
+	printf("throughput=%.1f infer/s\n", completed / elapsed_s);
+
+	if (!__merge_samples(&all, offsetof(struct bench_ctx, submit_lat))) {
+		__report_lat("submit", &all);
+		free(all.ns);
+	}
+	if (!__merge_samples(&all, offsetof(struct bench_ctx, compl_lat))) {
+		__report_lat("complete", &all);
+		free(all.ns);
+	}
+
+	printf("biglock acquires=%llu hold avg=%.2fus max=%.1fus busy=%.1f%% wait=%.1fms\n",
+		(unsigned long long)lock->acquire_nr,
+		lock->acquire_nr ?
+			lock->hold_ns / 1000.0 / lock->acquire_nr : 0.0,
+		lock->max_hold_ns / 1000.0,
+		100.0 * lock->hold_ns / elapsed_ns,
+		lock->wait_ns / 1e6);
+}
+
+static int __parse_args(int argc, char **argv)
+{
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:n:i:d:r:t:")) != -1) {
+		u32 val = strtoul(optarg, NULL, 0);
+
+		switch (opt) {
+		case 'c':
+			cfg.contexts = val;
+			break;
+		case 'n':
+			cfg.networks = val;
+			break;
+		case 'i':
+			cfg.ices = val;
+			break;
+		case 'd':
+			cfg.depth = val;
+			break;
+		case 'r':
+			cfg.rate = val;
+			break;
+		case 't':
+			cfg.seconds = val;
+			break;
+		default:
+			return -1;
+		}
+	}
+
+	if (!cfg.contexts || cfg.contexts > BENCH_MAX_CONTEXTS ||
+		!cfg.networks || cfg.networks > BENCH_MAX_NTW ||
+		!cfg.ices || cfg.ices > BENCH_MAX_ICES ||
+		!cfg.depth || cfg.depth > BENCH_MAX_DEPTH || !cfg.seconds)
+		return -1;
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct ice_os_lock_stats lock;
+	u64 start_ns, elapsed_ns;
+	u32 i;
+	int ret = 0;
+
+	if (__parse_args(argc, argv)) {
+		fprintf(stderr, "usage: %s [-c contexts(<=%d)] [-n networks(<=%d)] [-i ices(<=%d)] [-d depth(<=%d)] [-r rate] [-t seconds]\n",
+			argv[0], BENCH_MAX_CONTEXTS, BENCH_MAX_NTW,
+			BENCH_MAX_ICES, BENCH_MAX_DEPTH);
+		return 1;
+	}
+
+	for (i = 0; i < cfg.contexts; i++) {
+		ret = __create_ctx(&ctx_list[i]);
+		if (ret)
+			goto out;
+	}
+
+	ice_os_lock_stats_enable(1);
+	start_ns = __now_ns();
+
+	for (i = 0; i < cfg.contexts; i++) {
+		pthread_create(&ctx_list[i].wait_thread, NULL,
+			__wait_thread, &ctx_list[i]);
+		pthread_create(&ctx_list[i].submit_thread, NULL,
+			__submit_thread, &ctx_list[i]);
+	}
+
+	sleep(cfg.seconds);
+	__atomic_store_n(&stop_submit, 1, __ATOMIC_RELEASE);
+
+	for (i = 0; i < cfg.contexts; i++) {
+		pthread_join(ctx_list[i].submit_thread, NULL);
+		pthread_join(ctx_list[i].wait_thread, NULL);
+	}
+
+	elapsed_ns = __now_ns() - start_ns;
+	ice_os_lock_stats_get(&lock);
+	ice_os_lock_stats_enable(0);
+
+	__report(elapsed_ns, &lock);
+
+out:
+	for (i = 0; i < cfg.contexts; i++)
+		__destroy_ctx(&ctx_list[i]);
+
+	return ret ? 1 : 0;
+}
@@ -20,6 +20,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include "ice_sim.h"
 #else
 #include "dummy_icedc.h"
 #endif
@@ -37,6 +38,13 @@ int write_mmio(uint64_t reg_offset)
 			CVE_MMIO_HUB_NEW_COMMAND_BUFFER_DOOR_BELL_MMOFFSET);
 
 		if ((ice_id >= 0) && (ice_id < MAX_ICE_COUNT)) {
+#ifndef NULL_DEVICE_RING0
+			/* completion is marked when the modeled time is over */
+			if (ice_sim_enabled()) {
+				ice_sim_doorbell(ice_id);
+				return 0;
+			}
+#endif
 			scheduled_ice[ice_id] = 1;
 #ifdef NULL_DEVICE_RING0
 		ret = null_dev_irq(ice_id);
@@ -52,6 +60,7 @@ int read_mmio(uint64_t reg_offset, uint64_t *value)
 {
 	uint64_t ice_interrupt = 0;
 	int i = 0;
+	int status_ice_id = 0;
 	int offset_rem = reg_offset_rem(reg_offset,
 			CVE_MMIO_HUB_INTERRUPT_STATUS_MMOFFSET);
 	int offset_rem2 = reg_offset_rem(reg_offset,
@@ -61,8 +70,10 @@ int read_mmio(uint64_t reg_offset, uint64_t *value)
 		int ice_id = reg_offset_ice(reg_offset,
 			CVE_MMIO_HUB_INTERRUPT_STATUS_MMOFFSET);
 
-		if ((ice_id >= 0) && (ice_id < MAX_ICE_COUNT))
+		if ((ice_id >= 0) && (ice_id < MAX_ICE_COUNT)) {
 			reg_offset = CVE_MMIO_HUB_INTERRUPT_STATUS_MMOFFSET;
+			status_ice_id = ice_id;
+		}
 	} else if (offset_rem2 == 0) {
 		int ice_id2 = reg_offset_ice(reg_offset,
 				ICE_MMIO_GP_RESET_REG_ADDRESS);
@@ -109,7 +120,14 @@ int read_mmio(uint64_t reg_offset, uint64_t *value)
 #ifdef NULL_DEVICE_RING0
 		*value = ice_interrupt << 4;
 #else
-		if (ice_error == NULL) {
+		if (ice_sim_enabled()) {
+			*value = ice_interrupt << 4;
+			/* ICEs whose job failed are also reported as errors */
+			for (i = 0; i < MAX_ICE_COUNT; i++)
+				if ((ice_interrupt & (1ULL << i)) &&
+					ice_sim_ice_status(i) != MMU_COMPLETED)
+					ice_error_interrupt |= (1ULL << i) << 4;
+		} else if (ice_error == NULL) {
 			*value = ice_interrupt << 4;
 		} else {
 			null_device_log("CVE_INTERRUPT_STATUS_VALUE: %s\n",
@@ -139,7 +157,9 @@ int read_mmio(uint64_t reg_offset, uint64_t *value)
 #ifdef NULL_DEVICE_RING0
 			*value = MMU_COMPLETED;
 #else
-		if (ice_error == NULL) {
+		if (ice_sim_enabled()) {
+			*value = ice_sim_ice_status(status_ice_id);
+		} else if (ice_error == NULL) {
 			*value = MMU_COMPLETED;
 		} else {
 			if (strtol(ice_error, NULL, 16) & ICE_INTERRUPT_STATUS_ILLEGAL_MASK) {
@@ -20,6 +20,7 @@
 #include <stdbool.h>
 #include "coral.h"
 #include "dummy_coral.h"
+#include "ice_sim.h"
 #include <unistd.h>
 #include <semaphore.h>
 
@@ -55,6 +56,12 @@ int coral_init_multi(const char *cfg_name,
 	ice_error = getenv("CVE_INTERRUPT_STATUS_VALUE");
 	interrupt_delay = getenv("INTERRUPT_DELAY");
 
+	/* jobs complete from the timing model instead of on trigger */
+	if (ice_sim_init(pfn)) {
+		null_device_log("coral_init successful, ICE timing model\n");
+		return 0;
+	}
+
 	sem_init(&thread_sem, 0, 0);
 	intr_entry = (struct Interrupt_Entry *)malloc
 			(sizeof(struct Interrupt_Entry));
@@ -83,6 +90,9 @@ void coral_trigger_simulation(void)
  * call.If none is scheduled in current call
  * no interrupt is sent.
  */
+	if (ice_sim_enabled())
+		return;
+
 	if (interrupt_delay != NULL) {
 		null_device_log("Requested Interrupt delay: %s milliseconds\n",
 							interrupt_delay);
@@ -121,5 +131,6 @@ int coral_mmio_read_multi_offset(uint64_t reg_offset, uint64_t *value,
 void null_device_fini(void)
 {
 	stop_thread = true;
+	ice_sim_fini();
 }
 
@@ -0,0 +1,315 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2018-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+#include "null_dev.h"
+#include "ice_sim.h"
+
+#define ICE_SIM_LINE_LEN 256
+
+struct ice_sim_profile {
+	uint32_t latency_us;
+	uint32_t jitter_us;
+	uint64_t error_status;
+	uint32_t error_every;
+	bool valid;
+};
+
+struct ice_sim_ice {
+	struct ice_sim_profile profile;
+	/* a job is executing, completes at deadline_ns */
+	bool busy;
+	uint64_t deadline_ns;
+	uint64_t doorbell_ns;
+	/* interrupt status of the last completed job */
+	uint64_t status;
+	/* jitter generator state */
+	uint32_t rand;
+	uint64_t jobs_nr;
+	uint64_t errors_nr;
+	uint64_t busy_ns;
+};
+
+static struct ice_sim_ice sim_ice[MAX_ICE_COUNT];
+static bool sim_enabled;
+static bool sim_stop;
+static ftype_interrupt_handler sim_intr;
+static uint32_t sim_intr_ice_id;
+static pthread_t sim_thread;
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sim_cond;
+
+static uint64_t __now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t __next_rand(uint32_t *state)
+{
+	/* Numerical Recipes LCG, enough for deterministic jitter */
+	*state = *state * 1664525 + 1013904223;
+	return *state >> 8;
+}
+
+static int __parse_profile(const char *path)
+{
+	struct ice_sim_profile def = { 0 };
+	struct ice_sim_profile p;
+	char line[ICE_SIM_LINE_LEN];
+	char ice[16];
+	unsigned long long error_status;
+	int n, i, ice_id, lines_nr = 0;
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (!f) {
+		null_device_log("Cannot open ICE_SIM_PROFILE %s\n", path);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+
+		memset(&p, 0, sizeof(p));
+		error_status = 0;
+		n = sscanf(line, "%15s %u %u %llx %u", ice, &p.latency_us,
+				&p.jitter_us, &error_status, &p.error_every);
+		if (n < 2) {
+			null_device_log("Skipping bad profile line: %s", line);
+			continue;
+		}
+		p.error_status = error_status;
+		if (p.error_status & ICE_INTERRUPT_STATUS_ILLEGAL_MASK) {
+			null_device_log("Invalid error status 0x%llx, ignored\n",
+					error_status);
+			p.error_status = 0;
+		}
+		if (!p.error_status)
+			p.error_every = 0;
+		p.valid = true;
+
+		if (!strcmp(ice, "*")) {
+			def = p;
+		} else {
+			ice_id = atoi(ice);
+			if (ice_id < 0 || ice_id >= MAX_ICE_COUNT) {
+				null_device_log("Skipping bad ICE id: %s\n", ice);
+				continue;
+			}
+			sim_ice[ice_id].profile = p;
+		}
+		lines_nr++;
+	}
+	fclose(f);
+
+	for (i = 0; i < MAX_ICE_COUNT; i++)
+		if (!sim_ice[i].profile.valid)
+			sim_ice[i].profile = def;
+
+	return lines_nr ? 0 : -1;
+}
+
+/* complete the jobs whose time has come, called with sim_lock held */
+static bool __complete_expired(uint64_t now)
+{
+	struct ice_sim_ice *s;
+	bool fired = false;
+	int i;
+
+	for (i = 0; i < MAX_ICE_COUNT; i++) {
+		s = &sim_ice[i];
+		if (!s->busy || s->deadline_ns > now)
+			continue;
+
+		s->busy = false;
+		s->jobs_nr++;
+		s->busy_ns += now - s->doorbell_ns;
+		s->status = MMU_COMPLETED;
+		if (s->profile.error_every &&
+			(s->jobs_nr % s->profile.error_every) == 0) {
+			s->status = s->profile.error_status;
+			s->errors_nr++;
+		}
+		scheduled_ice[i] = 1;
+		fired = true;
+	}
+
+	return fired;
+}
+
+static void *__sim_thread(void *arg)
+{
+	struct timespec ts;
+	uint64_t now, next;
+	int i;
+
+	pthread_mutex_lock(&sim_lock);
+	while (!sim_stop) {
+		next = UINT64_MAX;
+		for (i = 0; i < MAX_ICE_COUNT; i++)
+			if (sim_ice[i].busy && sim_ice[i].deadline_ns < next)
+				next = sim_ice[i].deadline_ns;
+
+		if (next == UINT64_MAX) {
+			pthread_cond_wait(&sim_cond, &sim_lock);
+			continue;
+		}
+
+		now = __now_ns();
+		if (next > now) {
+			ts.tv_sec = next / 1000000000ULL;
+			ts.tv_nsec = next % 1000000000ULL;
+			pthread_cond_timedwait(&sim_cond, &sim_lock, &ts);
+			continue;
+		}
+
+		if (!__complete_expired(now))
+			continue;
+
+		/* the handler dispatches new jobs, which ring doorbells */
+		pthread_mutex_unlock(&sim_lock);
+		sim_intr(0, (void *)&sim_intr_ice_id, NULL);
+		pthread_mutex_lock(&sim_lock);
+	}
+	pthread_mutex_unlock(&sim_lock);
+
+	return NULL;
+}
+
+int ice_sim_init(ftype_interrupt_handler pfn)
+{
+	const char *path = getenv("ICE_SIM_PROFILE");
+	const char *seed_str = getenv("ICE_SIM_SEED");
+	pthread_condattr_t attr;
+	uint32_t seed = 1;
+	int i;
+
+	if (!path)
+		return 0;
+
+	if (__parse_profile(path) != 0) {
+		null_device_log("No usable line in ICE_SIM_PROFILE %s\n", path);
+		return 0;
+	}
+
+	if (seed_str)
+		seed = strtoul(seed_str, NULL, 0);
+	for (i = 0; i < MAX_ICE_COUNT; i++) {
+		sim_ice[i].rand = seed + i;
+		null_device_log("ICE%d latency %uus jitter %uus error 0x%llx every %u\n",
+				i, sim_ice[i].profile.latency_us,
+				sim_ice[i].profile.jitter_us,
+				(unsigned long long)sim_ice[i].profile.error_status,
+				sim_ice[i].profile.error_every);
+	}
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&sim_cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	sim_intr = pfn;
+	sim_stop = false;
+	if (pthread_create(&sim_thread, NULL, &__sim_thread, NULL) != 0) {
+		null_device_log("Failed to start ICE timing model\n");
+		pthread_cond_destroy(&sim_cond);
+		return 0;
+	}
+
+	sim_enabled = true;
+	return 1;
+}
+
+void ice_sim_fini(void)
+{
+	struct ice_sim_ice *s;
+	int i;
+
+	if (!sim_enabled)
+		return;
+
+	pthread_mutex_lock(&sim_lock);
+	sim_stop = true;
+	pthread_cond_signal(&sim_cond);
+	pthread_mutex_unlock(&sim_lock);
+
+	/* fini may run from the handler, i.e. on the simulation thread */
+	if (!pthread_equal(pthread_self(), sim_thread))
+		pthread_join(sim_thread, NULL);
+	else
+		pthread_detach(sim_thread);
+
+	for (i = 0; i < MAX_ICE_COUNT; i++) {
+		s = &sim_ice[i];
+		if (!s->jobs_nr)
+			continue;
+		null_device_log("ICE%d jobs %llu errors %llu avg exec %lluus\n",
+				i, (unsigned long long)s->jobs_nr,
+				(unsigned long long)s->errors_nr,
+				(unsigned long long)(s->busy_ns / s->jobs_nr / 1000));
+	}
+
+	sim_enabled = false;
+}
+
+int ice_sim_enabled(void)
+{
+	return sim_enabled;
+}
+
+void ice_sim_doorbell(int ice_id)
+{
+	struct ice_sim_ice *s = &sim_ice[ice_id];
+	int64_t latency_us;
+	uint32_t span;
+
+	pthread_mutex_lock(&sim_lock);
+
+	latency_us = s->profile.latency_us;
+	if (s->profile.jitter_us) {
+		span = 2 * s->profile.jitter_us + 1;
+		latency_us += (int64_t)(__next_rand(&s->rand) % span) -
+			s->profile.jitter_us;
+		if (latency_us < 0)
+			latency_us = 0;
+	}
+
+	s->doorbell_ns = __now_ns();
+	s->deadline_ns = s->doorbell_ns + (uint64_t)latency_us * 1000;
+	s->busy = true;
+	pthread_cond_signal(&sim_cond);
+
+	pthread_mutex_unlock(&sim_lock);
+}
+
+uint64_t ice_sim_ice_status(int ice_id)
+{
+	uint64_t status;
+
+	pthread_mutex_lock(&sim_lock);
+	status = sim_ice[ice_id].status;
+	pthread_mutex_unlock(&sim_lock);
+
+	return status;
+}
@@ -0,0 +1,66 @@
+/*
+ * NNP-I Linux Driver
+ * Copyright (c) 2018-2019, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+#ifndef _ICE_SIM_H_
+#define _ICE_SIM_H_
+
+#include <stdint.h>
+#include "coral.h"
+
+/*
+ * Timing model of the ICEs, enabled by setting ICE_SIM_PROFILE to a
+ * latency profile file. Each line describes the jobs of one ICE
+ * ('*' for all ICEs not listed), fields after the latency are optional:
+ *
+ *   # ice  latency_us  jitter_us  error_status  error_every
+ *   *      500         50
+ *   3      800         0          0x10          100
+ *
+ * A job completes latency_us +- jitter_us after its doorbell, every ICE
+ * independently. ICEs whose jobs complete together share one interrupt.
+ * Every error_every'th job of an ICE completes with error_status as its
+ * interrupt status. Jitter is pseudo random from ICE_SIM_SEED, so runs
+ * with the same seed and dispatch order see the same latencies.
+ * The device does not know which network a job belongs to, the profile
+ * describes the networks of a run through the ICEs they are placed on.
+ */
+
+/*
+ * read the profile and start the timing model
+ * inputs : pfn - interrupt handler of the driver
+ * returns: 1 if the timing model is used, 0 if ICE_SIM_PROFILE is not set
+ *          or the profile could not be read
+ */
+int ice_sim_init(ftype_interrupt_handler pfn);
+
+/* stop the timing model and log per ICE statistics */
+void ice_sim_fini(void);
+
+/* returns: 1 if the timing model is used */
+int ice_sim_enabled(void);
+
+/*
+ * start the modeled execution of a job on an ICE
+ * inputs : ice_id - ICE whose doorbell was written
+ */
+void ice_sim_doorbell(int ice_id);
+
+/*
+ * interrupt status of the last completed job of an ICE
+ * inputs : ice_id - the ICE
+ * returns: the value of the ICE interrupt status register
+ */
+uint64_t ice_sim_ice_status(int ice_id);
+
+#endif /* _ICE_SIM_H_ */